@@ -0,0 +1,242 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include "CAesIgeCipher.hpp"
+
+#include <string.h>
+
+#include <QDebug>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define AES_IGE_USE_AESNI
+#include <wmmintrin.h>
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+#endif
+
+#ifdef AES_IGE_USE_AESNI
+
+namespace {
+
+// The key expansion follows the Intel AES-NI white paper (AES_256_Key_Expansion).
+AESNI_TARGET inline __m128i expandKeyAssist1(__m128i key, __m128i keygened)
+{
+    keygened = _mm_shuffle_epi32(keygened, 0xff);
+    __m128i temp = _mm_slli_si128(key, 0x4);
+    key = _mm_xor_si128(key, temp);
+    temp = _mm_slli_si128(temp, 0x4);
+    key = _mm_xor_si128(key, temp);
+    temp = _mm_slli_si128(temp, 0x4);
+    key = _mm_xor_si128(key, temp);
+    return _mm_xor_si128(key, keygened);
+}
+
+AESNI_TARGET inline __m128i expandKeyAssist2(__m128i previousKey, __m128i key)
+{
+    const __m128i keygened = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(previousKey, 0x0), 0xaa);
+    __m128i temp = _mm_slli_si128(key, 0x4);
+    key = _mm_xor_si128(key, temp);
+    temp = _mm_slli_si128(temp, 0x4);
+    key = _mm_xor_si128(key, temp);
+    temp = _mm_slli_si128(temp, 0x4);
+    key = _mm_xor_si128(key, temp);
+    return _mm_xor_si128(key, keygened);
+}
+
+#define AES_256_EXPAND_ROUND(index, rcon) \
+    key1 = expandKeyAssist1(key1, _mm_aeskeygenassist_si128(key2, rcon)); \
+    schedule[index] = key1; \
+    if (index < 14) { \
+        key2 = expandKeyAssist2(key1, key2); \
+        schedule[index + 1] = key2; \
+    }
+
+AESNI_TARGET void aesNiExpandKey(const uchar *userKey, __m128i *schedule, bool forDecryption)
+{
+    __m128i key1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(userKey));
+    __m128i key2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(userKey + 16));
+    schedule[0] = key1;
+    schedule[1] = key2;
+
+    AES_256_EXPAND_ROUND(2, 0x01)
+    AES_256_EXPAND_ROUND(4, 0x02)
+    AES_256_EXPAND_ROUND(6, 0x04)
+    AES_256_EXPAND_ROUND(8, 0x08)
+    AES_256_EXPAND_ROUND(10, 0x10)
+    AES_256_EXPAND_ROUND(12, 0x20)
+    AES_256_EXPAND_ROUND(14, 0x40)
+
+    if (!forDecryption) {
+        return;
+    }
+
+    // The Equivalent Inverse Cipher: reversed round keys with InvMixColumns applied to the middle ones.
+    __m128i encryptionSchedule[15];
+    memcpy(encryptionSchedule, schedule, sizeof(encryptionSchedule));
+
+    schedule[0] = encryptionSchedule[14];
+    for (int i = 1; i < 14; ++i) {
+        schedule[i] = _mm_aesimc_si128(encryptionSchedule[14 - i]);
+    }
+    schedule[14] = encryptionSchedule[0];
+}
+
+#undef AES_256_EXPAND_ROUND
+
+AESNI_TARGET void aesNiIgeEncrypt(uchar *data, int size, const __m128i *schedule, uchar *ivec)
+{
+    // ivec: the previous ciphertext block and the previous plaintext block
+    __m128i previousCipher = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ivec));
+    __m128i previousPlain = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ivec + 16));
+
+    for (int offset = 0; offset < size; offset += 16) {
+        __m128i *block = reinterpret_cast<__m128i *>(data + offset);
+        const __m128i plain = _mm_loadu_si128(block);
+
+        __m128i state = _mm_xor_si128(_mm_xor_si128(plain, previousCipher), schedule[0]);
+        for (int round = 1; round < 14; ++round) {
+            state = _mm_aesenc_si128(state, schedule[round]);
+        }
+        state = _mm_aesenclast_si128(state, schedule[14]);
+
+        previousCipher = _mm_xor_si128(state, previousPlain);
+        previousPlain = plain;
+        _mm_storeu_si128(block, previousCipher);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(ivec), previousCipher);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(ivec + 16), previousPlain);
+}
+
+AESNI_TARGET void aesNiIgeDecrypt(uchar *data, int size, const __m128i *schedule, uchar *ivec)
+{
+    __m128i previousCipher = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ivec));
+    __m128i previousPlain = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ivec + 16));
+
+    for (int offset = 0; offset < size; offset += 16) {
+        __m128i *block = reinterpret_cast<__m128i *>(data + offset);
+        const __m128i cipher = _mm_loadu_si128(block);
+
+        __m128i state = _mm_xor_si128(_mm_xor_si128(cipher, previousPlain), schedule[0]);
+        for (int round = 1; round < 14; ++round) {
+            state = _mm_aesdec_si128(state, schedule[round]);
+        }
+        state = _mm_aesdeclast_si128(state, schedule[14]);
+
+        previousPlain = _mm_xor_si128(state, previousCipher);
+        previousCipher = cipher;
+        _mm_storeu_si128(block, previousPlain);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(ivec), previousCipher);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(ivec + 16), previousPlain);
+}
+
+} // anonymous namespace
+
+#endif // AES_IGE_USE_AESNI
+
+CAesIgeCipher::CAesIgeCipher() :
+    m_direction(Encryption),
+    m_valid(false),
+    m_useAesNi(hardwareAccelerated())
+{
+}
+
+CAesIgeCipher::CAesIgeCipher(const SAesKey &key, Direction direction) :
+    m_direction(direction),
+    m_valid(false),
+    m_useAesNi(hardwareAccelerated())
+{
+    setKey(key, direction);
+}
+
+CAesIgeCipher::CAesIgeCipher(const SFixedAesKey &key, Direction direction) :
+    m_direction(direction),
+    m_valid(false),
+    m_useAesNi(hardwareAccelerated())
+{
+    setKey(key, direction);
+}
+
+void CAesIgeCipher::setKey(const SAesKey &key, Direction direction)
+{
+    if ((key.key.size() != 32) || (key.iv.size() != 32)) {
+        qWarning() << Q_FUNC_INFO << "Invalid key or IV size" << key.key.size() << key.iv.size();
+        m_valid = false;
+        return;
+    }
+
+    setKey(reinterpret_cast<const uchar *>(key.key.constData()), reinterpret_cast<const uchar *>(key.iv.constData()), direction);
+}
+
+void CAesIgeCipher::setKey(const uchar *key, const uchar *iv, Direction direction)
+{
+    m_direction = direction;
+    memcpy(m_iv, iv, sizeof(m_iv));
+
+#ifdef AES_IGE_USE_AESNI
+    if (m_useAesNi) {
+        aesNiExpandKey(key, reinterpret_cast<__m128i *>(m_roundKeys), direction == Decryption);
+        m_valid = true;
+        return;
+    }
+#endif
+
+    if (direction == Encryption) {
+        AES_set_encrypt_key(key, 256, &m_key);
+    } else {
+        AES_set_decrypt_key(key, 256, &m_key);
+    }
+
+    m_valid = true;
+}
+
+bool CAesIgeCipher::process(char *data, int size)
+{
+    if (!m_valid || (size % AES_BLOCK_SIZE)) {
+        qWarning() << Q_FUNC_INFO << "Invalid cipher state or data size" << size;
+        return false;
+    }
+
+    uchar *bytes = reinterpret_cast<uchar *>(data);
+
+#ifdef AES_IGE_USE_AESNI
+    if (m_useAesNi) {
+        const __m128i *schedule = reinterpret_cast<const __m128i *>(m_roundKeys);
+        if (m_direction == Encryption) {
+            aesNiIgeEncrypt(bytes, size, schedule, m_iv);
+        } else {
+            aesNiIgeDecrypt(bytes, size, schedule, m_iv);
+        }
+        return true;
+    }
+#endif
+
+    // OpenSSL supports the in-place processing and updates the IV the same way
+    AES_ige_encrypt(bytes, bytes, size, &m_key, m_iv, m_direction == Encryption ? AES_ENCRYPT : AES_DECRYPT);
+    return true;
+}
+
+bool CAesIgeCipher::hardwareAccelerated()
+{
+#ifdef AES_IGE_USE_AESNI
+    static const bool supported = __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse2");
+    return supported;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,66 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#ifndef CAESIGECIPHER_HPP
+#define CAESIGECIPHER_HPP
+
+#include <QtGlobal>
+
+#include <openssl/aes.h>
+
+#include "crypto-aes.hpp"
+
+// AES-256 in the IGE mode, used by MTProto.
+// The key schedule is expanded once per key and the data is processed in place, so there are no allocations
+// on the way. The IGE chaining is sequential, but each block is encrypted with the AES-NI instructions if the CPU has them.
+class CAesIgeCipher
+{
+public:
+    enum Direction {
+        Encryption,
+        Decryption
+    };
+
+    CAesIgeCipher();
+    CAesIgeCipher(const SAesKey &key, Direction direction);
+    CAesIgeCipher(const SFixedAesKey &key, Direction direction);
+
+    // Key and IV must be 32 bytes long
+    void setKey(const SAesKey &key, Direction direction);
+    void setKey(const SFixedAesKey &key, Direction direction) { setKey(key.key, key.iv, direction); }
+    void setKey(const uchar *key, const uchar *iv, Direction direction);
+
+    bool isValid() const { return m_valid; }
+    Direction direction() const { return m_direction; }
+
+    // The size must be divisible by 16 (the AES block size).
+    // The IV is advanced, so the consecutive calls continue the same IGE chain.
+    bool process(char *data, int size);
+
+    static bool hardwareAccelerated();
+
+private:
+    alignas(16) uchar m_roundKeys[15 * 16]; // AES-NI key schedule
+    AES_KEY m_key; // OpenSSL key schedule for the CPUs without AES-NI
+    uchar m_iv[32];
+    Direction m_direction;
+    bool m_valid;
+    bool m_useAesNi;
+
+};
+
+#endif // CAESIGECIPHER_HPP
@@ -0,0 +1,121 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+#include "CAuthKeyGenerator.hpp"
+
+#include "CTelegramConnection.hpp"
+
+#include <QDebug>
+
+CAuthKeyGenerator::CAuthKeyGenerator(const CAppInformation *appInfo, QObject *parent) :
+    QObject(parent),
+    m_appInfo(appInfo),
+    m_deltaTime(0)
+{
+}
+
+CAuthKeyGenerator::~CAuthKeyGenerator()
+{
+    clear();
+}
+
+void CAuthKeyGenerator::generateKey(const TLDcOption &dcInfo)
+{
+    if (m_keys.contains(dcInfo.id)) {
+        return;
+    }
+
+    foreach (CTelegramConnection *connection, m_keyConnections) {
+        if (connection->dcInfo().id == dcInfo.id) {
+            return;
+        }
+    }
+
+    // The handshake math runs in the thread pool, so the connection does not need a thread of its own
+    CTelegramConnection *connection = createKeyConnection(dcInfo);
+    m_keyConnections.append(connection);
+
+    connect(connection, SIGNAL(authStateChanged(int,quint32)), SLOT(onKeyConnectionAuthStateChanged(int)));
+    connect(connection, SIGNAL(statusChanged(int,int,quint32)), SLOT(onKeyConnectionStatusChanged(int)));
+
+    connection->connectToDc();
+}
+
+bool CAuthKeyGenerator::takeKey(quint32 dc, QByteArray *authKey, quint64 *serverSalt)
+{
+    if (!m_keys.contains(dc)) {
+        return false;
+    }
+
+    const QPair<QByteArray, quint64> key = m_keys.take(dc);
+    *authKey = key.first;
+    *serverSalt = key.second;
+    return true;
+}
+
+void CAuthKeyGenerator::clear()
+{
+    while (!m_keyConnections.isEmpty()) {
+        releaseKeyConnection(m_keyConnections.last());
+    }
+
+    m_keys.clear();
+}
+
+void CAuthKeyGenerator::onKeyConnectionAuthStateChanged(int state)
+{
+    CTelegramConnection *connection = qobject_cast<CTelegramConnection *>(sender());
+    if (!connection || (state < CTelegramConnection::AuthStateHaveAKey)) {
+        return;
+    }
+
+    const quint32 dc = connection->dcInfo().id;
+    m_keys.insert(dc, qMakePair(connection->authKey(), connection->serverSalt()));
+    releaseKeyConnection(connection);
+
+    emit keyGenerated(dc);
+}
+
+void CAuthKeyGenerator::onKeyConnectionStatusChanged(int status)
+{
+    CTelegramConnection *connection = qobject_cast<CTelegramConnection *>(sender());
+    if (!connection || (status != CTelegramConnection::ConnectionStatusDisconnected)) {
+        return;
+    }
+
+    // The key is not generated. The next generateKey() call for the DC starts over.
+    qDebug() << Q_FUNC_INFO << "Unable to generate the auth key for dc" << connection->dcInfo().id;
+    releaseKeyConnection(connection);
+}
+
+CTelegramConnection *CAuthKeyGenerator::createKeyConnection(const TLDcOption &dcInfo)
+{
+    CTelegramConnection *connection = new CTelegramConnection(m_appInfo, this);
+    connection->setDcInfo(dcInfo);
+    connection->setTransportOptions(m_transportOptions);
+    connection->setDeltaTime(m_deltaTime);
+
+    return connection;
+}
+
+void CAuthKeyGenerator::releaseKeyConnection(CTelegramConnection *connection)
+{
+    m_keyConnections.removeOne(connection);
+
+    connection->disconnect(this);
+    connection->transport()->disconnectFromHost();
+    connection->deleteLater();
+}
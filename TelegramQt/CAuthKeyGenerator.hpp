@@ -0,0 +1,77 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+#ifndef CAUTHKEYGENERATOR_HPP
+#define CAUTHKEYGENERATOR_HPP
+
+#include <QObject>
+#include <QByteArray>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+
+#include "CTelegramTransport.hpp"
+#include "TLTypes.hpp"
+
+class CAppInformation;
+class CTelegramConnection;
+
+// Generates the auth keys for the DCs ahead of the first request to them.
+// Each key is generated on a short-lived connection, which is closed as soon as the key is ready.
+// Only the key and the server salt are kept, until a connection to the DC takes them.
+class CAuthKeyGenerator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CAuthKeyGenerator(const CAppInformation *appInfo, QObject *parent = 0);
+    ~CAuthKeyGenerator();
+
+    void setTransportOptions(const STransportOptions &options) { m_transportOptions = options; }
+    void setDeltaTime(qint32 deltaTime) { m_deltaTime = deltaTime; }
+
+    // Does nothing if the key for the DC is already generated or in progress
+    void generateKey(const TLDcOption &dcInfo);
+
+    bool hasKey(quint32 dc) const { return m_keys.contains(dc); }
+    // Returns false if there is no key for the DC. The key is removed from the generator.
+    bool takeKey(quint32 dc, QByteArray *authKey, quint64 *serverSalt);
+
+    int pendingCount() const { return m_keyConnections.count(); }
+
+public slots:
+    void clear();
+
+signals:
+    void keyGenerated(quint32 dc);
+
+protected slots:
+    void onKeyConnectionAuthStateChanged(int state);
+    void onKeyConnectionStatusChanged(int status);
+
+protected:
+    virtual CTelegramConnection *createKeyConnection(const TLDcOption &dcInfo);
+    void releaseKeyConnection(CTelegramConnection *connection);
+
+    const CAppInformation *m_appInfo;
+    STransportOptions m_transportOptions;
+    qint32 m_deltaTime;
+
+    QVector<CTelegramConnection *> m_keyConnections;
+    QMap<quint32, QPair<QByteArray, quint64> > m_keys; // dc, <auth key, server salt>
+
+};
+
+#endif // CAUTHKEYGENERATOR_HPP
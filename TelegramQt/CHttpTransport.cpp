@@ -0,0 +1,320 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include "CHttpTransport.hpp"
+
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <QDebug>
+
+static const quint32 s_httpConnectionTimeout = 15 * 1000;
+static const int s_maxResponseHeaderSize = 8 * 1024;
+
+CHttpTransport::CHttpTransport(QObject *parent) :
+    CTelegramTransport(parent),
+    m_pendingRequestCount(0),
+    m_expectedLength(-1),
+    m_statusCode(0),
+    m_socket(new QTcpSocket(this)),
+    m_timeoutTimer(new QTimer(this)),
+    m_flushScheduled(false)
+{
+    connect(m_socket, SIGNAL(stateChanged(QAbstractSocket::SocketState)), SLOT(onStateChanged(QAbstractSocket::SocketState)));
+    connect(m_socket, SIGNAL(error(QAbstractSocket::SocketError)), SLOT(onError(QAbstractSocket::SocketError)));
+    connect(m_socket, SIGNAL(readyRead()), SLOT(onReadyRead()));
+    connect(m_socket, SIGNAL(bytesWritten(qint64)), SLOT(onBytesWritten()));
+
+    m_timeoutTimer->setInterval(s_httpConnectionTimeout);
+    connect(m_timeoutTimer, SIGNAL(timeout()), SLOT(onTimeout()));
+}
+
+CHttpTransport::~CHttpTransport()
+{
+    if (m_socket->isWritable()) {
+        flush();
+        m_socket->waitForBytesWritten(100);
+        m_socket->disconnectFromHost();
+    }
+}
+
+void CHttpTransport::connectToHost(const QString &ipAddress, quint32 port)
+{
+#ifdef DEVELOPER_BUILD
+    qDebug() << Q_FUNC_INFO << ipAddress << port;
+#endif
+    m_host = ipAddress.toLatin1();
+    if (port != 80) {
+        m_host += ':' + QByteArray::number(port);
+    }
+
+    m_socket->connectToHost(ipAddress, port);
+}
+
+void CHttpTransport::disconnectFromHost()
+{
+#ifdef DEVELOPER_BUILD
+    qDebug() << Q_FUNC_INFO;
+#endif
+    flush();
+    m_socket->disconnectFromHost();
+}
+
+bool CHttpTransport::isConnected() const
+{
+    return m_socket && (m_socket->state() == QAbstractSocket::ConnectedState);
+}
+
+qint64 CHttpTransport::bytesToWrite() const
+{
+    return m_socket->bytesToWrite() + m_pendingOutput.size();
+}
+
+char *CHttpTransport::getMutablePackage(int *size)
+{
+    // m_receivedPackage is a raw view over the m_readBuffer
+    *size = m_receivedPackage.size();
+    return const_cast<char *>(m_receivedPackage.constData());
+}
+
+void CHttpTransport::setWriteCoalescingEnabled(bool enabled)
+{
+    if (!enabled) {
+        flush();
+    }
+
+    CTelegramTransport::setWriteCoalescingEnabled(enabled);
+}
+
+void CHttpTransport::setOptions(const STransportOptions &options)
+{
+    CTelegramTransport::setOptions(options);
+    m_options = options;
+
+    m_socket->setReadBufferSize(m_options.readBufferLimit);
+
+    if (isConnected()) {
+        m_socket->setSocketOption(QAbstractSocket::LowDelayOption, m_options.noDelay ? 1 : 0);
+        m_socket->setSocketOption(QAbstractSocket::KeepAliveOption, m_options.keepAlive ? 1 : 0);
+    }
+}
+
+void CHttpTransport::sendPackage(const QByteArray &payload)
+{
+    // The payload is sent as is, without any framing. The HTTP message length is the only delimiter.
+    QByteArray request;
+    request.reserve(160 + m_host.size() + payload.size());
+    request.append("POST /api HTTP/1.1\r\nHost: ");
+    request.append(m_host);
+    request.append("\r\nConnection: keep-alive\r\nContent-Type: application/octet-stream\r\nContent-Length: ");
+    request.append(QByteArray::number(payload.size()));
+    request.append("\r\n\r\n");
+    request.append(payload);
+
+    ++m_pendingRequestCount;
+
+    if (packageCaptureEnabled()) {
+        m_lastPackage = request;
+    }
+
+    if (writeCoalescingEnabled()) {
+        if (!m_flushScheduled) {
+            m_flushScheduled = true;
+            QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+        }
+
+        m_pendingOutput.append(request);
+        updateSendBufferState();
+        return;
+    }
+
+    m_socket->write(request);
+
+    updateSendBufferState();
+}
+
+void CHttpTransport::flush()
+{
+    m_flushScheduled = false;
+
+    if (m_pendingOutput.isEmpty()) {
+        return;
+    }
+
+    m_socket->write(m_pendingOutput);
+    m_socket->flush();
+
+    m_pendingOutput.resize(0); // Keeps the reserved capacity
+}
+
+void CHttpTransport::onStateChanged(QAbstractSocket::SocketState newState)
+{
+    switch (newState) {
+    case QAbstractSocket::ConnectedState:
+        m_pendingRequestCount = 0;
+        m_expectedLength = -1;
+        m_statusCode = 0;
+        m_readBuffer.clear();
+        m_receivedPackage.clear();
+        m_pendingOutput.resize(0);
+        m_socket->setSocketOption(QAbstractSocket::LowDelayOption, m_options.noDelay ? 1 : 0);
+        m_socket->setSocketOption(QAbstractSocket::KeepAliveOption, m_options.keepAlive ? 1 : 0);
+        resetSendBufferState();
+        break;
+    case QAbstractSocket::UnconnectedState:
+        resetSendBufferState();
+        break;
+    default:
+        break;
+    }
+
+    switch (newState) {
+    case QAbstractSocket::ConnectingState:
+    case QAbstractSocket::HostLookupState:
+        m_timeoutTimer->start();
+        break;
+    default:
+        m_timeoutTimer->stop();
+        break;
+    }
+
+    setState(newState);
+}
+
+void CHttpTransport::onError(QAbstractSocket::SocketError error)
+{
+    setError(error);
+}
+
+void CHttpTransport::onReadyRead()
+{
+    m_readBuffer.append(m_socket->readAll());
+
+    int position = 0;
+
+    while (position < m_readBuffer.size()) {
+        if (m_expectedLength < 0) {
+            const int headerEnd = m_readBuffer.indexOf("\r\n\r\n", position);
+            if (headerEnd < 0) {
+                if (m_readBuffer.size() - position > s_maxResponseHeaderSize) {
+                    qWarning() << Q_FUNC_INFO << "The response header is too big";
+                    m_readBuffer.clear();
+                    m_socket->disconnectFromHost();
+                    return;
+                }
+                break;
+            }
+
+            if (!readResponseHeader(m_readBuffer.constData() + position, headerEnd - position)) {
+                m_readBuffer.clear();
+                m_expectedLength = -1;
+                m_socket->disconnectFromHost();
+                return;
+            }
+
+            position = headerEnd + 4;
+            continue;
+        }
+
+        if (m_readBuffer.size() - position < m_expectedLength) {
+            break;
+        }
+
+        m_receivedPackage = QByteArray::fromRawData(m_readBuffer.constData() + position, m_expectedLength);
+        position += m_expectedLength;
+        m_expectedLength = -1;
+
+        if (m_statusCode != 200) {
+            // The server reports transport errors (e.g. an unknown auth key) with a non-200 status.
+            // The pending requests would never be answered, so the connection is dropped, like a TCP framing error.
+            qWarning() << Q_FUNC_INFO << "Unexpected response with status" << m_statusCode << m_receivedPackage.toHex();
+            m_receivedPackage.clear();
+            m_readBuffer.clear();
+            m_pendingRequestCount = 0;
+            m_socket->disconnectFromHost();
+            return;
+        }
+
+        if (m_pendingRequestCount) {
+            --m_pendingRequestCount;
+        }
+
+        if (!m_receivedPackage.isEmpty()) {
+            emit readyRead();
+        }
+    }
+
+    m_receivedPackage.clear();
+    m_readBuffer.remove(0, position);
+}
+
+void CHttpTransport::onBytesWritten()
+{
+    updateSendBufferState();
+}
+
+void CHttpTransport::onTimeout()
+{
+#ifdef DEVELOPER_BUILD
+    qDebug() << Q_FUNC_INFO << "(connection to " << m_socket->peerName() << m_socket->peerPort() << ").";
+#endif
+
+    emit timeout();
+
+    m_socket->disconnectFromHost();
+}
+
+// Sets m_statusCode and m_expectedLength. Returns false if the response can not be processed.
+bool CHttpTransport::readResponseHeader(const char *data, int size)
+{
+    const QList<QByteArray> lines = QByteArray::fromRawData(data, size).split('\n');
+
+    const QList<QByteArray> statusLine = lines.first().trimmed().split(' ');
+    if ((statusLine.count() < 2) || !statusLine.first().startsWith("HTTP/1.")) {
+        qWarning() << Q_FUNC_INFO << "Invalid status line" << lines.first();
+        return false;
+    }
+
+    m_statusCode = statusLine.at(1).toInt();
+    m_expectedLength = 0;
+
+    for (int i = 1; i < lines.count(); ++i) {
+        const QByteArray &line = lines.at(i);
+        const int colonIndex = line.indexOf(':');
+
+        if (colonIndex < 0) {
+            continue;
+        }
+
+        const QByteArray name = line.left(colonIndex).trimmed().toLower();
+        const QByteArray value = line.mid(colonIndex + 1).trimmed();
+
+        if (name == "content-length") {
+            bool ok;
+            m_expectedLength = value.toInt(&ok);
+            if (!ok || (m_expectedLength < 0)) {
+                qWarning() << Q_FUNC_INFO << "Invalid content length" << value;
+                return false;
+            }
+        } else if ((name == "transfer-encoding") && (value.toLower() != "identity")) {
+            qWarning() << Q_FUNC_INFO << "Unsupported transfer encoding" << value;
+            return false;
+        }
+    }
+
+    return true;
+}
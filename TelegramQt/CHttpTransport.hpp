@@ -0,0 +1,92 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#ifndef CHTTPTRANSPORT_HPP
+#define CHTTPTRANSPORT_HPP
+
+#include "CTelegramTransport.hpp"
+
+QT_BEGIN_NAMESPACE
+class QTcpSocket;
+class QTimer;
+QT_END_NAMESPACE
+
+// MTProto over HTTP/1.1. Each package is sent as a POST request over a keep-alive connection.
+// Requests are pipelined: a new request is written without waiting for the answers to the previous ones.
+// The server sends data only in answer to a request, so there is no server-initiated traffic between the requests.
+class CHttpTransport : public CTelegramTransport
+{
+    Q_OBJECT
+public:
+    explicit CHttpTransport(QObject *parent = 0);
+    ~CHttpTransport();
+
+    void connectToHost(const QString &ipAddress, quint32 port) override;
+    void disconnectFromHost() override;
+
+    bool isConnected() const override;
+
+    void setWriteCoalescingEnabled(bool enabled) override;
+    void setOptions(const STransportOptions &options) override;
+
+    qint64 bytesToWrite() const override;
+
+    // The returned array does not own the data. It is valid only within readyRead() handlers.
+    QByteArray getPackage() override { return m_receivedPackage; }
+    // The receive buffer is never shared, so the package can be modified in place.
+    char *getMutablePackage(int *size) override;
+
+    // Number of the sent requests, which are not answered yet
+    int pendingRequestCount() const { return m_pendingRequestCount; }
+
+    // Method for testing
+    QByteArray lastPackage() const override { return m_lastPackage; }
+
+public slots:
+    void sendPackage(const QByteArray &payload) override;
+    void flush() override;
+
+private slots:
+    void onStateChanged(QAbstractSocket::SocketState newState);
+    void onError(QAbstractSocket::SocketError error);
+    void onReadyRead();
+    void onBytesWritten();
+    void onTimeout();
+
+private:
+    bool readResponseHeader(const char *data, int size);
+
+    QByteArray m_host; // Value of the Host header
+    int m_pendingRequestCount;
+
+    QByteArray m_readBuffer;
+    int m_expectedLength; // Length of the current response body or -1, if the header is not received yet
+    int m_statusCode;
+
+    QByteArray m_receivedPackage; // Raw view over the m_readBuffer
+    QByteArray m_lastPackage; // Filled only if the package capture is enabled
+    QByteArray m_pendingOutput; // Requests waiting for the coalesced write
+
+    STransportOptions m_options;
+    QTcpSocket *m_socket;
+    QTimer *m_timeoutTimer;
+
+    bool m_flushScheduled;
+
+};
+
+#endif // CHTTPTRANSPORT_HPP
@@ -0,0 +1,148 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include "CLoopbackTransport.hpp"
+
+#include <QDebug>
+
+CLoopbackTransport::CLoopbackTransport(QObject *parent) :
+    CTelegramTransport(parent)
+{
+}
+
+CLoopbackTransport::~CLoopbackTransport()
+{
+    if (isConnected()) {
+        emit disconnectedFromPeer();
+    }
+}
+
+void CLoopbackTransport::link(CLoopbackTransport *first, CLoopbackTransport *second)
+{
+    first->m_peer = second;
+    second->m_peer = first;
+
+    // Queued even within one thread, so a package is never processed in the middle of the sender code
+    const CLoopbackTransport *transports[2] = { first, second };
+    for (int i = 0; i < 2; ++i) {
+        const CLoopbackTransport *sender = transports[i];
+        const CLoopbackTransport *receiver = transports[1 - i];
+        connect(sender, SIGNAL(packageSent(QByteArray)), receiver, SLOT(onPackageReceived(QByteArray)), Qt::QueuedConnection);
+        connect(sender, SIGNAL(connectionRequested()), receiver, SLOT(onConnectionRequested()), Qt::QueuedConnection);
+        connect(sender, SIGNAL(connectionAccepted()), receiver, SLOT(onConnectionAccepted()), Qt::QueuedConnection);
+        connect(sender, SIGNAL(disconnectedFromPeer()), receiver, SLOT(onPeerDisconnected()), Qt::QueuedConnection);
+    }
+}
+
+void CLoopbackTransport::connectToHost(const QString &ipAddress, quint32 port)
+{
+#ifdef DEVELOPER_BUILD
+    qDebug() << Q_FUNC_INFO << ipAddress << port;
+#else
+    Q_UNUSED(ipAddress)
+    Q_UNUSED(port)
+#endif
+
+    if (state() != QAbstractSocket::UnconnectedState) {
+        return;
+    }
+
+    setState(QAbstractSocket::ConnectingState);
+
+    if (!m_peer) {
+        setError(QAbstractSocket::ConnectionRefusedError);
+        setState(QAbstractSocket::UnconnectedState);
+        return;
+    }
+
+    // The peer becomes connected first, so it is ready to process our first package.
+    emit connectionRequested();
+}
+
+void CLoopbackTransport::disconnectFromHost()
+{
+#ifdef DEVELOPER_BUILD
+    qDebug() << Q_FUNC_INFO;
+#endif
+
+    if (state() == QAbstractSocket::UnconnectedState) {
+        return;
+    }
+
+    emit disconnectedFromPeer();
+
+    onPeerDisconnected();
+}
+
+bool CLoopbackTransport::isConnected() const
+{
+    return state() == QAbstractSocket::ConnectedState;
+}
+
+void CLoopbackTransport::sendPackage(const QByteArray &package)
+{
+    if (!isConnected() || !m_peer) {
+        qDebug() << Q_FUNC_INFO << "Unable to send the package: transport is not connected.";
+        return;
+    }
+
+    if (packageCaptureEnabled()) {
+        m_lastPackage = package;
+    }
+
+    emit packageSent(package);
+}
+
+void CLoopbackTransport::onConnectionRequested()
+{
+    if (state() != QAbstractSocket::ConnectedState) {
+        setState(QAbstractSocket::ConnectedState);
+    }
+
+    emit connectionAccepted();
+}
+
+void CLoopbackTransport::onConnectionAccepted()
+{
+    if (state() != QAbstractSocket::ConnectingState) {
+        return;
+    }
+
+    setState(QAbstractSocket::ConnectedState);
+}
+
+void CLoopbackTransport::onPeerDisconnected()
+{
+    if (state() == QAbstractSocket::UnconnectedState) {
+        return;
+    }
+
+    m_receivedPackage.clear();
+
+    setState(QAbstractSocket::UnconnectedState);
+}
+
+void CLoopbackTransport::onPackageReceived(const QByteArray &package)
+{
+    if (!isConnected()) {
+        return;
+    }
+
+    m_receivedPackage = package;
+    emit readyRead();
+    m_receivedPackage.clear();
+}
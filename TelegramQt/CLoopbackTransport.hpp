@@ -0,0 +1,74 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#ifndef CLOOPBACKTRANSPORT_HPP
+#define CLOOPBACKTRANSPORT_HPP
+
+#include "CTelegramTransport.hpp"
+
+#include <QPointer>
+
+// In-memory transport. Packages sent by one transport are delivered to its peer
+// on the next event loop iteration of the peer thread, without any framing.
+// The peers talk only through queued signals, so they can live in different threads.
+class CLoopbackTransport : public CTelegramTransport
+{
+    Q_OBJECT
+public:
+    explicit CLoopbackTransport(QObject *parent = 0);
+    ~CLoopbackTransport();
+
+    // Makes the transports peers of each other. Any of them can then connect to another one.
+    static void link(CLoopbackTransport *first, CLoopbackTransport *second);
+
+    CLoopbackTransport *peer() const { return m_peer; }
+
+    void connectToHost(const QString &ipAddress, quint32 port) override;
+    void disconnectFromHost() override;
+
+    bool isConnected() const override;
+
+    QByteArray getPackage() override { return m_receivedPackage; }
+
+    // Method for testing
+    QByteArray lastPackage() const override { return m_lastPackage; }
+
+public slots:
+    void sendPackage(const QByteArray &package) override;
+
+signals:
+    // Peer notifications
+    void packageSent(const QByteArray &package);
+    void connectionRequested();
+    void connectionAccepted();
+    void disconnectedFromPeer();
+
+private slots:
+    void onConnectionRequested();
+    void onConnectionAccepted();
+    void onPeerDisconnected();
+    void onPackageReceived(const QByteArray &package);
+
+private:
+    QPointer<CLoopbackTransport> m_peer; // Only checked, never dereferenced from this thread
+
+    QByteArray m_receivedPackage;
+    QByteArray m_lastPackage; // Filled only if the package capture is enabled
+
+};
+
+#endif // CLOOPBACKTRANSPORT_HPP
@@ -18,7 +18,6 @@
 #include "CRawStream.hpp"
 
 #include <QIODevice>
-#include <QBuffer>
 
 static const char s_nulls[4] = { 0, 0, 0, 0 };
 
@@ -29,51 +28,60 @@ template CRawStream &CRawStream::operator<<(const TLNumber128 &v);
 template CRawStream &CRawStream::operator<<(const TLNumber256 &v);
 
 CRawStream::CRawStream(QByteArray *data, bool write) :
-    m_device(new QBuffer(data)),
-    m_ownDevice(true),
+    m_device(0),
+    m_output(0),
+    m_inputData(0),
+    m_inputSize(0),
+    m_inputPosition(0),
     m_error(false)
 {
     if (write) {
-        m_device->open(QIODevice::Append);
+        m_output = data;
     } else {
-        m_device->open(QIODevice::ReadOnly);
+        m_input = *data;
+        m_inputData = m_input.constData();
+        m_inputSize = m_input.size();
     }
 }
 
 CRawStream::CRawStream(const QByteArray &data) :
     m_device(0),
-    m_ownDevice(true),
+    m_input(data),
+    m_output(0),
+    m_inputData(m_input.constData()),
+    m_inputSize(m_input.size()),
+    m_inputPosition(0),
     m_error(false)
 {
-    QBuffer *buffer = new QBuffer();
-    buffer->setData(data);
-    m_device = buffer;
+}
 
-    m_device->open(QIODevice::ReadOnly);
+CRawStream::CRawStream(const char *data, int size) :
+    m_device(0),
+    m_output(0),
+    m_inputData(data),
+    m_inputSize(size),
+    m_inputPosition(0),
+    m_error(false)
+{
 }
 
 CRawStream::CRawStream(QIODevice *d) :
     m_device(d),
-    m_ownDevice(false),
+    m_output(0),
+    m_inputData(0),
+    m_inputSize(0),
+    m_inputPosition(0),
     m_error(false)
 {
 }
 
 CRawStream::~CRawStream()
 {
-    if (m_device && m_ownDevice) {
-        delete m_device;
-    }
 }
 
 void CRawStream::setDevice(QIODevice *newDevice)
 {
-    if (m_device) {
-        if (m_ownDevice) {
-            delete m_device;
-        }
-    }
-
+    resetSpan();
     m_device = newDevice;
 }
 
@@ -84,85 +92,82 @@ void CRawStream::unsetDevice()
 
 bool CRawStream::atEnd() const
 {
-    return m_device ? m_device->atEnd() : true;
+    if (m_device) {
+        return m_device->atEnd();
+    }
+
+    return m_inputPosition >= m_inputSize;
 }
 
 int CRawStream::bytesRemaining() const
 {
-    return m_device->bytesAvailable();
+    if (m_device) {
+        return m_device->bytesAvailable();
+    }
+
+    return m_inputSize - m_inputPosition;
 }
 
-bool CRawStream::read(void *data, qint64 size)
+bool CRawStream::deviceRead(void *data, qint64 size)
 {
     m_error = m_error || m_device->read((char *) data, size) != size;
     return m_error;
 }
 
-bool CRawStream::write(const void *data, qint64 size)
+bool CRawStream::deviceWrite(const void *data, qint64 size)
 {
     m_error = m_error || m_device->write((const char *) data, size) != size;
     return m_error;
 }
 
-QByteArray CRawStream::readBytes(int count)
-{
-    QByteArray result = m_device->read(count);
-    m_error = m_error || result.size() != count;
-    return result;
-}
-
-CRawStream &CRawStream::operator>>(qint8 &i)
-{
-    return protectedRead(i);
-}
-
-CRawStream &CRawStream::operator>>(qint16 &i)
+void CRawStream::spanRead(void *data, qint64 size)
 {
-    return protectedRead(i);
-}
-
-CRawStream &CRawStream::operator>>(qint32 &i)
-{
-    return protectedRead(i);
-}
+    // Out of bounds: read what is left (as QIODevice does) and set the error
+    const int available = m_inputSize - m_inputPosition;
+    if (available > 0) {
+        memcpy(data, m_inputData + m_inputPosition, available);
+    }
 
-CRawStream &CRawStream::operator>>(qint64 &i)
-{
-    return protectedRead(i);
+    m_inputPosition = m_inputSize;
+    m_error = true;
 }
 
-template<typename Int>
-CRawStream &CRawStream::protectedRead(Int &i)
+void CRawStream::resetSpan()
 {
-    read(&i, sizeof(Int));
-    return *this;
+    m_input.clear();
+    m_output = 0;
+    m_inputData = 0;
+    m_inputSize = 0;
+    m_inputPosition = 0;
 }
 
-CRawStream &CRawStream::operator<<(qint8 i)
+QByteArray CRawStream::readBytes(int count)
 {
-    return protectedWrite(i);
-}
+    if (m_device) {
+        QByteArray result = m_device->read(count);
+        m_error = m_error || result.size() != count;
+        return result;
+    }
 
-CRawStream &CRawStream::operator<<(qint16 i)
-{
-    return protectedWrite(i);
-}
+    if (count > m_inputSize - m_inputPosition) {
+        count = m_inputSize - m_inputPosition;
+        m_error = true;
+    }
 
-CRawStream &CRawStream::operator<<(qint32 i)
-{
-    return protectedWrite(i);
-}
+    if (count <= 0) {
+        return QByteArray();
+    }
 
-CRawStream &CRawStream::operator<<(qint64 i)
-{
-    return protectedWrite(i);
-}
+    // The whole input is shared instead of copied. A fromRawData() array does not own the data
+    // (its capacity is zero), so it is copied, otherwise the result would outlive the source buffer.
+    if ((count == m_inputSize) && (m_inputData == m_input.constData()) && (m_input.capacity() > 0)) {
+        m_inputPosition = m_inputSize;
+        return m_input;
+    }
 
-template<typename Int>
-CRawStream &CRawStream::protectedWrite(Int i)
-{
-    write(&i, sizeof(Int));
-    return *this;
+    QByteArray result(m_inputData + m_inputPosition, count);
+    m_inputPosition += count;
+    return result;
 }
 
 CRawStream &CRawStream::operator>>(double &d)
@@ -179,7 +184,13 @@ CRawStream &CRawStream::operator<<(const double &d)
 
 CRawStream &CRawStream::operator<<(const QByteArray &data)
 {
-    m_error = m_error || m_device->write(data) != data.size();
+    if (m_device) {
+        m_error = m_error || m_device->write(data) != data.size();
+    } else if (m_output) {
+        m_output->append(data);
+    } else {
+        m_error = true;
+    }
 
     return *this;
 }
@@ -21,6 +21,9 @@
 #include <qglobal.h>
 
 #include <QByteArray>
+#include <QtEndian>
+
+#include <string.h>
 
 #include "TLNumbers.hpp"
 #include "TLValues.hpp"
@@ -29,11 +32,18 @@ QT_BEGIN_NAMESPACE
 class QIODevice;
 QT_END_NAMESPACE
 
+// The stream works either on a QIODevice or directly on a memory span.
+// The memory mode is used by the QByteArray and span constructors: the read
+// side reads from a pointer/length span and the write side appends to the
+// QByteArray, so the fixed size values go through inline little-endian paths
+// without the QBuffer indirection.
 class CRawStream
 {
 public:
     explicit CRawStream(QByteArray *data, bool write);
     explicit CRawStream(const QByteArray &data);
+    // The data is not copied and should outlive the stream
+    explicit CRawStream(const char *data, int size);
 
     explicit CRawStream(QIODevice *d = 0);
 
@@ -88,8 +98,8 @@ public:
     CRawStream &operator<<(const QByteArray &data);
 
 protected:
-    bool read(void *data, qint64 size);
-    bool write(const void *data, qint64 size);
+    inline bool read(void *data, qint64 size);
+    inline bool write(const void *data, qint64 size);
 
     template<typename Int>
     inline CRawStream &protectedWrite(Int i);
@@ -98,8 +108,20 @@ protected:
     inline CRawStream &protectedRead(Int &i);
 
 private:
+    bool deviceRead(void *data, qint64 size);
+    bool deviceWrite(const void *data, qint64 size);
+    void spanRead(void *data, qint64 size);
+    void resetSpan();
+
     QIODevice *m_device;
-    bool m_ownDevice;
+
+    // Memory mode
+    QByteArray m_input; // Keeps the input span alive
+    QByteArray *m_output;
+    const char *m_inputData;
+    int m_inputSize;
+    int m_inputPosition;
+
     bool m_error;
 
 };
@@ -115,6 +137,10 @@ public:
         CRawStream(data)
     {
     }
+    explicit CRawStreamEx(const char *data, int size) :
+        CRawStream(data, size)
+    {
+    }
 
     explicit CRawStreamEx(QIODevice *d = 0) :
         CRawStream(d)
@@ -139,6 +165,80 @@ inline QByteArray CRawStream::readRemainingBytes()
     return readBytes(bytesRemaining());
 }
 
+inline bool CRawStream::read(void *data, qint64 size)
+{
+    if (m_device) {
+        return deviceRead(data, size);
+    }
+
+    if (size <= m_inputSize - m_inputPosition) {
+        memcpy(data, m_inputData + m_inputPosition, size);
+        m_inputPosition += size;
+    } else {
+        spanRead(data, size);
+    }
+
+    return m_error;
+}
+
+inline bool CRawStream::write(const void *data, qint64 size)
+{
+    if (m_device) {
+        return deviceWrite(data, size);
+    }
+
+    if (m_output) {
+        m_output->append(static_cast<const char *>(data), size);
+    } else {
+        m_error = true;
+    }
+
+    return m_error;
+}
+
+template<typename Int>
+inline CRawStream &CRawStream::protectedRead(Int &i)
+{
+    if (!m_device && (sizeof(Int) <= uint(m_inputSize - m_inputPosition))) {
+        i = qFromLittleEndian<Int>(reinterpret_cast<const uchar *>(m_inputData + m_inputPosition));
+        m_inputPosition += sizeof(Int);
+        return *this;
+    }
+
+    Int value = 0;
+    read(&value, sizeof(Int));
+    i = qFromLittleEndian(value);
+    return *this;
+}
+
+template<typename Int>
+inline CRawStream &CRawStream::protectedWrite(Int i)
+{
+    const Int value = qToLittleEndian(i);
+    write(&value, sizeof(Int));
+    return *this;
+}
+
+inline CRawStream &CRawStream::operator>>(qint8 &i)
+{
+    return protectedRead(i);
+}
+
+inline CRawStream &CRawStream::operator>>(qint16 &i)
+{
+    return protectedRead(i);
+}
+
+inline CRawStream &CRawStream::operator>>(qint32 &i)
+{
+    return protectedRead(i);
+}
+
+inline CRawStream &CRawStream::operator>>(qint64 &i)
+{
+    return protectedRead(i);
+}
+
 inline CRawStream &CRawStream::operator>>(quint8 &i)
 {
     return *this >> reinterpret_cast<qint8&>(i);
@@ -174,6 +274,26 @@ inline CRawStream &CRawStream::operator>>(TLValue &v)
     return *this;
 }
 
+inline CRawStream &CRawStream::operator<<(qint8 i)
+{
+    return protectedWrite(i);
+}
+
+inline CRawStream &CRawStream::operator<<(qint16 i)
+{
+    return protectedWrite(i);
+}
+
+inline CRawStream &CRawStream::operator<<(qint32 i)
+{
+    return protectedWrite(i);
+}
+
+inline CRawStream &CRawStream::operator<<(qint64 i)
+{
+    return protectedWrite(i);
+}
+
 inline CRawStream &CRawStream::operator<<(quint8 i)
 {
     return *this << qint8(i);
@@ -17,22 +17,43 @@
 
 #include "CTcpTransport.hpp"
 
+#include "Utils.hpp"
+
+#include <QHostAddress>
 #include <QTcpSocket>
 #include <QTimer>
+#include <QtEndian>
 
 #include <QDebug>
 
+#ifdef Q_OS_LINUX
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
 static const quint32 tcpTimeout = 15 * 1000;
+static const int s_initialReadBufferSize = 64 * 1024;
+static const quint32 s_maxPackageLength = 0xffffff * 4; // The abridged framing limit
 
 CTcpTransport::CTcpTransport(QObject *parent) :
     CTelegramTransport(parent),
+    m_activeFraming(STransportOptions::FramingAbridged),
+    m_packetNumber(0),
+    m_receivedPacketNumber(0),
+    m_receivedCrc(0),
+    m_expectedLength(0),
+    m_readBufferBegin(0),
+    m_readBufferEnd(0),
     m_socket(new QTcpSocket(this)),
     m_timeoutTimer(new QTimer(this)),
-    m_firstPackage(true)
+    m_firstPackage(true),
+    m_flushScheduled(false)
 {
     connect(m_socket, SIGNAL(stateChanged(QAbstractSocket::SocketState)), SLOT(onStateChanged(QAbstractSocket::SocketState)));
     connect(m_socket, SIGNAL(error(QAbstractSocket::SocketError)), SLOT(onError(QAbstractSocket::SocketError)));
     connect(m_socket, SIGNAL(readyRead()), SLOT(onReadyRead()));
+    connect(m_socket, SIGNAL(bytesWritten(qint64)), SLOT(onBytesWritten()));
 
     m_timeoutTimer->setInterval(tcpTimeout);
     connect(m_timeoutTimer, SIGNAL(timeout()), SLOT(onTimeout()));
@@ -41,6 +62,7 @@ CTcpTransport::CTcpTransport(QObject *parent) :
 CTcpTransport::~CTcpTransport()
 {
     if (m_socket->isWritable()) {
+        flush();
         m_socket->waitForBytesWritten(100);
         m_socket->disconnectFromHost();
     }
@@ -51,6 +73,26 @@ void CTcpTransport::connectToHost(const QString &ipAddress, quint32 port)
 #ifdef DEVELOPER_BUILD
     qDebug() << Q_FUNC_INFO << ipAddress << port;
 #endif
+
+    if (m_options.sendBufferSize || m_options.receiveBufferSize) {
+        // The buffer sizes must be set before the handshake, which negotiates the TCP window scale.
+        // The options can be set only on an opened socket, and the bound one is reused by connectToHost().
+        const QHostAddress address(ipAddress);
+        const QHostAddress anyAddress = address.protocol() == QAbstractSocket::IPv6Protocol ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4;
+
+        if (m_socket->bind(anyAddress)) {
+            if (m_options.sendBufferSize) {
+                m_socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, m_options.sendBufferSize);
+            }
+
+            if (m_options.receiveBufferSize) {
+                m_socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, m_options.receiveBufferSize);
+            }
+        } else {
+            qWarning() << Q_FUNC_INFO << "Unable to apply the socket buffer sizes:" << m_socket->errorString();
+        }
+    }
+
     m_socket->connectToHost(ipAddress, port);
 }
 
@@ -59,6 +101,7 @@ void CTcpTransport::disconnectFromHost()
 #ifdef DEVELOPER_BUILD
     qDebug() << Q_FUNC_INFO;
 #endif
+    flush();
     m_socket->disconnectFromHost();
 }
 
@@ -67,40 +110,163 @@ bool CTcpTransport::isConnected() const
     return m_socket && (m_socket->state() == QAbstractSocket::ConnectedState);
 }
 
+QVariant CTcpTransport::socketOption(QAbstractSocket::SocketOption option) const
+{
+    return m_socket->socketOption(option);
+}
+
+qint64 CTcpTransport::bytesToWrite() const
+{
+    return m_socket->bytesToWrite() + m_pendingOutput.size();
+}
+
+char *CTcpTransport::getMutablePackage(int *size)
+{
+    // m_receivedPackage is a raw view over the m_readBuffer
+    *size = m_receivedPackage.size();
+    return const_cast<char *>(m_receivedPackage.constData());
+}
+
+void CTcpTransport::setWriteCoalescingEnabled(bool enabled)
+{
+    if (!enabled) {
+        flush();
+    }
+
+    CTelegramTransport::setWriteCoalescingEnabled(enabled);
+}
+
+void CTcpTransport::setOptions(const STransportOptions &options)
+{
+    CTelegramTransport::setOptions(options);
+    m_options = options;
+
+    m_socket->setReadBufferSize(m_options.readBufferLimit);
+
+    if (isConnected()) {
+        applySocketOptions();
+    }
+}
+
 void CTcpTransport::sendPackage(const QByteArray &payload)
 {
+    // Full version:
     // quint32 length (included length itself + packet number + crc32 + payload // Length MUST be divisible by 4
     // quint32 packet number
+    // Payload
     // quint32 CRC32 (length, quint32 packet number, payload)
+
+    // Intermediate version:
+    // quint32: 0xeeeeeeee (only in the first package)
+    // quint32: Payload length
     // Payload
 
     // Abridged version:
-    // quint8: 0xef
+    // quint8: 0xef (only in the first package)
     // DataLength / 4 < 0x7f ?
     //      (quint8: Packet length / 4) :
     //      (quint8: 0x7f, quint24: Packet length / 4)
     // Payload
 
-    QByteArray package;
+    // Header and payload are written as separate segments to avoid a concatenated copy of the payload.
+    char header[8];
+    int headerLength = 0;
+    char trailer[4];
+    int trailerLength = 0;
+
     if (m_firstPackage) {
-        package.append(char(0xef)); // Start session in Abridged format
-        m_firstPackage = false;
+        m_activeFraming = framing();
     }
 
     if (payload.length() % 4) {
         qCritical() << Q_FUNC_INFO << "Invalid outgoing package! The payload size is not divisible by four!";
     }
 
-    quint32 length = payload.length() / 4;
-    if (length < 0x7f) {
-        package.append(char(length));
-    } else {
-        package.append(char(0x7f));
-        package.append(reinterpret_cast<const char *>(&length), 3);
+    switch (m_activeFraming) {
+    case STransportOptions::FramingAbridged:
+    {
+        if (m_firstPackage) {
+            header[headerLength++] = char(0xef); // Start session in Abridged format
+        }
+
+        const quint32 length = payload.length() / 4;
+        if (length < 0x7f) {
+            header[headerLength++] = char(length);
+        } else {
+            header[headerLength++] = char(0x7f);
+            header[headerLength++] = char(length & 0xff);
+            header[headerLength++] = char((length >> 8) & 0xff);
+            header[headerLength++] = char((length >> 16) & 0xff);
+        }
+    }
+        break;
+    case STransportOptions::FramingIntermediate:
+        if (m_firstPackage) {
+            qToLittleEndian<quint32>(0xeeeeeeeeu, reinterpret_cast<uchar *>(header)); // Start session in Intermediate format
+            headerLength += 4;
+        }
+        qToLittleEndian<quint32>(payload.length(), reinterpret_cast<uchar *>(header + headerLength));
+        headerLength += 4;
+        break;
+    case STransportOptions::FramingFull:
+    {
+        qToLittleEndian<quint32>(payload.length() + 12, reinterpret_cast<uchar *>(header));
+        qToLittleEndian<quint32>(m_packetNumber++, reinterpret_cast<uchar *>(header + 4));
+        headerLength = 8;
+
+        quint32 crc = Utils::crc32(0, header, headerLength);
+        crc = Utils::crc32(crc, payload.constData(), payload.length());
+        qToLittleEndian<quint32>(crc, reinterpret_cast<uchar *>(trailer));
+        trailerLength = 4;
+    }
+        break;
+    }
+
+    m_firstPackage = false;
+
+    if (packageCaptureEnabled()) {
+        m_lastPackage = QByteArray(header, headerLength) + payload + QByteArray(trailer, trailerLength);
+    }
+
+    if (writeCoalescingEnabled()) {
+        if (!m_flushScheduled) {
+            m_flushScheduled = true;
+            QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+        }
+
+        if (m_pendingOutput.capacity() < m_pendingOutput.size() + headerLength + payload.size() + trailerLength) {
+            m_pendingOutput.reserve((m_pendingOutput.size() + headerLength + payload.size() + trailerLength) * 2);
+        }
+
+        m_pendingOutput.append(header, headerLength);
+        m_pendingOutput.append(payload);
+        m_pendingOutput.append(trailer, trailerLength);
+        updateSendBufferState();
+        return;
     }
-    package.append(payload);
-    m_lastPackage = package;
-    m_socket->write(package);
+
+    m_socket->write(header, headerLength);
+    m_socket->write(payload);
+
+    if (trailerLength) {
+        m_socket->write(trailer, trailerLength);
+    }
+
+    updateSendBufferState();
+}
+
+void CTcpTransport::flush()
+{
+    m_flushScheduled = false;
+
+    if (m_pendingOutput.isEmpty()) {
+        return;
+    }
+
+    m_socket->write(m_pendingOutput);
+    m_socket->flush();
+
+    m_pendingOutput.resize(0); // Keeps the reserved capacity
 }
 
 void CTcpTransport::onStateChanged(QAbstractSocket::SocketState newState)
@@ -110,6 +276,16 @@ void CTcpTransport::onStateChanged(QAbstractSocket::SocketState newState)
     case QAbstractSocket::ConnectedState:
         m_expectedLength = 0;
         m_firstPackage = true;
+        m_activeFraming = framing();
+        m_packetNumber = 0;
+        m_receivedPacketNumber = 0;
+        m_pendingOutput.resize(0);
+        resetReadBuffer();
+        applySocketOptions();
+        resetSendBufferState();
+        break;
+    case QAbstractSocket::UnconnectedState:
+        resetSendBufferState();
         break;
     default:
         break;
@@ -136,35 +312,72 @@ void CTcpTransport::onError(QAbstractSocket::SocketError error)
 
 void CTcpTransport::onReadyRead()
 {
-    while (m_socket->bytesAvailable() > 0) {
+    const qint64 bytesAvailable = m_socket->bytesAvailable();
+
+    if (bytesAvailable <= 0) {
+        return;
+    }
+
+    ensureReadBufferSpace(bytesAvailable);
+
+    const qint64 bytesRead = m_socket->read(m_readBuffer.data() + m_readBufferEnd, bytesAvailable);
+
+    if (bytesRead <= 0) {
+        return;
+    }
+
+    m_readBufferEnd += bytesRead;
+
+    while (m_readBufferEnd > m_readBufferBegin) {
+        const uchar *data = reinterpret_cast<const uchar *>(m_readBuffer.constData()) + m_readBufferBegin;
+        const int bytesBuffered = m_readBufferEnd - m_readBufferBegin;
+
         if (m_expectedLength == 0) {
-            if (m_socket->bytesAvailable() < 4) {
-                // Four bytes is minimum readable size for new package
+            const int headerLength = readPackageHeader(data, bytesBuffered);
+            if (headerLength < 0) {
+                // There is no way to find the next package boundary
+                dropConnection();
                 return;
             }
-
-            char length;
-            m_socket->getChar(&length);
-
-            if (length < char(0x7f)) {
-                m_expectedLength = length * 4;
-            } else if (length == char(0x7f)) {
-                m_socket->read((char *) &m_expectedLength, 3);
-                m_expectedLength *= 4;
-            } else {
-                qDebug() << "Incorrect TCP package!";
+            if (!headerLength) {
+                break;
             }
+            m_readBufferBegin += headerLength;
+            continue;
         }
 
-        if (m_socket->bytesAvailable() < m_expectedLength)
-            return;
+        if (bytesBuffered < int(m_expectedLength)) {
+            break;
+        }
 
-        m_receivedPackage = m_socket->read(m_expectedLength);
+        if (m_activeFraming == STransportOptions::FramingFull) {
+            // Strip the packet number and the crc.
+            if (!checkFullPackage(data)) {
+                dropConnection();
+                return;
+            }
+            m_receivedPackage = QByteArray::fromRawData(reinterpret_cast<const char *>(data) + 4, m_expectedLength - 8);
+        } else {
+            m_receivedPackage = QByteArray::fromRawData(reinterpret_cast<const char *>(data), m_expectedLength);
+        }
 
+        m_readBufferBegin += m_expectedLength;
         m_expectedLength = 0;
 
         emit readyRead();
     }
+
+    m_receivedPackage.clear();
+
+    if (m_readBufferBegin == m_readBufferEnd) {
+        m_readBufferBegin = 0;
+        m_readBufferEnd = 0;
+    }
+}
+
+void CTcpTransport::onBytesWritten()
+{
+    updateSendBufferState();
 }
 
 void CTcpTransport::onTimeout()
@@ -177,3 +390,143 @@ void CTcpTransport::onTimeout()
 
     m_socket->disconnectFromHost();
 }
+
+void CTcpTransport::applySocketOptions()
+{
+    // Socket options can be applied only to an opened socket.
+    m_socket->setSocketOption(QAbstractSocket::LowDelayOption, m_options.noDelay ? 1 : 0);
+    m_socket->setSocketOption(QAbstractSocket::KeepAliveOption, m_options.keepAlive ? 1 : 0);
+
+    if (!m_options.keepAlive) {
+        return;
+    }
+
+#ifdef Q_OS_LINUX
+    // Qt does not provide an API for the keep-alive intervals.
+    const int descriptor = int(m_socket->socketDescriptor());
+
+    if (m_options.keepAliveIdleTime) {
+        setsockopt(descriptor, IPPROTO_TCP, TCP_KEEPIDLE, &m_options.keepAliveIdleTime, sizeof(m_options.keepAliveIdleTime));
+    }
+
+    if (m_options.keepAliveInterval) {
+        setsockopt(descriptor, IPPROTO_TCP, TCP_KEEPINTVL, &m_options.keepAliveInterval, sizeof(m_options.keepAliveInterval));
+    }
+
+    if (m_options.keepAliveProbes) {
+        setsockopt(descriptor, IPPROTO_TCP, TCP_KEEPCNT, &m_options.keepAliveProbes, sizeof(m_options.keepAliveProbes));
+    }
+#endif
+}
+
+// Returns the header length and sets m_expectedLength, returns 0 if there is not enough data buffered
+// or -1 if the header is malformed.
+int CTcpTransport::readPackageHeader(const uchar *data, int bytesBuffered)
+{
+    switch (m_activeFraming) {
+    case STransportOptions::FramingAbridged:
+        if (data[0] < 0x7f) {
+            m_expectedLength = data[0] * 4;
+            return 1;
+        }
+        if (data[0] == 0x7f) {
+            if (bytesBuffered < 4) {
+                return 0;
+            }
+            m_expectedLength = (data[1] | (data[2] << 8) | (data[3] << 16)) * 4;
+            return 4;
+        }
+        qWarning() << Q_FUNC_INFO << "Incorrect TCP package header" << data[0];
+        return -1;
+    case STransportOptions::FramingIntermediate:
+    {
+        if (bytesBuffered < 4) {
+            return 0;
+        }
+        const quint32 length = qFromLittleEndian<quint32>(data);
+        if (length > s_maxPackageLength) {
+            qWarning() << Q_FUNC_INFO << "Incorrect TCP package length" << length;
+            return -1;
+        }
+        m_expectedLength = length;
+    }
+        return 4;
+    case STransportOptions::FramingFull:
+    {
+        if (bytesBuffered < 4) {
+            return 0;
+        }
+        const quint32 length = qFromLittleEndian<quint32>(data);
+        if ((length < 12) || (length % 4) || (length > s_maxPackageLength)) {
+            qWarning() << Q_FUNC_INFO << "Incorrect TCP package length" << length;
+            return -1;
+        }
+        // The length value itself is not a part of the buffered package, but it is covered by the crc.
+        m_receivedCrc = Utils::crc32(0, reinterpret_cast<const char *>(data), 4);
+        m_expectedLength = length - 4;
+    }
+        return 4;
+    }
+
+    return 0;
+}
+
+bool CTcpTransport::checkFullPackage(const uchar *data)
+{
+    const quint32 packetNumber = qFromLittleEndian<quint32>(data);
+    const quint32 crc = qFromLittleEndian<quint32>(data + m_expectedLength - 4);
+
+    if (Utils::crc32(m_receivedCrc, reinterpret_cast<const char *>(data), m_expectedLength - 4) != crc) {
+        qWarning() << Q_FUNC_INFO << "Incorrect TCP package crc!";
+        return false;
+    }
+
+    if (packetNumber != m_receivedPacketNumber) {
+        qWarning() << Q_FUNC_INFO << "Unexpected TCP package number" << packetNumber << "(expected" << m_receivedPacketNumber << ")";
+        return false;
+    }
+
+    ++m_receivedPacketNumber;
+
+    return true;
+}
+
+// Drops the buffered data and closes the connection after a framing error
+void CTcpTransport::dropConnection()
+{
+    m_readBufferBegin = 0;
+    m_readBufferEnd = 0;
+    m_expectedLength = 0;
+    m_receivedPackage.clear();
+    m_socket->disconnectFromHost();
+}
+
+void CTcpTransport::resetReadBuffer()
+{
+    m_readBufferBegin = 0;
+    m_readBufferEnd = 0;
+    m_receivedPackage.clear();
+
+    if (m_readBuffer.size() < s_initialReadBufferSize) {
+        m_readBuffer.resize(s_initialReadBufferSize);
+    }
+}
+
+void CTcpTransport::ensureReadBufferSpace(int size)
+{
+    if (m_readBuffer.size() - m_readBufferEnd >= size) {
+        return;
+    }
+
+    // Move the unprocessed tail to the buffer beginning, so the next packet stays contiguous.
+    if (m_readBufferBegin) {
+        const int bytesBuffered = m_readBufferEnd - m_readBufferBegin;
+        memmove(m_readBuffer.data(), m_readBuffer.constData() + m_readBufferBegin, bytesBuffered);
+        m_readBufferBegin = 0;
+        m_readBufferEnd = bytesBuffered;
+    }
+
+    if (m_readBuffer.size() - m_readBufferEnd < size) {
+        m_readBuffer.resize(qMax(m_readBuffer.size() * 2, m_readBufferEnd + size));
+    }
+}
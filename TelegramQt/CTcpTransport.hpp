@@ -37,31 +37,59 @@ public:
 
     bool isConnected() const override;
 
+    void setWriteCoalescingEnabled(bool enabled) override;
+    void setOptions(const STransportOptions &options) override;
+
+    qint64 bytesToWrite() const override;
+
+    // The returned array does not own the data. It is valid only within readyRead() handlers.
     QByteArray getPackage() override { return m_receivedPackage; }
+    // The receive buffer is never shared, so the package can be modified in place.
+    char *getMutablePackage(int *size) override;
 
-    // Method for testing
+    // Methods for testing
     QByteArray lastPackage() const override { return m_lastPackage; }
+    QVariant socketOption(QAbstractSocket::SocketOption option) const;
 
 public slots:
     void sendPackage(const QByteArray &payload) override;
+    void flush() override;
 
 private slots:
     void onStateChanged(QAbstractSocket::SocketState newState);
     void onError(QAbstractSocket::SocketError error);
     void onReadyRead();
+    void onBytesWritten();
     void onTimeout();
 
 private:
+    void applySocketOptions();
+    void resetReadBuffer();
+    void dropConnection();
+    void ensureReadBufferSpace(int size);
+    int readPackageHeader(const uchar *data, int bytesBuffered);
+    bool checkFullPackage(const uchar *data);
+
+    STransportOptions::Framing m_activeFraming;
     quint32 m_packetNumber;
+    quint32 m_receivedPacketNumber;
+    quint32 m_receivedCrc;
     quint32 m_expectedLength;
 
-    QByteArray m_receivedPackage;
-    QByteArray m_lastPackage;
+    QByteArray m_readBuffer; // Reusable receive buffer; packets are framed in place
+    int m_readBufferBegin;
+    int m_readBufferEnd;
+
+    QByteArray m_receivedPackage; // Raw view over the m_readBuffer
+    QByteArray m_lastPackage; // Filled only if the package capture is enabled
+    QByteArray m_pendingOutput; // Packages waiting for the coalesced write
 
+    STransportOptions m_options;
     QTcpSocket *m_socket;
     QTimer *m_timeoutTimer;
 
     bool m_firstPackage;
+    bool m_flushScheduled;
 
 };
 
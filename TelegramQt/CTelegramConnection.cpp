@@ -20,9 +20,12 @@
 #include <QDebug>
 
 #include <QDateTime>
+#include <QFutureWatcher>
 #include <QStringList>
+#include <QThread>
 #include <QTimer>
 
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtEndian>
 
 #ifdef NETWORK_LOGGING
@@ -38,8 +41,10 @@ QString formatTLValue(const TLValue &val)
 }
 #endif
 
+#include "CAesIgeCipher.hpp"
 #include "CAppInformation.hpp"
 #include "CTelegramStream.hpp"
+#include "CHttpTransport.hpp"
 #include "CTcpTransport.hpp"
 #include "Utils.hpp"
 #include "TelegramUtils.hpp"
@@ -52,16 +57,59 @@ QString formatTLValue(const TLValue &val)
 using namespace TelegramUtils;
 
 static const quint32 s_defaultAuthInterval = 15000; // 15 sec
+static const quint32 s_previousAuthKeyPingIntervals = 3; // The answers under a replaced key are accepted for this many ping intervals
+static const quint32 s_defaultPreviousAuthKeyTimeout = 30000; // 30 sec, if the ping is disabled
+
+struct SDhParametersRequest
+{
+    SDhParametersRequest() : p(0), q(0) { }
+
+    quint32 p;
+    quint32 q;
+    QByteArray encryptedPackage; // Empty, if the pq is not solved
+};
+
+struct SConnectionMetaTypes
+{
+    SConnectionMetaTypes()
+    {
+        qRegisterMetaType<STransportOptions>("STransportOptions");
+        qRegisterMetaType<TelegramNamespace::AuthSignError>("TelegramNamespace::AuthSignError");
+        qRegisterMetaType<TelegramNamespace::UnauthorizedError>("TelegramNamespace::UnauthorizedError");
+        qRegisterMetaType<TelegramNamespace::UserNameStatus>("TelegramNamespace::UserNameStatus");
+        qRegisterMetaType<QVector<quint32> >("QVector<quint32>");
+        qRegisterMetaType<TLAccountPassword>("TLAccountPassword");
+        qRegisterMetaType<TLUser>("TLUser");
+        qRegisterMetaType<QVector<TLUser> >("QVector<TLUser>");
+        qRegisterMetaType<TLUserFull>("TLUserFull");
+        qRegisterMetaType<TLUploadFile>("TLUploadFile");
+        qRegisterMetaType<TLChatFull>("TLChatFull");
+        qRegisterMetaType<QVector<TLChat> >("QVector<TLChat>");
+        qRegisterMetaType<TLInputPeer>("TLInputPeer");
+        qRegisterMetaType<TLMessagesMessages>("TLMessagesMessages");
+        qRegisterMetaType<TLMessagesDialogs>("TLMessagesDialogs");
+        qRegisterMetaType<TLMessagesAffectedMessages>("TLMessagesAffectedMessages");
+        qRegisterMetaType<TLUpdates>("TLUpdates");
+        qRegisterMetaType<TLUpdatesState>("TLUpdatesState");
+        qRegisterMetaType<TLUpdatesDifference>("TLUpdatesDifference");
+    }
+};
+
+// The connections are created in different threads, so the registration is a thread-safe one-time init
+Q_GLOBAL_STATIC(SConnectionMetaTypes, s_metaTypes)
 
 CTelegramConnection::CTelegramConnection(const CAppInformation *appInfo, QObject *parent) :
     QObject(parent),
+    m_mutex(QMutex::Recursive),
     m_status(ConnectionStatusDisconnected),
+    m_sendBufferFull(false),
     m_appInfo(appInfo),
     m_transport(0),
     m_authTimer(0),
     m_pingTimer(0),
     m_ackTimer(new QTimer(this)),
     m_authState(AuthStateNone),
+    m_authKeyAuthorized(true),
     m_authId(0),
     m_authKeyAuxHash(0),
     m_serverSalt(0),
@@ -74,25 +122,94 @@ CTelegramConnection::CTelegramConnection(const CAppInformation *appInfo, QObject
     m_serverDisconnectionExtraTime(0),
     m_deltaTime(0),
     m_deltaTimeHeuristicState(DeltaTimeIsOk),
-    m_serverPublicFingersprint(0)
+    m_serverPublicFingersprint(0),
+    m_authRetryId(0),
+    m_handshakeGeneration(0),
+    m_tempAuthKeyLifetime(0),
+    m_authKeyExpiresAt(0),
+    m_tempAuthId(0),
+    m_previousAuthId(0),
+    m_previousSessionId(0),
+    m_previousAuthKeyTimer(new QTimer(this)),
+    m_bindingMessageId(0)
   #ifdef NETWORK_LOGGING
   , m_logFile(0)
   #endif
 {
+    registerTypes();
     setTransport(new CTcpTransport(this));
 
     m_ackTimer->setInterval(90 * 1000);
     m_ackTimer->setSingleShot(true);
     connect(m_ackTimer, SIGNAL(timeout()), SLOT(onTimeToAckMessages()));
+
+    m_previousAuthKeyTimer->setSingleShot(true);
+    connect(m_previousAuthKeyTimer, SIGNAL(timeout()), SLOT(onPreviousAuthKeyExpired()));
+}
+
+void CTelegramConnection::registerTypes()
+{
+    s_metaTypes();
 }
 
 void CTelegramConnection::setDcInfo(const TLDcOption &newDcInfo)
 {
+    QMutexLocker locker(&m_mutex);
     m_dcInfo = newDcInfo;
 }
 
+TLDcOption CTelegramConnection::dcInfo() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dcInfo;
+}
+
+void CTelegramConnection::setTransportOptions(const STransportOptions &options)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, "setTransportOptions", Qt::QueuedConnection, Q_ARG(STransportOptions, options));
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_transportOptions = options;
+    }
+
+    // A custom transport (e.g. the loopback one) is kept as is
+    const bool httpTransport = qobject_cast<CHttpTransport *>(m_transport);
+    const bool tcpTransport = qobject_cast<CTcpTransport *>(m_transport);
+    const bool wantHttp = options.protocol == STransportOptions::ProtocolHttp;
+
+    if ((wantHttp && tcpTransport) || (!wantHttp && httpTransport)) {
+        if (m_status == ConnectionStatusDisconnected) {
+            if (wantHttp) {
+                setTransport(new CHttpTransport(this));
+            } else {
+                setTransport(new CTcpTransport(this));
+            }
+        } else {
+            qDebug() << Q_FUNC_INFO << "The transport protocol can not be changed on an active connection";
+        }
+    }
+
+    m_transport->setOptions(options);
+}
+
+STransportOptions CTelegramConnection::transportOptions() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_transportOptions;
+}
+
 void CTelegramConnection::connectToDc()
 {
+    if (QThread::currentThread() != thread()) {
+        // The transport must be used only from its own thread
+        QMetaObject::invokeMethod(this, "connectToDc", Qt::QueuedConnection);
+        return;
+    }
+
     if (m_status != ConnectionStatusDisconnected) {
         return;
     }
@@ -112,22 +229,201 @@ void CTelegramConnection::connectToDc()
 
 void CTelegramConnection::setTransport(CTelegramTransport *newTransport)
 {
+    if (m_transport) {
+        disconnect(m_transport, 0, this, 0);
+        m_transport->deleteLater();
+    }
+
     m_transport = newTransport;
+    m_transport->setParent(this);
 
     connect(m_transport, SIGNAL(stateChanged(QAbstractSocket::SocketState)), SLOT(onTransportStateChanged()));
     connect(m_transport, SIGNAL(readyRead()), SLOT(onTransportReadyRead()));
     connect(m_transport, SIGNAL(timeout()), SLOT(onTransportTimeout()));
+    connect(m_transport, SIGNAL(sendBufferFullChanged(bool)), SLOT(onTransportSendBufferFullChanged(bool)));
+
+    onTransportSendBufferFullChanged(m_transport->isSendBufferFull());
+}
+
+bool CTelegramConnection::isSendBufferFull() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sendBufferFull;
+}
+
+QByteArray CTelegramConnection::authKey() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_authKey;
 }
 
 void CTelegramConnection::setAuthKey(const QByteArray &newAuthKey)
 {
+    QMutexLocker locker(&m_mutex);
     m_authKey = newAuthKey;
     m_authId = Utils::getFingersprint(m_authKey);
     m_authKeyAuxHash = Utils::getFingersprint(m_authKey, /* lower-order */ false);
 }
 
+void CTelegramConnection::setAuthKeyAuthorized(bool authorized)
+{
+    QMutexLocker locker(&m_mutex);
+    m_authKeyAuthorized = authorized;
+}
+
+void CTelegramConnection::setServerSalt(const quint64 salt)
+{
+    QMutexLocker locker(&m_mutex);
+    m_serverSalt = salt;
+}
+
+QByteArray CTelegramConnection::tempAuthKey() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_tempAuthKey;
+}
+
+void CTelegramConnection::setTempAuthKey(const QByteArray &tempAuthKey, quint64 serverSalt)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, "setTempAuthKey", Qt::QueuedConnection,
+                                  Q_ARG(QByteArray, tempAuthKey), Q_ARG(quint64, serverSalt));
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    // The answers to the requests of the current session can be still in flight.
+    // They are accepted for a short time only, otherwise the replaced key would undo the forward secrecy.
+    m_previousAuthKey = messageAuthKey();
+    m_previousAuthId = messageAuthId();
+    m_previousSessionId = m_sessionId;
+    m_previousAuthKeyTimer->start(m_pingInterval ? m_pingInterval * s_previousAuthKeyPingIntervals : s_defaultPreviousAuthKeyTimeout);
+
+    m_tempAuthKey = tempAuthKey;
+    m_tempAuthId = Utils::getFingersprint(m_tempAuthKey);
+    m_serverSalt = serverSalt;
+
+    // The key is bound to a new session, which starts with initConnection again
+    Utils::randomBytes(&m_sessionId);
+    m_contentRelatedMessages = 0;
+}
+
+// The binding message is encrypted by the permanent key, while the request itself is sent with the temporary key of this connection.
+quint64 CTelegramConnection::bindTempAuthKey(const QByteArray &permanentAuthKey)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_authKey.isEmpty() || (permanentAuthKey.size() != 256)) {
+        qWarning() << Q_FUNC_INFO << "Unable to bind the key: there is no temporary or permanent key.";
+        return 0;
+    }
+
+    // The inner message must have the same id, as the outer one
+    const quint64 messageId = newMessageId();
+    const quint64 permAuthId = Utils::getFingersprint(permanentAuthKey);
+
+    quint64 nonce;
+    Utils::randomBytes(&nonce);
+
+    QByteArray bindingData;
+    {
+        CTelegramStream stream(&bindingData, /* write */ true);
+        stream << TLValue::BindAuthKeyInner;
+        stream << nonce;
+        stream << m_authId;
+        stream << permAuthId;
+        stream << m_sessionId;
+        stream << m_authKeyExpiresAt;
+    }
+
+    // MTProto message with a random salt and session id, the same message id and zero seq_no
+    static const int innerHeaderLength = 8 + 8 + 8 + 4 + 4;
+    const int innerLength = innerHeaderLength + bindingData.length();
+    const int paddingLength = (16 - innerLength % 16) % 16;
+
+    QByteArray encryptedMessage(8 + 16 + innerLength + paddingLength, Qt::Uninitialized);
+    char *messageKey = encryptedMessage.data() + 8;
+    char *innerData = messageKey + 16;
+
+    qToLittleEndian<quint64>(permAuthId, reinterpret_cast<uchar *>(encryptedMessage.data()));
+    Utils::randomBytes(innerData, 16); // salt and session id
+    qToLittleEndian<quint64>(messageId, reinterpret_cast<uchar *>(innerData + 16));
+    qToLittleEndian<quint32>(0, reinterpret_cast<uchar *>(innerData + 24));
+    qToLittleEndian<quint32>(bindingData.length(), reinterpret_cast<uchar *>(innerData + 28));
+    memcpy(innerData + innerHeaderLength, bindingData.constData(), bindingData.length());
+    Utils::randomBytes(innerData + innerLength, paddingLength);
+
+    uchar sha[20];
+    m_sha1Context.addData(innerData, innerLength);
+    m_sha1Context.result(sha);
+    memcpy(messageKey, sha + 4, 16);
+
+    SFixedAesKey key;
+    generateAesKey(&key, permanentAuthKey.constData(), messageKey, 0);
+    CAesIgeCipher(key, CAesIgeCipher::Encryption).process(innerData, innerLength + paddingLength);
+
+    QByteArray output;
+    CTelegramStream outputStream(&output, /* write */ true);
+    outputStream << TLValue::AuthBindTempAuthKey;
+    outputStream << permAuthId;
+    outputStream << nonce;
+    outputStream << m_authKeyExpiresAt;
+    outputStream << encryptedMessage;
+
+    m_bindingPermanentAuthKey = permanentAuthKey;
+    m_bindingRequest = output;
+
+    // The binding request must not be wrapped into initConnection
+    m_bindingMessageId = sendEncryptedPackage(output, messageId, /* savePackage */ false, /* initConnectionAllowed */ false);
+    return m_bindingMessageId;
+}
+
+CTelegramConnection::ConnectionStatus CTelegramConnection::status() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_status;
+}
+
+CTelegramConnection::AuthState CTelegramConnection::authState() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_authState;
+}
+
+quint64 CTelegramConnection::authId() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_authId;
+}
+
+quint64 CTelegramConnection::serverSalt() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_serverSalt;
+}
+
+quint64 CTelegramConnection::sessionId() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sessionId;
+}
+
+qint32 CTelegramConnection::deltaTime() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_deltaTime;
+}
+
+QVector<TLDcOption> CTelegramConnection::dcConfiguration() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dcConfiguration;
+}
+
 void CTelegramConnection::setDeltaTime(const qint32 newDt)
 {
+    QMutexLocker locker(&m_mutex);
     m_deltaTime = newDt;
 
     // Message id depends on time, so if we fix time, we need to reset message id.
@@ -165,7 +461,9 @@ void CTelegramConnection::initAuth()
 {
     if (m_authState == AuthStateNone) {
         m_authRetryId = 0;
-        m_rsaKey = Utils::loadRsaKey();
+        if (m_rsaKey.key.isEmpty()) {
+            m_rsaKey = Utils::loadRsaKey();
+        }
         Utils::randomBytes(m_clientNonce.data, m_clientNonce.size());
 
         requestPqAuthorization();
@@ -226,6 +524,9 @@ quint64 CTelegramConnection::signUp(const QString &phoneNumber, const QString &a
 
 void CTelegramConnection::downloadFile(const TLInputFileLocation &inputLocation, quint32 offset, quint32 limit, quint32 requestId)
 {
+    // The answer must not be processed before the request id is saved.
+    QMutexLocker locker(&m_mutex);
+
     if (m_requestedFilesIds.contains(requestId)) {
         // Prevent from (really possible) repeated request.
         return;
@@ -239,6 +540,7 @@ void CTelegramConnection::downloadFile(const TLInputFileLocation &inputLocation,
 
 void CTelegramConnection::uploadFile(quint64 fileId, quint32 filePart, const QByteArray &bytes, quint32 requestId)
 {
+    QMutexLocker locker(&m_mutex);
     qDebug() << Q_FUNC_INFO << "id" << fileId << "part" << filePart << "size" << bytes.count() << "request" << requestId;
     const quint64 messageId = uploadSaveFilePart(fileId, filePart, bytes);
 
@@ -255,7 +557,16 @@ quint64 CTelegramConnection::sendMessage(const TLInputPeer &peer, const QString
     const TLReplyMarkup replyMarkup;
     const TLVector<TLMessageEntity> entities;
 
-    return messagesSendMessage(/* flags */0, peer, /* reply to message id*/ 0, message, randomMessageId, replyMarkup, entities);
+    const quint64 messageId = messagesSendMessage(/* flags */0, peer, /* reply to message id*/ 0, message, randomMessageId, replyMarkup, entities);
+
+    // Do not wait for the coalesced write, the message sending is latency-critical.
+    if (QThread::currentThread() == m_transport->thread()) {
+        m_transport->flush();
+    } else {
+        QMetaObject::invokeMethod(m_transport, "flush", Qt::QueuedConnection);
+    }
+
+    return messageId;
 }
 
 quint64 CTelegramConnection::sendMedia(const TLInputPeer &peer, const TLInputMedia &media, quint64 randomMessageId)
@@ -267,7 +578,12 @@ quint64 CTelegramConnection::sendMedia(const TLInputPeer &peer, const TLInputMed
 // Generated Telegram API methods implementation
 quint64 CTelegramConnection::accountChangePhone(const QString &phoneNumber, const QString &phoneCodeHash, const QString &phoneCode)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountChangePhone));
+    payloadSize += CTelegramStream::serializedSize(phoneNumber);
+    payloadSize += CTelegramStream::serializedSize(phoneCodeHash);
+    payloadSize += CTelegramStream::serializedSize(phoneCode);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountChangePhone;
     outputStream << phoneNumber;
@@ -278,7 +594,10 @@ quint64 CTelegramConnection::accountChangePhone(const QString &phoneNumber, cons
 
 quint64 CTelegramConnection::accountCheckUsername(const QString &username)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountCheckUsername));
+    payloadSize += CTelegramStream::serializedSize(username);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountCheckUsername;
     outputStream << username;
@@ -287,7 +606,10 @@ quint64 CTelegramConnection::accountCheckUsername(const QString &username)
 
 quint64 CTelegramConnection::accountDeleteAccount(const QString &reason)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountDeleteAccount));
+    payloadSize += CTelegramStream::serializedSize(reason);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountDeleteAccount;
     outputStream << reason;
@@ -296,7 +618,9 @@ quint64 CTelegramConnection::accountDeleteAccount(const QString &reason)
 
 quint64 CTelegramConnection::accountGetAccountTTL()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountGetAccountTTL));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountGetAccountTTL;
     return sendEncryptedPackage(output);
@@ -304,7 +628,9 @@ quint64 CTelegramConnection::accountGetAccountTTL()
 
 quint64 CTelegramConnection::accountGetAuthorizations()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountGetAuthorizations));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountGetAuthorizations;
     return sendEncryptedPackage(output);
@@ -312,7 +638,10 @@ quint64 CTelegramConnection::accountGetAuthorizations()
 
 quint64 CTelegramConnection::accountGetNotifySettings(const TLInputNotifyPeer &peer)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountGetNotifySettings));
+    payloadSize += CTelegramStream::serializedSize(peer);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountGetNotifySettings;
     outputStream << peer;
@@ -321,7 +650,9 @@ quint64 CTelegramConnection::accountGetNotifySettings(const TLInputNotifyPeer &p
 
 quint64 CTelegramConnection::accountGetPassword()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountGetPassword));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountGetPassword;
     return sendEncryptedPackage(output);
@@ -329,7 +660,10 @@ quint64 CTelegramConnection::accountGetPassword()
 
 quint64 CTelegramConnection::accountGetPasswordSettings(const QByteArray &currentPasswordHash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountGetPasswordSettings));
+    payloadSize += CTelegramStream::serializedSize(currentPasswordHash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountGetPasswordSettings;
     outputStream << currentPasswordHash;
@@ -338,7 +672,10 @@ quint64 CTelegramConnection::accountGetPasswordSettings(const QByteArray &curren
 
 quint64 CTelegramConnection::accountGetPrivacy(const TLInputPrivacyKey &key)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountGetPrivacy));
+    payloadSize += CTelegramStream::serializedSize(key);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountGetPrivacy;
     outputStream << key;
@@ -347,7 +684,9 @@ quint64 CTelegramConnection::accountGetPrivacy(const TLInputPrivacyKey &key)
 
 quint64 CTelegramConnection::accountGetWallPapers()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountGetWallPapers));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountGetWallPapers;
     return sendEncryptedPackage(output);
@@ -355,7 +694,16 @@ quint64 CTelegramConnection::accountGetWallPapers()
 
 quint64 CTelegramConnection::accountRegisterDevice(quint32 tokenType, const QString &token, const QString &deviceModel, const QString &systemVersion, const QString &appVersion, bool appSandbox, const QString &langCode)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountRegisterDevice));
+    payloadSize += CTelegramStream::serializedSize(tokenType);
+    payloadSize += CTelegramStream::serializedSize(token);
+    payloadSize += CTelegramStream::serializedSize(deviceModel);
+    payloadSize += CTelegramStream::serializedSize(systemVersion);
+    payloadSize += CTelegramStream::serializedSize(appVersion);
+    payloadSize += CTelegramStream::serializedSize(appSandbox);
+    payloadSize += CTelegramStream::serializedSize(langCode);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountRegisterDevice;
     outputStream << tokenType;
@@ -370,7 +718,11 @@ quint64 CTelegramConnection::accountRegisterDevice(quint32 tokenType, const QStr
 
 quint64 CTelegramConnection::accountReportPeer(const TLInputPeer &peer, const TLReportReason &reason)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountReportPeer));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(reason);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountReportPeer;
     outputStream << peer;
@@ -380,7 +732,10 @@ quint64 CTelegramConnection::accountReportPeer(const TLInputPeer &peer, const TL
 
 quint64 CTelegramConnection::accountResetAuthorization(quint64 hash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountResetAuthorization));
+    payloadSize += CTelegramStream::serializedSize(hash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountResetAuthorization;
     outputStream << hash;
@@ -389,7 +744,9 @@ quint64 CTelegramConnection::accountResetAuthorization(quint64 hash)
 
 quint64 CTelegramConnection::accountResetNotifySettings()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountResetNotifySettings));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountResetNotifySettings;
     return sendEncryptedPackage(output);
@@ -397,7 +754,10 @@ quint64 CTelegramConnection::accountResetNotifySettings()
 
 quint64 CTelegramConnection::accountSendChangePhoneCode(const QString &phoneNumber)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountSendChangePhoneCode));
+    payloadSize += CTelegramStream::serializedSize(phoneNumber);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountSendChangePhoneCode;
     outputStream << phoneNumber;
@@ -406,7 +766,10 @@ quint64 CTelegramConnection::accountSendChangePhoneCode(const QString &phoneNumb
 
 quint64 CTelegramConnection::accountSetAccountTTL(const TLAccountDaysTTL &ttl)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountSetAccountTTL));
+    payloadSize += CTelegramStream::serializedSize(ttl);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountSetAccountTTL;
     outputStream << ttl;
@@ -415,7 +778,11 @@ quint64 CTelegramConnection::accountSetAccountTTL(const TLAccountDaysTTL &ttl)
 
 quint64 CTelegramConnection::accountSetPrivacy(const TLInputPrivacyKey &key, const TLVector<TLInputPrivacyRule> &rules)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountSetPrivacy));
+    payloadSize += CTelegramStream::serializedSize(key);
+    payloadSize += CTelegramStream::serializedSize(rules);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountSetPrivacy;
     outputStream << key;
@@ -425,7 +792,11 @@ quint64 CTelegramConnection::accountSetPrivacy(const TLInputPrivacyKey &key, con
 
 quint64 CTelegramConnection::accountUnregisterDevice(quint32 tokenType, const QString &token)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountUnregisterDevice));
+    payloadSize += CTelegramStream::serializedSize(tokenType);
+    payloadSize += CTelegramStream::serializedSize(token);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountUnregisterDevice;
     outputStream << tokenType;
@@ -435,7 +806,10 @@ quint64 CTelegramConnection::accountUnregisterDevice(quint32 tokenType, const QS
 
 quint64 CTelegramConnection::accountUpdateDeviceLocked(quint32 period)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountUpdateDeviceLocked));
+    payloadSize += CTelegramStream::serializedSize(period);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountUpdateDeviceLocked;
     outputStream << period;
@@ -444,7 +818,11 @@ quint64 CTelegramConnection::accountUpdateDeviceLocked(quint32 period)
 
 quint64 CTelegramConnection::accountUpdateNotifySettings(const TLInputNotifyPeer &peer, const TLInputPeerNotifySettings &settings)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountUpdateNotifySettings));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(settings);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountUpdateNotifySettings;
     outputStream << peer;
@@ -454,7 +832,11 @@ quint64 CTelegramConnection::accountUpdateNotifySettings(const TLInputNotifyPeer
 
 quint64 CTelegramConnection::accountUpdatePasswordSettings(const QByteArray &currentPasswordHash, const TLAccountPasswordInputSettings &newSettings)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountUpdatePasswordSettings));
+    payloadSize += CTelegramStream::serializedSize(currentPasswordHash);
+    payloadSize += CTelegramStream::serializedSize(newSettings);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountUpdatePasswordSettings;
     outputStream << currentPasswordHash;
@@ -464,7 +846,11 @@ quint64 CTelegramConnection::accountUpdatePasswordSettings(const QByteArray &cur
 
 quint64 CTelegramConnection::accountUpdateProfile(const QString &firstName, const QString &lastName)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountUpdateProfile));
+    payloadSize += CTelegramStream::serializedSize(firstName);
+    payloadSize += CTelegramStream::serializedSize(lastName);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountUpdateProfile;
     outputStream << firstName;
@@ -474,7 +860,10 @@ quint64 CTelegramConnection::accountUpdateProfile(const QString &firstName, cons
 
 quint64 CTelegramConnection::accountUpdateStatus(bool offline)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountUpdateStatus));
+    payloadSize += CTelegramStream::serializedSize(offline);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountUpdateStatus;
     outputStream << offline;
@@ -483,7 +872,10 @@ quint64 CTelegramConnection::accountUpdateStatus(bool offline)
 
 quint64 CTelegramConnection::accountUpdateUsername(const QString &username)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AccountUpdateUsername));
+    payloadSize += CTelegramStream::serializedSize(username);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AccountUpdateUsername;
     outputStream << username;
@@ -492,7 +884,13 @@ quint64 CTelegramConnection::accountUpdateUsername(const QString &username)
 
 quint64 CTelegramConnection::authBindTempAuthKey(quint64 permAuthKeyId, quint64 nonce, quint32 expiresAt, const QByteArray &encryptedMessage)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthBindTempAuthKey));
+    payloadSize += CTelegramStream::serializedSize(permAuthKeyId);
+    payloadSize += CTelegramStream::serializedSize(nonce);
+    payloadSize += CTelegramStream::serializedSize(expiresAt);
+    payloadSize += CTelegramStream::serializedSize(encryptedMessage);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthBindTempAuthKey;
     outputStream << permAuthKeyId;
@@ -504,7 +902,10 @@ quint64 CTelegramConnection::authBindTempAuthKey(quint64 permAuthKeyId, quint64
 
 quint64 CTelegramConnection::authCheckPassword(const QByteArray &passwordHash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthCheckPassword));
+    payloadSize += CTelegramStream::serializedSize(passwordHash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthCheckPassword;
     outputStream << passwordHash;
@@ -513,7 +914,10 @@ quint64 CTelegramConnection::authCheckPassword(const QByteArray &passwordHash)
 
 quint64 CTelegramConnection::authCheckPhone(const QString &phoneNumber)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthCheckPhone));
+    payloadSize += CTelegramStream::serializedSize(phoneNumber);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthCheckPhone;
     outputStream << phoneNumber;
@@ -522,7 +926,10 @@ quint64 CTelegramConnection::authCheckPhone(const QString &phoneNumber)
 
 quint64 CTelegramConnection::authExportAuthorization(quint32 dcId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthExportAuthorization));
+    payloadSize += CTelegramStream::serializedSize(dcId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthExportAuthorization;
     outputStream << dcId;
@@ -531,7 +938,11 @@ quint64 CTelegramConnection::authExportAuthorization(quint32 dcId)
 
 quint64 CTelegramConnection::authImportAuthorization(quint32 id, const QByteArray &bytes)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthImportAuthorization));
+    payloadSize += CTelegramStream::serializedSize(id);
+    payloadSize += CTelegramStream::serializedSize(bytes);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthImportAuthorization;
     outputStream << id;
@@ -541,7 +952,13 @@ quint64 CTelegramConnection::authImportAuthorization(quint32 id, const QByteArra
 
 quint64 CTelegramConnection::authImportBotAuthorization(quint32 flags, quint32 apiId, const QString &apiHash, const QString &botAuthToken)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthImportBotAuthorization));
+    payloadSize += CTelegramStream::serializedSize(flags);
+    payloadSize += CTelegramStream::serializedSize(apiId);
+    payloadSize += CTelegramStream::serializedSize(apiHash);
+    payloadSize += CTelegramStream::serializedSize(botAuthToken);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthImportBotAuthorization;
     outputStream << flags;
@@ -553,7 +970,9 @@ quint64 CTelegramConnection::authImportBotAuthorization(quint32 flags, quint32 a
 
 quint64 CTelegramConnection::authLogOut()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthLogOut));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthLogOut;
     return sendEncryptedPackage(output);
@@ -561,7 +980,10 @@ quint64 CTelegramConnection::authLogOut()
 
 quint64 CTelegramConnection::authRecoverPassword(const QString &code)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthRecoverPassword));
+    payloadSize += CTelegramStream::serializedSize(code);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthRecoverPassword;
     outputStream << code;
@@ -570,7 +992,9 @@ quint64 CTelegramConnection::authRecoverPassword(const QString &code)
 
 quint64 CTelegramConnection::authRequestPasswordRecovery()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthRequestPasswordRecovery));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthRequestPasswordRecovery;
     return sendEncryptedPackage(output);
@@ -578,7 +1002,9 @@ quint64 CTelegramConnection::authRequestPasswordRecovery()
 
 quint64 CTelegramConnection::authResetAuthorizations()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthResetAuthorizations));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthResetAuthorizations;
     return sendEncryptedPackage(output);
@@ -586,7 +1012,11 @@ quint64 CTelegramConnection::authResetAuthorizations()
 
 quint64 CTelegramConnection::authSendCall(const QString &phoneNumber, const QString &phoneCodeHash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthSendCall));
+    payloadSize += CTelegramStream::serializedSize(phoneNumber);
+    payloadSize += CTelegramStream::serializedSize(phoneCodeHash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthSendCall;
     outputStream << phoneNumber;
@@ -596,7 +1026,14 @@ quint64 CTelegramConnection::authSendCall(const QString &phoneNumber, const QStr
 
 quint64 CTelegramConnection::authSendCode(const QString &phoneNumber, quint32 smsType, quint32 apiId, const QString &apiHash, const QString &langCode)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthSendCode));
+    payloadSize += CTelegramStream::serializedSize(phoneNumber);
+    payloadSize += CTelegramStream::serializedSize(smsType);
+    payloadSize += CTelegramStream::serializedSize(apiId);
+    payloadSize += CTelegramStream::serializedSize(apiHash);
+    payloadSize += CTelegramStream::serializedSize(langCode);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthSendCode;
     outputStream << phoneNumber;
@@ -609,7 +1046,11 @@ quint64 CTelegramConnection::authSendCode(const QString &phoneNumber, quint32 sm
 
 quint64 CTelegramConnection::authSendInvites(const TLVector<QString> &phoneNumbers, const QString &message)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthSendInvites));
+    payloadSize += CTelegramStream::serializedSize(phoneNumbers);
+    payloadSize += CTelegramStream::serializedSize(message);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthSendInvites;
     outputStream << phoneNumbers;
@@ -619,7 +1060,11 @@ quint64 CTelegramConnection::authSendInvites(const TLVector<QString> &phoneNumbe
 
 quint64 CTelegramConnection::authSendSms(const QString &phoneNumber, const QString &phoneCodeHash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthSendSms));
+    payloadSize += CTelegramStream::serializedSize(phoneNumber);
+    payloadSize += CTelegramStream::serializedSize(phoneCodeHash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthSendSms;
     outputStream << phoneNumber;
@@ -629,7 +1074,12 @@ quint64 CTelegramConnection::authSendSms(const QString &phoneNumber, const QStri
 
 quint64 CTelegramConnection::authSignIn(const QString &phoneNumber, const QString &phoneCodeHash, const QString &phoneCode)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthSignIn));
+    payloadSize += CTelegramStream::serializedSize(phoneNumber);
+    payloadSize += CTelegramStream::serializedSize(phoneCodeHash);
+    payloadSize += CTelegramStream::serializedSize(phoneCode);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthSignIn;
     outputStream << phoneNumber;
@@ -640,7 +1090,14 @@ quint64 CTelegramConnection::authSignIn(const QString &phoneNumber, const QStrin
 
 quint64 CTelegramConnection::authSignUp(const QString &phoneNumber, const QString &phoneCodeHash, const QString &phoneCode, const QString &firstName, const QString &lastName)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::AuthSignUp));
+    payloadSize += CTelegramStream::serializedSize(phoneNumber);
+    payloadSize += CTelegramStream::serializedSize(phoneCodeHash);
+    payloadSize += CTelegramStream::serializedSize(phoneCode);
+    payloadSize += CTelegramStream::serializedSize(firstName);
+    payloadSize += CTelegramStream::serializedSize(lastName);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::AuthSignUp;
     outputStream << phoneNumber;
@@ -653,7 +1110,10 @@ quint64 CTelegramConnection::authSignUp(const QString &phoneNumber, const QStrin
 
 quint64 CTelegramConnection::contactsBlock(const TLInputUser &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsBlock));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsBlock;
     outputStream << id;
@@ -662,7 +1122,10 @@ quint64 CTelegramConnection::contactsBlock(const TLInputUser &id)
 
 quint64 CTelegramConnection::contactsDeleteContact(const TLInputUser &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsDeleteContact));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsDeleteContact;
     outputStream << id;
@@ -671,7 +1134,10 @@ quint64 CTelegramConnection::contactsDeleteContact(const TLInputUser &id)
 
 quint64 CTelegramConnection::contactsDeleteContacts(const TLVector<TLInputUser> &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsDeleteContacts));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsDeleteContacts;
     outputStream << id;
@@ -680,7 +1146,9 @@ quint64 CTelegramConnection::contactsDeleteContacts(const TLVector<TLInputUser>
 
 quint64 CTelegramConnection::contactsExportCard()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsExportCard));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsExportCard;
     return sendEncryptedPackage(output);
@@ -688,7 +1156,11 @@ quint64 CTelegramConnection::contactsExportCard()
 
 quint64 CTelegramConnection::contactsGetBlocked(quint32 offset, quint32 limit)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsGetBlocked));
+    payloadSize += CTelegramStream::serializedSize(offset);
+    payloadSize += CTelegramStream::serializedSize(limit);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsGetBlocked;
     outputStream << offset;
@@ -698,7 +1170,10 @@ quint64 CTelegramConnection::contactsGetBlocked(quint32 offset, quint32 limit)
 
 quint64 CTelegramConnection::contactsGetContacts(const QString &hash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsGetContacts));
+    payloadSize += CTelegramStream::serializedSize(hash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsGetContacts;
     outputStream << hash;
@@ -707,7 +1182,9 @@ quint64 CTelegramConnection::contactsGetContacts(const QString &hash)
 
 quint64 CTelegramConnection::contactsGetStatuses()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsGetStatuses));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsGetStatuses;
     return sendEncryptedPackage(output);
@@ -715,7 +1192,10 @@ quint64 CTelegramConnection::contactsGetStatuses()
 
 quint64 CTelegramConnection::contactsGetSuggested(quint32 limit)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsGetSuggested));
+    payloadSize += CTelegramStream::serializedSize(limit);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsGetSuggested;
     outputStream << limit;
@@ -724,7 +1204,10 @@ quint64 CTelegramConnection::contactsGetSuggested(quint32 limit)
 
 quint64 CTelegramConnection::contactsImportCard(const TLVector<quint32> &exportCard)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsImportCard));
+    payloadSize += CTelegramStream::serializedSize(exportCard);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsImportCard;
     outputStream << exportCard;
@@ -733,7 +1216,11 @@ quint64 CTelegramConnection::contactsImportCard(const TLVector<quint32> &exportC
 
 quint64 CTelegramConnection::contactsImportContacts(const TLVector<TLInputContact> &contacts, bool replace)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsImportContacts));
+    payloadSize += CTelegramStream::serializedSize(contacts);
+    payloadSize += CTelegramStream::serializedSize(replace);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsImportContacts;
     outputStream << contacts;
@@ -743,7 +1230,10 @@ quint64 CTelegramConnection::contactsImportContacts(const TLVector<TLInputContac
 
 quint64 CTelegramConnection::contactsResolveUsername(const QString &username)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsResolveUsername));
+    payloadSize += CTelegramStream::serializedSize(username);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsResolveUsername;
     outputStream << username;
@@ -752,7 +1242,11 @@ quint64 CTelegramConnection::contactsResolveUsername(const QString &username)
 
 quint64 CTelegramConnection::contactsSearch(const QString &q, quint32 limit)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsSearch));
+    payloadSize += CTelegramStream::serializedSize(q);
+    payloadSize += CTelegramStream::serializedSize(limit);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsSearch;
     outputStream << q;
@@ -762,7 +1256,10 @@ quint64 CTelegramConnection::contactsSearch(const QString &q, quint32 limit)
 
 quint64 CTelegramConnection::contactsUnblock(const TLInputUser &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::ContactsUnblock));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::ContactsUnblock;
     outputStream << id;
@@ -771,7 +1268,13 @@ quint64 CTelegramConnection::contactsUnblock(const TLInputUser &id)
 
 quint64 CTelegramConnection::helpGetAppChangelog(const QString &deviceModel, const QString &systemVersion, const QString &appVersion, const QString &langCode)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::HelpGetAppChangelog));
+    payloadSize += CTelegramStream::serializedSize(deviceModel);
+    payloadSize += CTelegramStream::serializedSize(systemVersion);
+    payloadSize += CTelegramStream::serializedSize(appVersion);
+    payloadSize += CTelegramStream::serializedSize(langCode);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::HelpGetAppChangelog;
     outputStream << deviceModel;
@@ -783,7 +1286,13 @@ quint64 CTelegramConnection::helpGetAppChangelog(const QString &deviceModel, con
 
 quint64 CTelegramConnection::helpGetAppUpdate(const QString &deviceModel, const QString &systemVersion, const QString &appVersion, const QString &langCode)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::HelpGetAppUpdate));
+    payloadSize += CTelegramStream::serializedSize(deviceModel);
+    payloadSize += CTelegramStream::serializedSize(systemVersion);
+    payloadSize += CTelegramStream::serializedSize(appVersion);
+    payloadSize += CTelegramStream::serializedSize(langCode);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::HelpGetAppUpdate;
     outputStream << deviceModel;
@@ -795,7 +1304,9 @@ quint64 CTelegramConnection::helpGetAppUpdate(const QString &deviceModel, const
 
 quint64 CTelegramConnection::helpGetConfig()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::HelpGetConfig));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::HelpGetConfig;
     return sendEncryptedPackage(output);
@@ -803,7 +1314,10 @@ quint64 CTelegramConnection::helpGetConfig()
 
 quint64 CTelegramConnection::helpGetInviteText(const QString &langCode)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::HelpGetInviteText));
+    payloadSize += CTelegramStream::serializedSize(langCode);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::HelpGetInviteText;
     outputStream << langCode;
@@ -812,7 +1326,9 @@ quint64 CTelegramConnection::helpGetInviteText(const QString &langCode)
 
 quint64 CTelegramConnection::helpGetNearestDc()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::HelpGetNearestDc));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::HelpGetNearestDc;
     return sendEncryptedPackage(output);
@@ -820,7 +1336,9 @@ quint64 CTelegramConnection::helpGetNearestDc()
 
 quint64 CTelegramConnection::helpGetSupport()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::HelpGetSupport));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::HelpGetSupport;
     return sendEncryptedPackage(output);
@@ -828,7 +1346,10 @@ quint64 CTelegramConnection::helpGetSupport()
 
 quint64 CTelegramConnection::helpGetTermsOfService(const QString &langCode)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::HelpGetTermsOfService));
+    payloadSize += CTelegramStream::serializedSize(langCode);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::HelpGetTermsOfService;
     outputStream << langCode;
@@ -837,7 +1358,10 @@ quint64 CTelegramConnection::helpGetTermsOfService(const QString &langCode)
 
 quint64 CTelegramConnection::helpSaveAppLog(const TLVector<TLInputAppEvent> &events)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::HelpSaveAppLog));
+    payloadSize += CTelegramStream::serializedSize(events);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::HelpSaveAppLog;
     outputStream << events;
@@ -846,7 +1370,12 @@ quint64 CTelegramConnection::helpSaveAppLog(const TLVector<TLInputAppEvent> &eve
 
 quint64 CTelegramConnection::messagesAcceptEncryption(const TLInputEncryptedChat &peer, const QByteArray &gB, quint64 keyFingerprint)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesAcceptEncryption));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(gB);
+    payloadSize += CTelegramStream::serializedSize(keyFingerprint);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesAcceptEncryption;
     outputStream << peer;
@@ -857,7 +1386,12 @@ quint64 CTelegramConnection::messagesAcceptEncryption(const TLInputEncryptedChat
 
 quint64 CTelegramConnection::messagesAddChatUser(quint32 chatId, const TLInputUser &userId, quint32 fwdLimit)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesAddChatUser));
+    payloadSize += CTelegramStream::serializedSize(chatId);
+    payloadSize += CTelegramStream::serializedSize(userId);
+    payloadSize += CTelegramStream::serializedSize(fwdLimit);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesAddChatUser;
     outputStream << chatId;
@@ -868,7 +1402,10 @@ quint64 CTelegramConnection::messagesAddChatUser(quint32 chatId, const TLInputUs
 
 quint64 CTelegramConnection::messagesCheckChatInvite(const QString &hash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesCheckChatInvite));
+    payloadSize += CTelegramStream::serializedSize(hash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesCheckChatInvite;
     outputStream << hash;
@@ -877,7 +1414,11 @@ quint64 CTelegramConnection::messagesCheckChatInvite(const QString &hash)
 
 quint64 CTelegramConnection::messagesCreateChat(const TLVector<TLInputUser> &users, const QString &title)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesCreateChat));
+    payloadSize += CTelegramStream::serializedSize(users);
+    payloadSize += CTelegramStream::serializedSize(title);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesCreateChat;
     outputStream << users;
@@ -887,7 +1428,11 @@ quint64 CTelegramConnection::messagesCreateChat(const TLVector<TLInputUser> &use
 
 quint64 CTelegramConnection::messagesDeleteChatUser(quint32 chatId, const TLInputUser &userId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesDeleteChatUser));
+    payloadSize += CTelegramStream::serializedSize(chatId);
+    payloadSize += CTelegramStream::serializedSize(userId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesDeleteChatUser;
     outputStream << chatId;
@@ -897,7 +1442,11 @@ quint64 CTelegramConnection::messagesDeleteChatUser(quint32 chatId, const TLInpu
 
 quint64 CTelegramConnection::messagesDeleteHistory(const TLInputPeer &peer, quint32 maxId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesDeleteHistory));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(maxId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesDeleteHistory;
     outputStream << peer;
@@ -907,7 +1456,10 @@ quint64 CTelegramConnection::messagesDeleteHistory(const TLInputPeer &peer, quin
 
 quint64 CTelegramConnection::messagesDeleteMessages(const TLVector<quint32> &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesDeleteMessages));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesDeleteMessages;
     outputStream << id;
@@ -916,7 +1468,10 @@ quint64 CTelegramConnection::messagesDeleteMessages(const TLVector<quint32> &id)
 
 quint64 CTelegramConnection::messagesDiscardEncryption(quint32 chatId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesDiscardEncryption));
+    payloadSize += CTelegramStream::serializedSize(chatId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesDiscardEncryption;
     outputStream << chatId;
@@ -925,7 +1480,12 @@ quint64 CTelegramConnection::messagesDiscardEncryption(quint32 chatId)
 
 quint64 CTelegramConnection::messagesEditChatAdmin(quint32 chatId, const TLInputUser &userId, bool isAdmin)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesEditChatAdmin));
+    payloadSize += CTelegramStream::serializedSize(chatId);
+    payloadSize += CTelegramStream::serializedSize(userId);
+    payloadSize += CTelegramStream::serializedSize(isAdmin);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesEditChatAdmin;
     outputStream << chatId;
@@ -936,7 +1496,11 @@ quint64 CTelegramConnection::messagesEditChatAdmin(quint32 chatId, const TLInput
 
 quint64 CTelegramConnection::messagesEditChatPhoto(quint32 chatId, const TLInputChatPhoto &photo)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesEditChatPhoto));
+    payloadSize += CTelegramStream::serializedSize(chatId);
+    payloadSize += CTelegramStream::serializedSize(photo);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesEditChatPhoto;
     outputStream << chatId;
@@ -946,7 +1510,11 @@ quint64 CTelegramConnection::messagesEditChatPhoto(quint32 chatId, const TLInput
 
 quint64 CTelegramConnection::messagesEditChatTitle(quint32 chatId, const QString &title)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesEditChatTitle));
+    payloadSize += CTelegramStream::serializedSize(chatId);
+    payloadSize += CTelegramStream::serializedSize(title);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesEditChatTitle;
     outputStream << chatId;
@@ -956,7 +1524,10 @@ quint64 CTelegramConnection::messagesEditChatTitle(quint32 chatId, const QString
 
 quint64 CTelegramConnection::messagesExportChatInvite(quint32 chatId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesExportChatInvite));
+    payloadSize += CTelegramStream::serializedSize(chatId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesExportChatInvite;
     outputStream << chatId;
@@ -965,7 +1536,12 @@ quint64 CTelegramConnection::messagesExportChatInvite(quint32 chatId)
 
 quint64 CTelegramConnection::messagesForwardMessage(const TLInputPeer &peer, quint32 id, quint64 randomId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesForwardMessage));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(id);
+    payloadSize += CTelegramStream::serializedSize(randomId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesForwardMessage;
     outputStream << peer;
@@ -976,7 +1552,17 @@ quint64 CTelegramConnection::messagesForwardMessage(const TLInputPeer &peer, qui
 
 quint64 CTelegramConnection::messagesForwardMessages(quint32 flags, const TLInputPeer &fromPeer, const TLVector<quint32> &id, const TLVector<quint64> &randomId, const TLInputPeer &toPeer)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesForwardMessages));
+    payloadSize += CTelegramStream::serializedSize(flags);
+    if (flags & 1 << 4) {
+        payloadSize += CTelegramStream::serializedSize(TLTrue());
+    }
+    payloadSize += CTelegramStream::serializedSize(fromPeer);
+    payloadSize += CTelegramStream::serializedSize(id);
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    payloadSize += CTelegramStream::serializedSize(toPeer);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesForwardMessages;
     outputStream << flags;
@@ -992,7 +1578,10 @@ quint64 CTelegramConnection::messagesForwardMessages(quint32 flags, const TLInpu
 
 quint64 CTelegramConnection::messagesGetAllStickers(quint32 hash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetAllStickers));
+    payloadSize += CTelegramStream::serializedSize(hash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetAllStickers;
     outputStream << hash;
@@ -1001,7 +1590,10 @@ quint64 CTelegramConnection::messagesGetAllStickers(quint32 hash)
 
 quint64 CTelegramConnection::messagesGetChats(const TLVector<quint32> &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetChats));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetChats;
     outputStream << id;
@@ -1010,7 +1602,11 @@ quint64 CTelegramConnection::messagesGetChats(const TLVector<quint32> &id)
 
 quint64 CTelegramConnection::messagesGetDhConfig(quint32 version, quint32 randomLength)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetDhConfig));
+    payloadSize += CTelegramStream::serializedSize(version);
+    payloadSize += CTelegramStream::serializedSize(randomLength);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetDhConfig;
     outputStream << version;
@@ -1020,7 +1616,13 @@ quint64 CTelegramConnection::messagesGetDhConfig(quint32 version, quint32 random
 
 quint64 CTelegramConnection::messagesGetDialogs(quint32 offsetDate, quint32 offsetId, const TLInputPeer &offsetPeer, quint32 limit)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetDialogs));
+    payloadSize += CTelegramStream::serializedSize(offsetDate);
+    payloadSize += CTelegramStream::serializedSize(offsetId);
+    payloadSize += CTelegramStream::serializedSize(offsetPeer);
+    payloadSize += CTelegramStream::serializedSize(limit);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetDialogs;
     outputStream << offsetDate;
@@ -1032,7 +1634,12 @@ quint64 CTelegramConnection::messagesGetDialogs(quint32 offsetDate, quint32 offs
 
 quint64 CTelegramConnection::messagesGetDocumentByHash(const QByteArray &sha256, quint32 size, const QString &mimeType)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetDocumentByHash));
+    payloadSize += CTelegramStream::serializedSize(sha256);
+    payloadSize += CTelegramStream::serializedSize(size);
+    payloadSize += CTelegramStream::serializedSize(mimeType);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetDocumentByHash;
     outputStream << sha256;
@@ -1043,7 +1650,10 @@ quint64 CTelegramConnection::messagesGetDocumentByHash(const QByteArray &sha256,
 
 quint64 CTelegramConnection::messagesGetFullChat(quint32 chatId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetFullChat));
+    payloadSize += CTelegramStream::serializedSize(chatId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetFullChat;
     outputStream << chatId;
@@ -1052,7 +1662,15 @@ quint64 CTelegramConnection::messagesGetFullChat(quint32 chatId)
 
 quint64 CTelegramConnection::messagesGetHistory(const TLInputPeer &peer, quint32 offsetId, quint32 addOffset, quint32 limit, quint32 maxId, quint32 minId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetHistory));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(offsetId);
+    payloadSize += CTelegramStream::serializedSize(addOffset);
+    payloadSize += CTelegramStream::serializedSize(limit);
+    payloadSize += CTelegramStream::serializedSize(maxId);
+    payloadSize += CTelegramStream::serializedSize(minId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetHistory;
     outputStream << peer;
@@ -1066,7 +1684,12 @@ quint64 CTelegramConnection::messagesGetHistory(const TLInputPeer &peer, quint32
 
 quint64 CTelegramConnection::messagesGetInlineBotResults(const TLInputUser &bot, const QString &query, const QString &offset)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetInlineBotResults));
+    payloadSize += CTelegramStream::serializedSize(bot);
+    payloadSize += CTelegramStream::serializedSize(query);
+    payloadSize += CTelegramStream::serializedSize(offset);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetInlineBotResults;
     outputStream << bot;
@@ -1077,7 +1700,10 @@ quint64 CTelegramConnection::messagesGetInlineBotResults(const TLInputUser &bot,
 
 quint64 CTelegramConnection::messagesGetMessages(const TLVector<quint32> &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetMessages));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetMessages;
     outputStream << id;
@@ -1086,7 +1712,12 @@ quint64 CTelegramConnection::messagesGetMessages(const TLVector<quint32> &id)
 
 quint64 CTelegramConnection::messagesGetMessagesViews(const TLInputPeer &peer, const TLVector<quint32> &id, bool increment)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetMessagesViews));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(id);
+    payloadSize += CTelegramStream::serializedSize(increment);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetMessagesViews;
     outputStream << peer;
@@ -1097,7 +1728,10 @@ quint64 CTelegramConnection::messagesGetMessagesViews(const TLInputPeer &peer, c
 
 quint64 CTelegramConnection::messagesGetSavedGifs(quint32 hash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetSavedGifs));
+    payloadSize += CTelegramStream::serializedSize(hash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetSavedGifs;
     outputStream << hash;
@@ -1106,7 +1740,10 @@ quint64 CTelegramConnection::messagesGetSavedGifs(quint32 hash)
 
 quint64 CTelegramConnection::messagesGetStickerSet(const TLInputStickerSet &stickerset)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetStickerSet));
+    payloadSize += CTelegramStream::serializedSize(stickerset);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetStickerSet;
     outputStream << stickerset;
@@ -1115,7 +1752,11 @@ quint64 CTelegramConnection::messagesGetStickerSet(const TLInputStickerSet &stic
 
 quint64 CTelegramConnection::messagesGetStickers(const QString &emoticon, const QString &hash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetStickers));
+    payloadSize += CTelegramStream::serializedSize(emoticon);
+    payloadSize += CTelegramStream::serializedSize(hash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetStickers;
     outputStream << emoticon;
@@ -1125,7 +1766,10 @@ quint64 CTelegramConnection::messagesGetStickers(const QString &emoticon, const
 
 quint64 CTelegramConnection::messagesGetWebPagePreview(const QString &message)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesGetWebPagePreview));
+    payloadSize += CTelegramStream::serializedSize(message);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesGetWebPagePreview;
     outputStream << message;
@@ -1134,7 +1778,10 @@ quint64 CTelegramConnection::messagesGetWebPagePreview(const QString &message)
 
 quint64 CTelegramConnection::messagesImportChatInvite(const QString &hash)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesImportChatInvite));
+    payloadSize += CTelegramStream::serializedSize(hash);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesImportChatInvite;
     outputStream << hash;
@@ -1143,7 +1790,11 @@ quint64 CTelegramConnection::messagesImportChatInvite(const QString &hash)
 
 quint64 CTelegramConnection::messagesInstallStickerSet(const TLInputStickerSet &stickerset, bool disabled)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesInstallStickerSet));
+    payloadSize += CTelegramStream::serializedSize(stickerset);
+    payloadSize += CTelegramStream::serializedSize(disabled);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesInstallStickerSet;
     outputStream << stickerset;
@@ -1153,7 +1804,10 @@ quint64 CTelegramConnection::messagesInstallStickerSet(const TLInputStickerSet &
 
 quint64 CTelegramConnection::messagesMigrateChat(quint32 chatId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesMigrateChat));
+    payloadSize += CTelegramStream::serializedSize(chatId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesMigrateChat;
     outputStream << chatId;
@@ -1162,7 +1816,11 @@ quint64 CTelegramConnection::messagesMigrateChat(quint32 chatId)
 
 quint64 CTelegramConnection::messagesReadEncryptedHistory(const TLInputEncryptedChat &peer, quint32 maxDate)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesReadEncryptedHistory));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(maxDate);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesReadEncryptedHistory;
     outputStream << peer;
@@ -1172,7 +1830,11 @@ quint64 CTelegramConnection::messagesReadEncryptedHistory(const TLInputEncrypted
 
 quint64 CTelegramConnection::messagesReadHistory(const TLInputPeer &peer, quint32 maxId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesReadHistory));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(maxId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesReadHistory;
     outputStream << peer;
@@ -1182,7 +1844,10 @@ quint64 CTelegramConnection::messagesReadHistory(const TLInputPeer &peer, quint3
 
 quint64 CTelegramConnection::messagesReadMessageContents(const TLVector<quint32> &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesReadMessageContents));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesReadMessageContents;
     outputStream << id;
@@ -1191,7 +1856,10 @@ quint64 CTelegramConnection::messagesReadMessageContents(const TLVector<quint32>
 
 quint64 CTelegramConnection::messagesReceivedMessages(quint32 maxId)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesReceivedMessages));
+    payloadSize += CTelegramStream::serializedSize(maxId);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesReceivedMessages;
     outputStream << maxId;
@@ -1200,7 +1868,10 @@ quint64 CTelegramConnection::messagesReceivedMessages(quint32 maxId)
 
 quint64 CTelegramConnection::messagesReceivedQueue(quint32 maxQts)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesReceivedQueue));
+    payloadSize += CTelegramStream::serializedSize(maxQts);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesReceivedQueue;
     outputStream << maxQts;
@@ -1209,7 +1880,10 @@ quint64 CTelegramConnection::messagesReceivedQueue(quint32 maxQts)
 
 quint64 CTelegramConnection::messagesReorderStickerSets(const TLVector<quint64> &order)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesReorderStickerSets));
+    payloadSize += CTelegramStream::serializedSize(order);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesReorderStickerSets;
     outputStream << order;
@@ -1218,7 +1892,10 @@ quint64 CTelegramConnection::messagesReorderStickerSets(const TLVector<quint64>
 
 quint64 CTelegramConnection::messagesReportSpam(const TLInputPeer &peer)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesReportSpam));
+    payloadSize += CTelegramStream::serializedSize(peer);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesReportSpam;
     outputStream << peer;
@@ -1227,7 +1904,12 @@ quint64 CTelegramConnection::messagesReportSpam(const TLInputPeer &peer)
 
 quint64 CTelegramConnection::messagesRequestEncryption(const TLInputUser &userId, quint32 randomId, const QByteArray &gA)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesRequestEncryption));
+    payloadSize += CTelegramStream::serializedSize(userId);
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    payloadSize += CTelegramStream::serializedSize(gA);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesRequestEncryption;
     outputStream << userId;
@@ -1238,7 +1920,11 @@ quint64 CTelegramConnection::messagesRequestEncryption(const TLInputUser &userId
 
 quint64 CTelegramConnection::messagesSaveGif(const TLInputDocument &id, bool unsave)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSaveGif));
+    payloadSize += CTelegramStream::serializedSize(id);
+    payloadSize += CTelegramStream::serializedSize(unsave);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSaveGif;
     outputStream << id;
@@ -1248,7 +1934,21 @@ quint64 CTelegramConnection::messagesSaveGif(const TLInputDocument &id, bool uns
 
 quint64 CTelegramConnection::messagesSearch(quint32 flags, const TLInputPeer &peer, const QString &q, const TLMessagesFilter &filter, quint32 minDate, quint32 maxDate, quint32 offset, quint32 maxId, quint32 limit)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSearch));
+    payloadSize += CTelegramStream::serializedSize(flags);
+    if (flags & 1 << 0) {
+        payloadSize += CTelegramStream::serializedSize(TLTrue());
+    }
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(q);
+    payloadSize += CTelegramStream::serializedSize(filter);
+    payloadSize += CTelegramStream::serializedSize(minDate);
+    payloadSize += CTelegramStream::serializedSize(maxDate);
+    payloadSize += CTelegramStream::serializedSize(offset);
+    payloadSize += CTelegramStream::serializedSize(maxId);
+    payloadSize += CTelegramStream::serializedSize(limit);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSearch;
     outputStream << flags;
@@ -1268,7 +1968,11 @@ quint64 CTelegramConnection::messagesSearch(quint32 flags, const TLInputPeer &pe
 
 quint64 CTelegramConnection::messagesSearchGifs(const QString &q, quint32 offset)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSearchGifs));
+    payloadSize += CTelegramStream::serializedSize(q);
+    payloadSize += CTelegramStream::serializedSize(offset);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSearchGifs;
     outputStream << q;
@@ -1278,7 +1982,14 @@ quint64 CTelegramConnection::messagesSearchGifs(const QString &q, quint32 offset
 
 quint64 CTelegramConnection::messagesSearchGlobal(const QString &q, quint32 offsetDate, const TLInputPeer &offsetPeer, quint32 offsetId, quint32 limit)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSearchGlobal));
+    payloadSize += CTelegramStream::serializedSize(q);
+    payloadSize += CTelegramStream::serializedSize(offsetDate);
+    payloadSize += CTelegramStream::serializedSize(offsetPeer);
+    payloadSize += CTelegramStream::serializedSize(offsetId);
+    payloadSize += CTelegramStream::serializedSize(limit);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSearchGlobal;
     outputStream << q;
@@ -1291,7 +2002,13 @@ quint64 CTelegramConnection::messagesSearchGlobal(const QString &q, quint32 offs
 
 quint64 CTelegramConnection::messagesSendBroadcast(const TLVector<TLInputUser> &contacts, const TLVector<quint64> &randomId, const QString &message, const TLInputMedia &media)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSendBroadcast));
+    payloadSize += CTelegramStream::serializedSize(contacts);
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    payloadSize += CTelegramStream::serializedSize(message);
+    payloadSize += CTelegramStream::serializedSize(media);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSendBroadcast;
     outputStream << contacts;
@@ -1303,7 +2020,12 @@ quint64 CTelegramConnection::messagesSendBroadcast(const TLVector<TLInputUser> &
 
 quint64 CTelegramConnection::messagesSendEncrypted(const TLInputEncryptedChat &peer, quint64 randomId, const QByteArray &data)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSendEncrypted));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    payloadSize += CTelegramStream::serializedSize(data);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSendEncrypted;
     outputStream << peer;
@@ -1314,7 +2036,13 @@ quint64 CTelegramConnection::messagesSendEncrypted(const TLInputEncryptedChat &p
 
 quint64 CTelegramConnection::messagesSendEncryptedFile(const TLInputEncryptedChat &peer, quint64 randomId, const QByteArray &data, const TLInputEncryptedFile &file)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSendEncryptedFile));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    payloadSize += CTelegramStream::serializedSize(data);
+    payloadSize += CTelegramStream::serializedSize(file);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSendEncryptedFile;
     outputStream << peer;
@@ -1326,7 +2054,12 @@ quint64 CTelegramConnection::messagesSendEncryptedFile(const TLInputEncryptedCha
 
 quint64 CTelegramConnection::messagesSendEncryptedService(const TLInputEncryptedChat &peer, quint64 randomId, const QByteArray &data)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSendEncryptedService));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    payloadSize += CTelegramStream::serializedSize(data);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSendEncryptedService;
     outputStream << peer;
@@ -1337,7 +2070,20 @@ quint64 CTelegramConnection::messagesSendEncryptedService(const TLInputEncrypted
 
 quint64 CTelegramConnection::messagesSendInlineBotResult(quint32 flags, const TLInputPeer &peer, quint32 replyToMsgId, quint64 randomId, quint64 queryId, const QString &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSendInlineBotResult));
+    payloadSize += CTelegramStream::serializedSize(flags);
+    if (flags & 1 << 4) {
+        payloadSize += CTelegramStream::serializedSize(TLTrue());
+    }
+    payloadSize += CTelegramStream::serializedSize(peer);
+    if (flags & 1 << 0) {
+        payloadSize += CTelegramStream::serializedSize(replyToMsgId);
+    }
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    payloadSize += CTelegramStream::serializedSize(queryId);
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSendInlineBotResult;
     outputStream << flags;
@@ -1356,7 +2102,22 @@ quint64 CTelegramConnection::messagesSendInlineBotResult(quint32 flags, const TL
 
 quint64 CTelegramConnection::messagesSendMedia(quint32 flags, const TLInputPeer &peer, quint32 replyToMsgId, const TLInputMedia &media, quint64 randomId, const TLReplyMarkup &replyMarkup)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSendMedia));
+    payloadSize += CTelegramStream::serializedSize(flags);
+    if (flags & 1 << 4) {
+        payloadSize += CTelegramStream::serializedSize(TLTrue());
+    }
+    payloadSize += CTelegramStream::serializedSize(peer);
+    if (flags & 1 << 0) {
+        payloadSize += CTelegramStream::serializedSize(replyToMsgId);
+    }
+    payloadSize += CTelegramStream::serializedSize(media);
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    if (flags & 1 << 2) {
+        payloadSize += CTelegramStream::serializedSize(replyMarkup);
+    }
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSendMedia;
     outputStream << flags;
@@ -1377,7 +2138,28 @@ quint64 CTelegramConnection::messagesSendMedia(quint32 flags, const TLInputPeer
 
 quint64 CTelegramConnection::messagesSendMessage(quint32 flags, const TLInputPeer &peer, quint32 replyToMsgId, const QString &message, quint64 randomId, const TLReplyMarkup &replyMarkup, const TLVector<TLMessageEntity> &entities)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSendMessage));
+    payloadSize += CTelegramStream::serializedSize(flags);
+    if (flags & 1 << 1) {
+        payloadSize += CTelegramStream::serializedSize(TLTrue());
+    }
+    if (flags & 1 << 4) {
+        payloadSize += CTelegramStream::serializedSize(TLTrue());
+    }
+    payloadSize += CTelegramStream::serializedSize(peer);
+    if (flags & 1 << 0) {
+        payloadSize += CTelegramStream::serializedSize(replyToMsgId);
+    }
+    payloadSize += CTelegramStream::serializedSize(message);
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    if (flags & 1 << 2) {
+        payloadSize += CTelegramStream::serializedSize(replyMarkup);
+    }
+    if (flags & 1 << 3) {
+        payloadSize += CTelegramStream::serializedSize(entities);
+    }
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSendMessage;
     outputStream << flags;
@@ -1404,7 +2186,11 @@ quint64 CTelegramConnection::messagesSendMessage(quint32 flags, const TLInputPee
 
 quint64 CTelegramConnection::messagesSetEncryptedTyping(const TLInputEncryptedChat &peer, bool typing)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSetEncryptedTyping));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(typing);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSetEncryptedTyping;
     outputStream << peer;
@@ -1414,7 +2200,22 @@ quint64 CTelegramConnection::messagesSetEncryptedTyping(const TLInputEncryptedCh
 
 quint64 CTelegramConnection::messagesSetInlineBotResults(quint32 flags, quint64 queryId, const TLVector<TLInputBotInlineResult> &results, quint32 cacheTime, const QString &nextOffset)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSetInlineBotResults));
+    payloadSize += CTelegramStream::serializedSize(flags);
+    if (flags & 1 << 0) {
+        payloadSize += CTelegramStream::serializedSize(TLTrue());
+    }
+    if (flags & 1 << 1) {
+        payloadSize += CTelegramStream::serializedSize(TLTrue());
+    }
+    payloadSize += CTelegramStream::serializedSize(queryId);
+    payloadSize += CTelegramStream::serializedSize(results);
+    payloadSize += CTelegramStream::serializedSize(cacheTime);
+    if (flags & 1 << 2) {
+        payloadSize += CTelegramStream::serializedSize(nextOffset);
+    }
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSetInlineBotResults;
     outputStream << flags;
@@ -1435,7 +2236,11 @@ quint64 CTelegramConnection::messagesSetInlineBotResults(quint32 flags, quint64
 
 quint64 CTelegramConnection::messagesSetTyping(const TLInputPeer &peer, const TLSendMessageAction &action)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesSetTyping));
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(action);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesSetTyping;
     outputStream << peer;
@@ -1445,7 +2250,13 @@ quint64 CTelegramConnection::messagesSetTyping(const TLInputPeer &peer, const TL
 
 quint64 CTelegramConnection::messagesStartBot(const TLInputUser &bot, const TLInputPeer &peer, quint64 randomId, const QString &startParam)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesStartBot));
+    payloadSize += CTelegramStream::serializedSize(bot);
+    payloadSize += CTelegramStream::serializedSize(peer);
+    payloadSize += CTelegramStream::serializedSize(randomId);
+    payloadSize += CTelegramStream::serializedSize(startParam);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesStartBot;
     outputStream << bot;
@@ -1457,7 +2268,11 @@ quint64 CTelegramConnection::messagesStartBot(const TLInputUser &bot, const TLIn
 
 quint64 CTelegramConnection::messagesToggleChatAdmins(quint32 chatId, bool enabled)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesToggleChatAdmins));
+    payloadSize += CTelegramStream::serializedSize(chatId);
+    payloadSize += CTelegramStream::serializedSize(enabled);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesToggleChatAdmins;
     outputStream << chatId;
@@ -1467,7 +2282,10 @@ quint64 CTelegramConnection::messagesToggleChatAdmins(quint32 chatId, bool enabl
 
 quint64 CTelegramConnection::messagesUninstallStickerSet(const TLInputStickerSet &stickerset)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::MessagesUninstallStickerSet));
+    payloadSize += CTelegramStream::serializedSize(stickerset);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::MessagesUninstallStickerSet;
     outputStream << stickerset;
@@ -1476,7 +2294,13 @@ quint64 CTelegramConnection::messagesUninstallStickerSet(const TLInputStickerSet
 
 quint64 CTelegramConnection::updatesGetChannelDifference(const TLInputChannel &channel, const TLChannelMessagesFilter &filter, quint32 pts, quint32 limit)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::UpdatesGetChannelDifference));
+    payloadSize += CTelegramStream::serializedSize(channel);
+    payloadSize += CTelegramStream::serializedSize(filter);
+    payloadSize += CTelegramStream::serializedSize(pts);
+    payloadSize += CTelegramStream::serializedSize(limit);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::UpdatesGetChannelDifference;
     outputStream << channel;
@@ -1488,7 +2312,12 @@ quint64 CTelegramConnection::updatesGetChannelDifference(const TLInputChannel &c
 
 quint64 CTelegramConnection::updatesGetDifference(quint32 pts, quint32 date, quint32 qts)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::UpdatesGetDifference));
+    payloadSize += CTelegramStream::serializedSize(pts);
+    payloadSize += CTelegramStream::serializedSize(date);
+    payloadSize += CTelegramStream::serializedSize(qts);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::UpdatesGetDifference;
     outputStream << pts;
@@ -1499,7 +2328,9 @@ quint64 CTelegramConnection::updatesGetDifference(quint32 pts, quint32 date, qui
 
 quint64 CTelegramConnection::updatesGetState()
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::UpdatesGetState));
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::UpdatesGetState;
     return sendEncryptedPackage(output);
@@ -1507,7 +2338,12 @@ quint64 CTelegramConnection::updatesGetState()
 
 quint64 CTelegramConnection::uploadGetFile(const TLInputFileLocation &location, quint32 offset, quint32 limit)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::UploadGetFile));
+    payloadSize += CTelegramStream::serializedSize(location);
+    payloadSize += CTelegramStream::serializedSize(offset);
+    payloadSize += CTelegramStream::serializedSize(limit);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::UploadGetFile;
     outputStream << location;
@@ -1518,7 +2354,13 @@ quint64 CTelegramConnection::uploadGetFile(const TLInputFileLocation &location,
 
 quint64 CTelegramConnection::uploadSaveBigFilePart(quint64 fileId, quint32 filePart, quint32 fileTotalParts, const QByteArray &bytes)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::UploadSaveBigFilePart));
+    payloadSize += CTelegramStream::serializedSize(fileId);
+    payloadSize += CTelegramStream::serializedSize(filePart);
+    payloadSize += CTelegramStream::serializedSize(fileTotalParts);
+    payloadSize += CTelegramStream::serializedSize(bytes);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::UploadSaveBigFilePart;
     outputStream << fileId;
@@ -1530,7 +2372,12 @@ quint64 CTelegramConnection::uploadSaveBigFilePart(quint64 fileId, quint32 fileP
 
 quint64 CTelegramConnection::uploadSaveFilePart(quint64 fileId, quint32 filePart, const QByteArray &bytes)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::UploadSaveFilePart));
+    payloadSize += CTelegramStream::serializedSize(fileId);
+    payloadSize += CTelegramStream::serializedSize(filePart);
+    payloadSize += CTelegramStream::serializedSize(bytes);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::UploadSaveFilePart;
     outputStream << fileId;
@@ -1541,7 +2388,10 @@ quint64 CTelegramConnection::uploadSaveFilePart(quint64 fileId, quint32 filePart
 
 quint64 CTelegramConnection::usersGetFullUser(const TLInputUser &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::UsersGetFullUser));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::UsersGetFullUser;
     outputStream << id;
@@ -1550,7 +2400,10 @@ quint64 CTelegramConnection::usersGetFullUser(const TLInputUser &id)
 
 quint64 CTelegramConnection::usersGetUsers(const TLVector<TLInputUser> &id)
 {
+    int payloadSize = CTelegramStream::serializedSize(TLValue(TLValue::UsersGetUsers));
+    payloadSize += CTelegramStream::serializedSize(id);
     QByteArray output;
+    output.reserve(payloadSize);
     CTelegramStream outputStream(&output, /* write */ true);
     outputStream << TLValue::UsersGetUsers;
     outputStream << id;
@@ -1562,6 +2415,7 @@ quint64 CTelegramConnection::usersGetUsers(const TLVector<TLInputUser> &id)
 quint64 CTelegramConnection::ping()
 {
 //    qDebug() << Q_FUNC_INFO;
+    QMutexLocker locker(&m_mutex);
     QByteArray output;
     CTelegramStream outputStream(&output, /* write */ true);
 
@@ -1632,24 +2486,9 @@ bool CTelegramConnection::answerPqAuthorization(const QByteArray &payload)
         return false;
     }
 
+    // The pq is factorized by requestDhParameters()
     m_pq = qFromBigEndian<quint64>((uchar *) pq.data());
 
-    quint64 div1 = Utils::findDivider(m_pq);
-
-    if (div1 == 1) {
-        qDebug() << "Error: Can not solve PQ.";
-        return false;
-    }
-    quint64 div2 = m_pq / div1;
-
-    if (div1 < div2) {
-        m_p = div1;
-        m_q = div2;
-    } else {
-        m_p = div2;
-        m_q = div1;
-    }
-
     TLVector<quint64> fingersprints;
 
     inputStream >> fingersprints;
@@ -1669,64 +2508,121 @@ bool CTelegramConnection::answerPqAuthorization(const QByteArray &payload)
     return true;
 }
 
+// The computation must not touch the connection members, as it runs in a pool thread.
+// The continuation is called in the connection thread, unless the handshake is restarted meanwhile.
+template <typename Result>
+void CTelegramConnection::runHandshakeStep(const std::function<Result()> &computation, const std::function<void(const Result &)> &continuation)
+{
+    const quint32 generation = m_handshakeGeneration;
+
+    QFutureWatcher<Result> *watcher = new QFutureWatcher<Result>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation, continuation]() {
+        watcher->deleteLater();
+
+        QMutexLocker locker(&m_mutex);
+        if (generation != m_handshakeGeneration) {
+            return;
+        }
+
+        continuation(watcher->result());
+    });
+
+    watcher->setFuture(QtConcurrent::run(computation));
+}
+
 void CTelegramConnection::requestDhParameters()
 {
     Utils::randomBytes(m_newNonce.data, m_newNonce.size());
 
-    QByteArray bigEndianNumber;
-    bigEndianNumber.fill(char(0), 8);
+    const quint64 pq = m_pq;
+    const TLNumber128 clientNonce = m_clientNonce;
+    const TLNumber128 serverNonce = m_serverNonce;
+    const TLNumber256 newNonce = m_newNonce;
+    const quint32 tempAuthKeyLifetime = m_tempAuthKeyLifetime;
+    const SRsaKey rsaKey = m_rsaKey;
+
+    // The pq factorization and the RSA encryption are done in the thread pool
+    runHandshakeStep<SDhParametersRequest>([=]() {
+        SDhParametersRequest request;
+
+        const quint64 div1 = Utils::findDivider(pq);
+        if (div1 == 1) {
+            return request;
+        }
+        const quint64 div2 = pq / div1;
+
+        request.p = quint32(qMin(div1, div2));
+        request.q = quint32(qMax(div1, div2));
 
-    QByteArray encryptedPackage;
-    {
         static const int requestedEncryptedPackageLength = 255;
+
+        QByteArray bigEndianNumber;
+        bigEndianNumber.fill(char(0), 8);
+
         QByteArray innerData;
         CTelegramStream encryptedStream(&innerData, /* write */ true);
 
-        encryptedStream << TLValue::PQInnerData;
+        encryptedStream << (tempAuthKeyLifetime ? TLValue::PQInnerDataTemp : TLValue::PQInnerData);
 
-        qToBigEndian(m_pq, (uchar *) bigEndianNumber.data());
+        qToBigEndian(pq, (uchar *) bigEndianNumber.data());
         encryptedStream << bigEndianNumber;
 
         bigEndianNumber.fill(char(0), 4);
-        qToBigEndian(m_p, (uchar *) bigEndianNumber.data());
+        qToBigEndian(request.p, (uchar *) bigEndianNumber.data());
         encryptedStream << bigEndianNumber;
 
-        qToBigEndian(m_q, (uchar *) bigEndianNumber.data());
+        qToBigEndian(request.q, (uchar *) bigEndianNumber.data());
         encryptedStream << bigEndianNumber;
 
-        encryptedStream << m_clientNonce;
-        encryptedStream << m_serverNonce;
-        encryptedStream << m_newNonce;
+        encryptedStream << clientNonce;
+        encryptedStream << serverNonce;
+        encryptedStream << newNonce;
+
+        if (tempAuthKeyLifetime) {
+            encryptedStream << tempAuthKeyLifetime;
+        }
 
         QByteArray sha = Utils::sha1(innerData);
         QByteArray randomPadding;
         randomPadding.resize(requestedEncryptedPackageLength - (sha.length() + innerData.length()));
         Utils::randomBytes(&randomPadding);
 
-        encryptedPackage = Utils::rsa(sha + innerData + randomPadding, m_rsaKey);
-    }
+        request.encryptedPackage = Utils::rsa(sha + innerData + randomPadding, rsaKey);
 
-    QByteArray output;
-    CTelegramStream outputStream(&output, /* write */ true);
+        return request;
+    }, [this](const SDhParametersRequest &request) {
+        if (request.encryptedPackage.isEmpty()) {
+            qDebug() << "Error: Can not solve PQ.";
+            return;
+        }
 
-    outputStream << TLValue::ReqDHParams;
-    outputStream << m_clientNonce;
-    outputStream << m_serverNonce;
+        m_p = request.p;
+        m_q = request.q;
 
-    bigEndianNumber.fill(char(0), 4);
-    qToBigEndian(m_p, (uchar *) bigEndianNumber.data());
-    outputStream << bigEndianNumber;
+        QByteArray bigEndianNumber;
+        bigEndianNumber.fill(char(0), 4);
 
-    qToBigEndian(m_q, (uchar *) bigEndianNumber.data());
-    outputStream << bigEndianNumber;
+        QByteArray output;
+        CTelegramStream outputStream(&output, /* write */ true);
 
-    outputStream << m_serverPublicFingersprint;
+        outputStream << TLValue::ReqDHParams;
+        outputStream << m_clientNonce;
+        outputStream << m_serverNonce;
 
-    outputStream << encryptedPackage;
+        qToBigEndian(m_p, (uchar *) bigEndianNumber.data());
+        outputStream << bigEndianNumber;
 
-    sendPlainPackage(output);
+        qToBigEndian(m_q, (uchar *) bigEndianNumber.data());
+        outputStream << bigEndianNumber;
 
-    setAuthState(AuthStateDhRequested);
+        outputStream << m_serverPublicFingersprint;
+
+        outputStream << request.encryptedPackage;
+
+        sendPlainPackage(output);
+
+        setAuthState(AuthStateDhRequested);
+    });
 }
 
 bool CTelegramConnection::answerDh(const QByteArray &payload)
@@ -1830,6 +2726,32 @@ bool CTelegramConnection::answerDh(const QByteArray &payload)
 }
 
 void CTelegramConnection::requestDhGenerationResult()
+{
+    QByteArray binNumber;
+    binNumber.resize(sizeof(m_g));
+    qToBigEndian(m_g, (uchar *) binNumber.data());
+
+    const quint32 g = m_g;
+    const QByteArray dhPrime = m_dhPrime;
+    const QByteArray b = m_b;
+
+    // The DH parameters check and g_b are computed in the thread pool.
+    // The safe prime check is expensive, but it is done only once per prime in the process.
+    runHandshakeStep<QByteArray>([=]() {
+        if (!Utils::checkDhParameters(dhPrime, g)) {
+            return QByteArray();
+        }
+        return Utils::binaryNumberModExp(binNumber, dhPrime, b);
+    }, [this](const QByteArray &gB) {
+        if (gB.isEmpty()) {
+            qDebug() << "Error: Received DH prime or generator is not valid.";
+            return;
+        }
+        sendDhGenerationResult(gB);
+    });
+}
+
+void CTelegramConnection::sendDhGenerationResult(const QByteArray &gB)
 {
     QByteArray output;
     CTelegramStream outputStream(&output, /* write */ true);
@@ -1848,29 +2770,19 @@ void CTelegramConnection::requestDhGenerationResult()
         encryptedStream << m_clientNonce;
         encryptedStream << m_serverNonce;
         encryptedStream << m_authRetryId;
+        encryptedStream << gB;
 
-        QByteArray binNumber;
-        binNumber.resize(sizeof(m_g));
-        qToBigEndian(m_g, (uchar *) binNumber.data());
-
-        binNumber = Utils::binaryNumberModExp(binNumber, m_dhPrime, m_b);
+        // sha1(innerData) + innerData + padding, encrypted in place
+        encryptedPackage = Utils::sha1(innerData);
+        encryptedPackage.append(innerData);
 
-        encryptedStream << binNumber;
-
-        QByteArray sha = Utils::sha1(innerData);
-        QByteArray randomPadding;
-
-        int packageLength = sha.length() + innerData.length();
-        if ((packageLength) % 16) {
-            randomPadding.resize(16 - (packageLength % 16));
-            Utils::randomBytes(&randomPadding);
-
-            packageLength += randomPadding.size();
+        if (encryptedPackage.size() % 16) {
+            const int paddingLength = 16 - (encryptedPackage.size() % 16);
+            encryptedPackage.resize(encryptedPackage.size() + paddingLength);
+            Utils::randomBytes(encryptedPackage.data() + encryptedPackage.size() - paddingLength, paddingLength);
         }
 
-        encryptedPackage = Utils::aesEncrypt(sha + innerData + randomPadding, m_tmpAesKey);
-
-        encryptedPackage.truncate(packageLength);
+        CAesIgeCipher(m_tmpAesKey, CAesIgeCipher::Encryption).process(encryptedPackage.data(), encryptedPackage.size());
     }
 
     outputStream << encryptedPackage;
@@ -1879,7 +2791,26 @@ void CTelegramConnection::requestDhGenerationResult()
     setAuthState(AuthStateDhGenerationResultRequested);
 }
 
+void CTelegramConnection::startAuthKeyComputation(const QByteArray &payload)
+{
+    const QByteArray gA = m_gA;
+    const QByteArray dhPrime = m_dhPrime;
+    const QByteArray b = m_b;
+
+    // The auth key is computed in the thread pool, while the answer is verified afterwards
+    runHandshakeStep<QByteArray>([=]() {
+        return Utils::binaryNumberModExp(gA, dhPrime, b);
+    }, [this, payload](const QByteArray &newAuthKey) {
+        processServersDHAnswer(payload, newAuthKey);
+    });
+}
+
 bool CTelegramConnection::processServersDHAnswer(const QByteArray &payload)
+{
+    return processServersDHAnswer(payload, Utils::binaryNumberModExp(m_gA, m_dhPrime, m_b));
+}
+
+bool CTelegramConnection::processServersDHAnswer(const QByteArray &payload, const QByteArray &newAuthKey)
 {
     CTelegramStream inputStream(payload);
 
@@ -1911,8 +2842,6 @@ bool CTelegramConnection::processServersDHAnswer(const QByteArray &payload)
 
     QByteArray expectedHashData(m_newNonce.data, m_newNonce.size());
 
-    QByteArray newAuthKey = Utils::binaryNumberModExp(m_gA, m_dhPrime, m_b);
-
     expectedHashData.append(Utils::sha1(newAuthKey).left(8));
 
     if (responseTLValue == TLValue::DhGenOk) {
@@ -1927,6 +2856,10 @@ bool CTelegramConnection::processServersDHAnswer(const QByteArray &payload)
         setAuthKey(newAuthKey);
         m_serverSalt = m_serverNonce.parts[0] ^ m_newNonce.parts[0];
 
+        if (m_tempAuthKeyLifetime) {
+            m_authKeyExpiresAt = QDateTime::currentMSecsSinceEpoch() / 1000 + m_deltaTime + m_tempAuthKeyLifetime;
+        }
+
         setAuthState(AuthStateHaveAKey);
         return true;
     } else if (responseTLValue == TLValue::DhGenRetry) {
@@ -2049,7 +2982,8 @@ void CTelegramConnection::processRpcResult(CTelegramStream &stream, quint64 idHi
         stream >> id;
     }
 
-    RpcProcessingContext context(stream, id, m_submittedPackages.value(id));
+    const QByteArray requestData = (id && (id == m_bindingMessageId)) ? m_bindingRequest : m_submittedPackages.value(id);
+    RpcProcessingContext context(stream, id, requestData);
     if (context.hasRequestData()) {
         if (!context.requestType().isValid()) {
             qWarning() << Q_FUNC_INFO << "Invalid request type from the saved package. Package with id" << id << "ignored.";
@@ -2477,6 +3411,11 @@ bool CTelegramConnection::processRpcError(CTelegramStream &stream, quint64 id, T
     qDebug() << Q_FUNC_INFO << QString(QLatin1String("RPC Error %1: %2 for message %3 %4 (dc %5|%6:%7)"))
                 .arg(errorCode).arg(errorMessage).arg(id).arg(request.toString()).arg(m_dcInfo.id).arg(m_dcInfo.ipAddress).arg(m_dcInfo.port);
 
+    if (request == TLValue::AuthBindTempAuthKey) {
+        clearTempAuthKeyBinding();
+        emit tempAuthKeyBindingFinished(false);
+    }
+
     switch (errorCode) {
     case 303: // ERROR_SEE_OTHER
         if (processErrorSeeOther(errorMessage, id)) {
@@ -2908,10 +3847,12 @@ void CTelegramConnection::processAccountUpdateUsername(RpcProcessingContext *con
 
 void CTelegramConnection::processAuthBindTempAuthKey(RpcProcessingContext *context)
 {
-    qWarning() << Q_FUNC_INFO << "Is not implemented yet";
     TLValue result; // bool
     context->inputStream() >> result;
     context->setReadCode(result);
+
+    clearTempAuthKeyBinding();
+    emit tempAuthKeyBindingFinished(result == TLValue::BoolTrue);
 }
 
 void CTelegramConnection::processAuthCheckPassword(RpcProcessingContext *context)
@@ -3691,6 +4632,7 @@ void CTelegramConnection::processAuthSign(RpcProcessingContext *context)
         qDebug() << Q_FUNC_INFO << "AuthAuthorization" << maskPhoneNumber(result.user.phone);
         emit selfUserReceived(result.user);
         emit usersReceived(QVector<TLUser>() << result.user);
+        m_authKeyAuthorized = true;
         setAuthState(AuthStateSignedIn);
     }
 }
@@ -3790,7 +4732,7 @@ void CTelegramConnection::onTransportStateChanged()
         if (m_authKey.isEmpty()) {
             initAuth();
         } else {
-            setAuthState(AuthStateSignedIn);
+            setAuthState(m_authKeyAuthorized ? AuthStateSignedIn : AuthStateHaveAKey);
         }
 
         setStatus(ConnectionStatusConnected);
@@ -3805,7 +4747,12 @@ void CTelegramConnection::onTransportStateChanged()
 
 void CTelegramConnection::onTransportReadyRead()
 {
-    QByteArray input = m_transport->getPackage();
+    QMutexLocker locker(&m_mutex);
+
+    // The package is decrypted in place, so the input must not be used as the original data afterwards
+    int inputSize = 0;
+    char *inputData = m_transport->getMutablePackage(&inputSize);
+    const QByteArray input = QByteArray::fromRawData(inputData, inputSize);
     CRawStream inputStream(input);
 
     quint64 auth = 0;
@@ -3841,7 +4788,7 @@ void CTelegramConnection::onTransportReadyRead()
             }
             break;
         case AuthStateDhGenerationResultRequested:
-            processServersDHAnswer(payload);
+            startAuthKeyComputation(payload);
             break;
         default:
             break;
@@ -3851,7 +4798,10 @@ void CTelegramConnection::onTransportReadyRead()
             qWarning() << Q_FUNC_INFO << "Unexpected message with auth data";
         }
 
-        if (auth != m_authId) {
+        // The answers to the requests of the previous session are encrypted with the previous key
+        const bool previousKey = m_previousAuthId && (auth == m_previousAuthId) && (auth != messageAuthId());
+
+        if ((auth != messageAuthId()) && !previousKey) {
             qDebug() << Q_FUNC_INFO << "Incorrect auth id.";
 
 #ifdef NETWORK_LOGGING
@@ -3869,49 +4819,69 @@ void CTelegramConnection::onTransportReadyRead()
             return;
         }
         // Encrypted Message
-        const QByteArray messageKey = inputStream.readBytes(16);
-        const QByteArray data = inputStream.readBytes(inputStream.bytesRemaining());
+        // quint64 auth id, 16 bytes of message key, encrypted data (at least 32 bytes of header and a multiple of 16)
+        static const int outerHeaderLength = 8 + 16;
+        static const int headerLength = 8 + 8 + 8 + 4 + 4;
+
+        if ((inputSize < outerHeaderLength + headerLength) || ((inputSize - outerHeaderLength) % 16)) {
+            qDebug() << Q_FUNC_INFO << "Corrupted encrypted package. Unexpected size:" << inputSize;
+            return;
+        }
 
-        const SAesKey key = generateServerToClientAesKey(messageKey);
+        const char *messageKey = inputData + 8;
+        char *decryptedData = inputData + outerHeaderLength;
+        const int decryptedLength = inputSize - outerHeaderLength;
 
-        QByteArray decryptedData = Utils::aesDecrypt(data, key).left(data.length());
-        CRawStream decryptedStream(decryptedData);
+        SFixedAesKey key;
+        if (previousKey) {
+            generateAesKey(&key, m_previousAuthKey.constData(), messageKey, 8);
+        } else {
+            generateServerToClientAesKey(&key, messageKey);
+        }
 
-        quint64 sessionId = 0;
-        quint64 messageId  = 0;
-        quint32 sequence = 0;
-        quint32 contentLength = 0;
+        // Do not block the requests from other threads during the decryption
+        locker.unlock();
+        const bool decrypted = CAesIgeCipher(key, CAesIgeCipher::Decryption).process(decryptedData, decryptedLength);
+        locker.relock();
 
-        decryptedStream >> m_receivedServerSalt;
-        decryptedStream >> sessionId;
-        decryptedStream >> messageId;
-        decryptedStream >> sequence;
-        decryptedStream >> contentLength;
+        if (!decrypted) {
+            qDebug() << Q_FUNC_INFO << "Unable to decrypt the package.";
+            return;
+        }
+
+        const uchar *header = reinterpret_cast<const uchar *>(decryptedData);
+        m_receivedServerSalt = qFromLittleEndian<quint64>(header);
+        const quint64 sessionId = qFromLittleEndian<quint64>(header + 8);
+        // quint64 message id and quint32 sequence number are not used yet
+        const quint32 contentLength = qFromLittleEndian<quint32>(header + 28);
 
         if (m_serverSalt != m_receivedServerSalt) {
             qDebug() << Q_FUNC_INFO << "Received different server salt:" << m_receivedServerSalt << "(remote) vs" << m_serverSalt << "(local)";
 //            return;
         }
 
-        if (m_sessionId != sessionId) {
+        if ((previousKey ? m_previousSessionId : m_sessionId) != sessionId) {
             qDebug() << Q_FUNC_INFO << "Session Id is wrong.";
             return;
         }
 
-        if (int(contentLength) > decryptedData.length()) {
+        if (contentLength > quint32(decryptedLength - headerLength)) {
             qDebug() << Q_FUNC_INFO << "Expected data length is more, than actual.";
             return;
         }
 
-        const int headerLength = sizeof(m_receivedServerSalt) + sizeof(sessionId) + sizeof(messageId) + sizeof(sequence) + sizeof(contentLength);
-        QByteArray expectedMessageKey = Utils::sha1(decryptedData.left(headerLength + contentLength)).mid(4);
+        // The message key is the lower 128 bits of the SHA1 of the header and content (without the padding)
+        uchar expectedMessageKey[20];
+        m_sha1Context.addData(decryptedData, headerLength + contentLength);
+        m_sha1Context.result(expectedMessageKey);
 
-        if (messageKey != expectedMessageKey) {
+        if (memcmp(messageKey, expectedMessageKey + 4, 16) != 0) {
             qDebug() << Q_FUNC_INFO << "Wrong message key";
             return;
         }
 
-        payload = decryptedStream.readRemainingBytes();
+        // Non-owning view over the transport buffer. It is valid only within this handler.
+        payload = QByteArray::fromRawData(decryptedData + headerLength, contentLength);
 
         processRpcQuery(payload);
     }
@@ -3934,6 +4904,27 @@ void CTelegramConnection::onTransportTimeout()
     setStatus(ConnectionStatusDisconnected, ConnectionStatusReasonTimeout);
 }
 
+void CTelegramConnection::onTransportSendBufferFullChanged(bool full)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_sendBufferFull == full) {
+            return;
+        }
+        m_sendBufferFull = full;
+    }
+
+    emit sendBufferFullChanged(full);
+}
+
+void CTelegramConnection::onPreviousAuthKeyExpired()
+{
+    QMutexLocker locker(&m_mutex);
+    m_previousAuthKey.clear();
+    m_previousAuthId = 0;
+    m_previousSessionId = 0;
+}
+
 void CTelegramConnection::onTimeToPing()
 {
 //    qDebug() << Q_FUNC_INFO << QDateTime::currentMSecsSinceEpoch();
@@ -3966,33 +4957,56 @@ void CTelegramConnection::onTimeToAckMessages()
 
 SAesKey CTelegramConnection::generateTmpAesKey() const
 {
-    QByteArray newNonceAndServerNonce;
-    newNonceAndServerNonce.append(m_newNonce.data, m_newNonce.size());
-    newNonceAndServerNonce.append(m_serverNonce.data, m_serverNonce.size());
-    QByteArray serverNonceAndNewNonce;
-    serverNonceAndNewNonce.append(m_serverNonce.data, m_serverNonce.size());
-    serverNonceAndNewNonce.append(m_newNonce.data, m_newNonce.size());
-    QByteArray newNonceAndNewNonce;
-    newNonceAndNewNonce.append(m_newNonce.data, m_newNonce.size());
-    newNonceAndNewNonce.append(m_newNonce.data, m_newNonce.size());
+    const QByteArray newNonce = QByteArray::fromRawData(m_newNonce.data, m_newNonce.size());
+    const QByteArray serverNonce = QByteArray::fromRawData(m_serverNonce.data, m_serverNonce.size());
+    const QByteArray serverNonceAndNewNonceSha = Utils::sha1({serverNonce, newNonce});
 
-    const QByteArray key = Utils::sha1(newNonceAndServerNonce) + Utils::sha1(serverNonceAndNewNonce).mid(0, 12);
-    const QByteArray iv  = Utils::sha1(serverNonceAndNewNonce).mid(12, 8) + Utils::sha1(newNonceAndNewNonce) + QByteArray(m_newNonce.data, 4);
+    const QByteArray key = Utils::sha1({newNonce, serverNonce}) + serverNonceAndNewNonceSha.mid(0, 12);
+    const QByteArray iv  = serverNonceAndNewNonceSha.mid(12, 8) + Utils::sha1({newNonce, newNonce}) + QByteArray(m_newNonce.data, 4);
 
     return SAesKey(key, iv);
 }
 
 SAesKey CTelegramConnection::generateAesKey(const QByteArray &messageKey, int x) const
 {
-    QByteArray sha1_a = Utils::sha1(messageKey + m_authKey.mid(x, 32));
-    QByteArray sha1_b = Utils::sha1(m_authKey.mid(32 + x, 16) + messageKey + m_authKey.mid(48 + x, 16));
-    QByteArray sha1_c = Utils::sha1(m_authKey.mid(64 + x, 32) + messageKey);
-    QByteArray sha1_d = Utils::sha1(messageKey + m_authKey.mid(96 + x, 32));
+    SFixedAesKey key;
+    generateAesKey(&key, messageAuthKey().constData(), messageKey.constData(), x);
+    return key.toAesKey();
+}
+
+// The auth key slices are hashed in place, so there are no allocations. The messageKey is 16 bytes long.
+void CTelegramConnection::generateAesKey(SFixedAesKey *key, const char *authKey, const char *messageKey, int x) const
+{
+    uchar sha1_a[20];
+    uchar sha1_b[20];
+    uchar sha1_c[20];
+    uchar sha1_d[20];
 
-    const QByteArray key = sha1_a.mid(0, 8) + sha1_b.mid(8, 12) + sha1_c.mid(4, 12);
-    const QByteArray iv  = sha1_a.mid(8, 12) + sha1_b.mid(0, 8) + sha1_c.mid(16, 4) + sha1_d.mid(0, 8);
+    m_sha1Context.addData(messageKey, 16);
+    m_sha1Context.addData(authKey + x, 32);
+    m_sha1Context.result(sha1_a);
 
-    return SAesKey(key, iv);
+    m_sha1Context.addData(authKey + 32 + x, 16);
+    m_sha1Context.addData(messageKey, 16);
+    m_sha1Context.addData(authKey + 48 + x, 16);
+    m_sha1Context.result(sha1_b);
+
+    m_sha1Context.addData(authKey + 64 + x, 32);
+    m_sha1Context.addData(messageKey, 16);
+    m_sha1Context.result(sha1_c);
+
+    m_sha1Context.addData(messageKey, 16);
+    m_sha1Context.addData(authKey + 96 + x, 32);
+    m_sha1Context.result(sha1_d);
+
+    memcpy(key->key, sha1_a, 8);
+    memcpy(key->key + 8, sha1_b + 8, 12);
+    memcpy(key->key + 20, sha1_c + 4, 12);
+
+    memcpy(key->iv, sha1_a + 8, 12);
+    memcpy(key->iv + 12, sha1_b, 8);
+    memcpy(key->iv + 20, sha1_c + 16, 4);
+    memcpy(key->iv + 24, sha1_d, 8);
 }
 
 void CTelegramConnection::insertInitConnection(QByteArray *data) const
@@ -4016,6 +5030,7 @@ void CTelegramConnection::insertInitConnection(QByteArray *data) const
 
 quint64 CTelegramConnection::sendPlainPackage(const QByteArray &buffer)
 {
+    QMutexLocker locker(&m_mutex);
     quint64 messageId = newMessageId();
 
     QByteArray output;
@@ -4026,7 +5041,7 @@ quint64 CTelegramConnection::sendPlainPackage(const QByteArray &buffer)
     outputStream << quint32(buffer.length());
     outputStream << buffer;
 
-    m_transport->sendPackage(output);
+    sendPackage(output);
 
 #ifdef NETWORK_LOGGING
     CTelegramStream readBack(buffer);
@@ -4049,60 +5064,63 @@ quint64 CTelegramConnection::sendPlainPackage(const QByteArray &buffer)
 
 quint64 CTelegramConnection::sendEncryptedPackage(const QByteArray &buffer, bool savePackage)
 {
-    QByteArray encryptedPackage;
-    QByteArray messageKey;
-    quint64 messageId = newMessageId();
-    {
-        m_sequenceNumber = m_contentRelatedMessages * 2 + 1;
-        ++m_contentRelatedMessages;
-
-        if (savePackage) {
-            // Story only content-related messages
-            m_submittedPackages.insert(messageId, buffer);
-        }
-
-        QByteArray innerData;
-        CRawStream stream(&innerData, /* write */ true);
-
-        stream << m_serverSalt;
-        stream << m_sessionId;
-        stream << messageId;
-        stream << m_sequenceNumber;
-
-        QByteArray header;
-        if (m_sequenceNumber == 1) {
-            insertInitConnection(&header);
-        }
-
-        stream << quint32(header.length() + buffer.length());
-        stream << header + buffer;
-
-        messageKey = Utils::sha1(innerData).mid(4);
-        const SAesKey key = generateClientToServerAesKey(messageKey);
-
-        quint32 packageLength = innerData.length();
-
-        if ((packageLength) % 16) {
-            QByteArray randomPadding;
-            randomPadding.resize(16 - (packageLength % 16));
-            Utils::randomBytes(&randomPadding);
+    QMutexLocker locker(&m_mutex);
+    return sendEncryptedPackage(buffer, newMessageId(), savePackage, /* initConnectionAllowed */ true);
+}
 
-            packageLength += randomPadding.size();
+quint64 CTelegramConnection::sendEncryptedPackage(const QByteArray &buffer, quint64 messageId, bool savePackage, bool initConnectionAllowed)
+{
+    QMutexLocker locker(&m_mutex);
 
-            stream << randomPadding;
-        }
+    m_sequenceNumber = m_contentRelatedMessages * 2 + 1;
+    ++m_contentRelatedMessages;
 
-        encryptedPackage = Utils::aesEncrypt(innerData, key).left(packageLength);
+    if (savePackage) {
+        // Story only content-related messages
+        m_submittedPackages.insert(messageId, buffer);
     }
 
-    QByteArray output;
-    CRawStream outputStream(&output, /* write */ true);
-
-    outputStream << m_authId;
-    outputStream << messageKey;
-    outputStream << encryptedPackage;
+    QByteArray header;
+    if ((m_sequenceNumber == 1) && initConnectionAllowed) {
+        insertInitConnection(&header);
+    }
 
-    m_transport->sendPackage(output);
+    // The whole package is built in one buffer of the final size and the body is encrypted in place:
+    // quint64 auth id, 16 bytes of message key, encrypted body:
+    //     quint64 server salt, quint64 session id, quint64 message id, quint32 sequence number,
+    //     quint32 content length, content (header + buffer), random padding to a multiple of 16
+    static const int outerHeaderLength = 8 + 16;
+    static const int innerHeaderLength = 8 + 8 + 8 + 4 + 4;
+    const int contentLength = header.length() + buffer.length();
+    const int innerLength = innerHeaderLength + contentLength;
+    const int paddingLength = (16 - innerLength % 16) % 16;
+
+    QByteArray output(outerHeaderLength + innerLength + paddingLength, Qt::Uninitialized);
+    char *messageKey = output.data() + 8;
+    char *innerData = messageKey + 16;
+
+    qToLittleEndian<quint64>(messageAuthId(), reinterpret_cast<uchar *>(output.data()));
+    qToLittleEndian<quint64>(m_serverSalt, reinterpret_cast<uchar *>(innerData));
+    qToLittleEndian<quint64>(m_sessionId, reinterpret_cast<uchar *>(innerData + 8));
+    qToLittleEndian<quint64>(messageId, reinterpret_cast<uchar *>(innerData + 16));
+    qToLittleEndian<quint32>(m_sequenceNumber, reinterpret_cast<uchar *>(innerData + 24));
+    qToLittleEndian<quint32>(contentLength, reinterpret_cast<uchar *>(innerData + 28));
+    memcpy(innerData + innerHeaderLength, header.constData(), header.length());
+    memcpy(innerData + innerHeaderLength + header.length(), buffer.constData(), buffer.length());
+    Utils::randomBytes(innerData + innerLength, paddingLength);
+
+    // The message key is the lower 128 bits of the SHA1 of the body without the padding
+    uchar sha[20];
+    m_sha1Context.addData(innerData, innerLength);
+    m_sha1Context.result(sha);
+    memcpy(messageKey, sha + 4, 16);
+
+    SFixedAesKey key;
+    generateClientToServerAesKey(&key, messageKey);
+    CAesIgeCipher(key, CAesIgeCipher::Encryption).process(innerData, innerLength + paddingLength);
+
+    // The transport writes its framing separately, so the buffer goes to the socket without another copy
+    sendPackage(output);
 
 #ifdef NETWORK_LOGGING
     CTelegramStream readBack(buffer);
@@ -4129,7 +5147,14 @@ quint64 CTelegramConnection::sendEncryptedPackage(const QByteArray &buffer, bool
 
 quint64 CTelegramConnection::sendEncryptedPackageAgain(quint64 id)
 {
+    QMutexLocker locker(&m_mutex);
     --m_contentRelatedMessages;
+
+    if (id && (id == m_bindingMessageId)) {
+        // The inner message must have the same id as the outer one, so the binding message is encrypted again
+        qDebug() << Q_FUNC_INFO << "Rebuild the temporary key binding" << id;
+        return bindTempAuthKey(m_bindingPermanentAuthKey);
+    }
     const QByteArray data = m_submittedPackages.take(id);
 #ifdef DEVELOPER_BUILD
     TLValue firstValue = TLValue::firstFromArray(data);
@@ -4138,8 +5163,34 @@ quint64 CTelegramConnection::sendEncryptedPackageAgain(quint64 id)
     return sendEncryptedPackage(data);
 }
 
+void CTelegramConnection::clearTempAuthKeyBinding()
+{
+    m_bindingPermanentAuthKey.clear();
+    m_bindingRequest.clear();
+    m_bindingMessageId = 0;
+}
+
+void CTelegramConnection::sendPackage(const QByteArray &package)
+{
+    if (QThread::currentThread() == m_transport->thread()) {
+        m_transport->sendPackage(package);
+    } else {
+        // Requests from the dispatcher thread are encrypted there, but written by the connection thread.
+        // The queued bytes are not in the transport buffer yet, so they are checked against the watermark here.
+        QMutexLocker locker(&m_mutex);
+        const int queuedBytes = m_transport->queuePackage(package);
+        const qint64 highWatermark = m_transportOptions.sendBufferHighWatermark;
+
+        if (highWatermark && (queuedBytes >= highWatermark) && !m_sendBufferFull) {
+            m_sendBufferFull = true;
+            emit sendBufferFullChanged(true);
+        }
+    }
+}
+
 void CTelegramConnection::setStatus(ConnectionStatus status, ConnectionStatusReason reason)
 {
+    QMutexLocker locker(&m_mutex);
     if (m_status == status) {
         return;
     }
@@ -4154,11 +5205,17 @@ void CTelegramConnection::setStatus(ConnectionStatus status, ConnectionStatusRea
 
 void CTelegramConnection::setAuthState(CTelegramConnection::AuthState newState)
 {
+    QMutexLocker locker(&m_mutex);
     if (m_authState == newState)
         return;
 
     m_authState = newState;
 
+    if (m_authState == AuthStateNone) {
+        // Drop the results of the previous handshake computations
+        ++m_handshakeGeneration;
+    }
+
     if ((m_authState >= AuthStateHaveAKey) && !m_sessionId) {
         Utils::randomBytes(&m_sessionId);
     }
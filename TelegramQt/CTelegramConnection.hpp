@@ -22,17 +22,21 @@
 #include <QByteArray>
 #include <QVector>
 #include <QMap>
+#include <QMutex>
 #include <QStringList>
 
+#include <functional>
+
 #include "TelegramNamespace.hpp"
 #include "TLTypes.hpp"
 #include "TLNumbers.hpp"
 #include "crypto-rsa.hpp"
 #include "crypto-aes.hpp"
+#include "CTelegramTransport.hpp" // STransportOptions is a Q_INVOKABLE argument
+#include "Utils.hpp" // CHashContext member
 
 class CAppInformation;
 class CTelegramStream;
-class CTelegramTransport;
 class RpcProcessingContext;
 
 #ifdef NETWORK_LOGGING
@@ -82,15 +86,51 @@ public:
 
     explicit CTelegramConnection(const CAppInformation *appInfo, QObject *parent = 0);
 
+    // Registers the signal argument types, which are needed for a connection in a worker thread.
+    static void registerTypes();
+
     void setDcInfo(const TLDcOption &newDcInfo);
 
-    TLDcOption dcInfo() const { return m_dcInfo; }
+    TLDcOption dcInfo() const;
+
+    // The protocol option replaces the built-in TCP or HTTP transport, if the connection is not active
+    Q_INVOKABLE void setTransportOptions(const STransportOptions &options);
+    STransportOptions transportOptions() const;
+
+    CTelegramTransport *transport() const { return m_transport; }
+    // The connection takes ownership of the transport. The previous transport is deleted.
+    void setTransport(CTelegramTransport *newTransport);
+
+    // Overrides the hardcoded Telegram server key (e.g. for a local server)
+    SRsaKey serverRsaKey() const { return m_rsaKey; }
+    void setServerRsaKey(const SRsaKey &key) { m_rsaKey = key; }
+
+    // Temporary auth keys (perfect forward secrecy).
+    // If the lifetime (sec) is set, the key generation produces a temporary key, which expires at authKeyExpiresAt() (server time).
+    quint32 tempAuthKeyLifetime() const { return m_tempAuthKeyLifetime; }
+    void setTempAuthKeyLifetime(quint32 lifetime) { m_tempAuthKeyLifetime = lifetime; }
+    quint32 authKeyExpiresAt() const { return m_authKeyExpiresAt; }
+
+    // Binds the temporary key of this connection to the permanent one. It must be the first message of the session.
+    // The result is reported by tempAuthKeyBindingFinished().
+    quint64 bindTempAuthKey(const QByteArray &permanentAuthKey);
+
+    // Switches the encryption of the next messages to the (bound) temporary key in a new session. The authKey() is kept as is.
+    // The answers to the requests, which were sent with the previous key, are still accepted.
+    Q_INVOKABLE void setTempAuthKey(const QByteArray &tempAuthKey, quint64 serverSalt);
+    QByteArray tempAuthKey() const;
 
 public slots:
     void connectToDc();
 
 public:
-    ConnectionStatus status() const { return m_status; }
+    // The state getters lock the mutex, so they can be called from any thread.
+    // The RPC methods encrypt the request under the mutex and pass it to the connection thread.
+    ConnectionStatus status() const;
+
+    // Reflects CTelegramTransport::isSendBufferFull(), including the packages queued from other threads.
+    // Uploads should wait for sendBufferFullChanged(false).
+    bool isSendBufferFull() const;
 
     static quint64 formatTimeStamp(qint64 timeInMs);
     static quint64 formatClientTimeStamp(qint64 timeInMs) { return formatTimeStamp(timeInMs) & ~quint64(3); }
@@ -243,14 +283,17 @@ public:
     quint64 sendMessage(const TLInputPeer &peer, const QString &message, quint64 randomMessageId);
     quint64 sendMedia(const TLInputPeer &peer, const TLInputMedia &media, quint64 randomMessageId);
 
-    AuthState authState() { return m_authState; }
+    AuthState authState() const;
 
     void requestPqAuthorization();
     bool answerPqAuthorization(const QByteArray &payload);
     void requestDhParameters();
     bool answerDh(const QByteArray &payload);
     void requestDhGenerationResult();
+    void sendDhGenerationResult(const QByteArray &gB);
+    void startAuthKeyComputation(const QByteArray &payload);
     bool processServersDHAnswer(const QByteArray &payload);
+    bool processServersDHAnswer(const QByteArray &payload, const QByteArray &newAuthKey);
 
     TLNumber128 clientNonce() const { return m_clientNonce; }
     TLNumber128 serverNonce() const { return m_serverNonce; }
@@ -261,17 +304,21 @@ public:
 
     quint64 serverPublicFingersprint() const { return m_serverPublicFingersprint; }
 
-    QByteArray authKey() const { return m_authKey; }
+    QByteArray authKey() const;
     void setAuthKey(const QByteArray &newAuthKey);
-    quint64 authId() const { return m_authId; }
+    quint64 authId() const;
+
+    // A key, which is not authorized yet (e.g. a pre-generated one), brings the connection to AuthStateHaveAKey
+    // instead of AuthStateSignedIn, so it can be signed in with the auth import. The keys are authorized by default.
+    void setAuthKeyAuthorized(bool authorized);
 
-    quint64 serverSalt() const { return m_serverSalt; }
-    void setServerSalt(const quint64 salt) { m_serverSalt = salt; }
-    quint64 sessionId() const { return m_sessionId; }
+    quint64 serverSalt() const;
+    void setServerSalt(const quint64 salt);
+    quint64 sessionId() const;
 
-    QVector<TLDcOption> dcConfiguration() const { return m_dcConfiguration; }
+    QVector<TLDcOption> dcConfiguration() const;
 
-    qint32 deltaTime() const { return m_deltaTime; }
+    qint32 deltaTime() const;
     void setDeltaTime(const qint32 newDt);
 
     void processRedirectedPackage(const QByteArray &data);
@@ -297,6 +344,8 @@ signals:
     void contactListChanged(const QVector<quint32> &added, const QVector<quint32> &removed);
     void fileDataReceived(const TLUploadFile &file, quint32 requestId, quint32 offset);
     void fileDataSent(quint32 requestId);
+    void sendBufferFullChanged(bool full);
+    void tempAuthKeyBindingFinished(bool bound);
 
     void messagesChatsReceived(const QVector<TLChat> &chats);
     void messagesFullChatReceived(const TLChatFull &chat, const QVector<TLChat> &chats, const QVector<TLUser> &users);
@@ -448,19 +497,33 @@ protected:
     SAesKey generateClientToServerAesKey(const QByteArray &messageKey) const;
     SAesKey generateServerToClientAesKey(const QByteArray &messageKey) const;
 
+    void generateClientToServerAesKey(SFixedAesKey *key, const char *messageKey) const;
+    void generateServerToClientAesKey(SFixedAesKey *key, const char *messageKey) const;
+
     SAesKey generateAesKey(const QByteArray &messageKey, int xValue) const;
+    void generateAesKey(SFixedAesKey *key, const char *authKey, const char *messageKey, int xValue) const;
+
+    // The key and id, which are used for the message encryption: the temporary key, if it is set, or the permanent one
+    const QByteArray &messageAuthKey() const { return m_tempAuthKey.isEmpty() ? m_authKey : m_tempAuthKey; }
+    quint64 messageAuthId() const { return m_tempAuthKey.isEmpty() ? m_authId : m_tempAuthId; }
 
     void insertInitConnection(QByteArray *data) const;
 
     quint64 sendPlainPackage(const QByteArray &buffer);
     quint64 sendEncryptedPackage(const QByteArray &buffer, bool savePackage = true);
+    // The message id must be obtained by newMessageId(). If initConnectionAllowed is false, the first message is not wrapped.
+    quint64 sendEncryptedPackage(const QByteArray &buffer, quint64 messageId, bool savePackage, bool initConnectionAllowed);
     quint64 sendEncryptedPackageAgain(quint64 id);
-
-    void setTransport(CTelegramTransport *newTransport);
+    void clearTempAuthKeyBinding();
+    void sendPackage(const QByteArray &package);
 
     void setStatus(ConnectionStatus status, ConnectionStatusReason reason = ConnectionStatusReasonNone);
     void setAuthState(AuthState newState);
 
+    // Runs the heavy handshake math (pq factorization, RSA, DH) in the thread pool and continues in the connection thread
+    template <typename Result>
+    void runHandshakeStep(const std::function<Result()> &computation, const std::function<void(const Result &)> &continuation);
+
     quint64 newMessageId();
 
     QString userNameFromPackage(quint64 id) const;
@@ -477,17 +540,25 @@ protected slots:
     void onTransportStateChanged();
     void onTransportReadyRead();
     void onTransportTimeout();
+    void onTransportSendBufferFullChanged(bool full);
     void onTimeToPing();
     void onTimeToAckMessages();
+    void onPreviousAuthKeyExpired();
 
 protected:
+    // Guards the session state, which is accessed by the dispatcher thread if the connection lives in a worker thread.
+    mutable QMutex m_mutex;
+
+    mutable CHashContext m_sha1Context; // Reused by the per-message hashing to avoid allocations
     ConnectionStatus m_status;
+    bool m_sendBufferFull;
     const CAppInformation *m_appInfo;
 
     QMap<quint64, QByteArray> m_submittedPackages; // <message id, package data>
     QMap<quint64, quint32> m_requestedFilesIds; // <message id, file id>
 
     CTelegramTransport *m_transport;
+    STransportOptions m_transportOptions;
     QTimer *m_authTimer;
     QTimer *m_pingTimer;
     QTimer *m_ackTimer;
@@ -495,6 +566,7 @@ protected:
     AuthState m_authState;
 
     QByteArray m_authKey;
+    bool m_authKeyAuthorized;
     quint64 m_authId;
     quint64 m_authKeyAuxHash;
     quint64 m_serverSalt;
@@ -533,6 +605,22 @@ protected:
     QByteArray m_b;
 
     quint64 m_authRetryId;
+    quint32 m_handshakeGeneration;
+
+    quint32 m_tempAuthKeyLifetime;
+    quint32 m_authKeyExpiresAt;
+    QByteArray m_tempAuthKey;
+    quint64 m_tempAuthId;
+    // The key of the previous session, which is still accepted for the answers until the timer expires
+    QByteArray m_previousAuthKey;
+    quint64 m_previousAuthId;
+    quint64 m_previousSessionId;
+    QTimer *m_previousAuthKeyTimer;
+    // The binding request is not kept in m_submittedPackages: its inner message carries the outer message id,
+    // so a resend builds the whole request again with a new id.
+    QByteArray m_bindingPermanentAuthKey;
+    QByteArray m_bindingRequest;
+    quint64 m_bindingMessageId;
 
     TLDcOption m_dcInfo;
 
@@ -556,4 +644,14 @@ inline SAesKey CTelegramConnection::generateServerToClientAesKey(const QByteArra
     return generateAesKey(messageKey, 8);
 }
 
+inline void CTelegramConnection::generateClientToServerAesKey(SFixedAesKey *key, const char *messageKey) const
+{
+    generateAesKey(key, messageAuthKey().constData(), messageKey, 0);
+}
+
+inline void CTelegramConnection::generateServerToClientAesKey(SFixedAesKey *key, const char *messageKey) const
+{
+    generateAesKey(key, messageAuthKey().constData(), messageKey, 8);
+}
+
 #endif // CTELEGRAMCONNECTION_HPP
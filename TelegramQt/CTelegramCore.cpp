@@ -23,6 +23,7 @@
 #include "CTelegramDispatcher.hpp"
 #include "CTelegramAuthModule.hpp"
 #include "CTelegramMediaModule.hpp"
+#include "Utils.hpp"
 
 class CTelegramCore::Private
 {
@@ -150,6 +151,16 @@ quint32 CTelegramCore::defaultPingInterval()
     return CTelegramDispatcher::defaultPingInterval();
 }
 
+QByteArray CTelegramCore::dhPrimeCacheData()
+{
+    return Utils::dhPrimeCacheData();
+}
+
+bool CTelegramCore::setDhPrimeCacheData(const QByteArray &data)
+{
+    return Utils::setDhPrimeCacheData(data);
+}
+
 QByteArray CTelegramCore::connectionSecretInfo() const
 {
     return m_private->m_dispatcher->connectionSecretInfo();
@@ -382,6 +393,36 @@ void CTelegramCore::setMediaDataBufferSize(quint32 size)
     m_private->m_mediaModule->setMediaDataBufferSize(size);
 }
 
+void CTelegramCore::setConnectionThreadsEnabled(bool enable)
+{
+    m_private->m_dispatcher->setConnectionThreadsEnabled(enable);
+}
+
+void CTelegramCore::setParallelConnectionAttempts(int count, quint32 attemptDelay)
+{
+    m_private->m_dispatcher->setParallelConnectionAttempts(count, attemptDelay);
+}
+
+void CTelegramCore::setAuthKeyPreGenerationEnabled(bool enable)
+{
+    m_private->m_dispatcher->setAuthKeyPreGenerationEnabled(enable);
+}
+
+void CTelegramCore::setTempAuthKeyLifetime(quint32 lifetime)
+{
+    m_private->m_dispatcher->setTempAuthKeyLifetime(lifetime);
+}
+
+bool CTelegramCore::setMainTransportOptions(const STransportOptions &options)
+{
+    return m_private->m_dispatcher->setMainTransportOptions(options);
+}
+
+void CTelegramCore::setExtraTransportOptions(const STransportOptions &options)
+{
+    m_private->m_dispatcher->setExtraTransportOptions(options);
+}
+
 QString CTelegramCore::selfPhone() const
 {
     return m_private->m_dispatcher->selfPhone();
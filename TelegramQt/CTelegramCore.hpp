@@ -20,6 +20,7 @@
 
 #include "telegramqt_global.h"
 #include "TelegramNamespace.hpp"
+#include "STransportOptions.hpp"
 
 #include <QObject>
 #include <QVector>
@@ -49,6 +50,11 @@ public:
     Q_INVOKABLE static QVector<Telegram::DcOption> builtInDcs();
     Q_INVOKABLE static quint32 defaultPingInterval();
 
+    // The validated DH primes. Save the data along with the connection secret and restore it before the connection,
+    // so the (slow) prime checks are not repeated after restart. The data must come from a trusted storage.
+    Q_INVOKABLE static QByteArray dhPrimeCacheData();
+    Q_INVOKABLE static bool setDhPrimeCacheData(const QByteArray &data);
+
     QByteArray connectionSecretInfo() const;
 
     Q_INVOKABLE TelegramNamespace::ConnectionState connectionState() const;
@@ -82,6 +88,25 @@ public Q_SLOTS:
     void setPingInterval(quint32 interval, quint32 serverDisconnectionAdditionTime = 10000);
     void setMediaDataBufferSize(quint32 size);
 
+    // Each connection runs its network I/O, encryption and parsing in a worker thread. Affects only the new connections.
+    void setConnectionThreadsEnabled(bool enable);
+
+    // Connect to up to count of the initConnection() addresses at once, starting each next attempt after attemptDelay ms
+    // (or once the previous attempt failed). The first connected address is used. By default the addresses are tried one by one.
+    void setParallelConnectionAttempts(int count, quint32 attemptDelay = 250);
+
+    // Generate the auth keys for all DCs right after the sign in, so the first file request to a DC skips the key exchange.
+    void setAuthKeyPreGenerationEnabled(bool enable);
+
+    // Use the temporary auth keys (perfect forward secrecy) with the given lifetime (sec), renewed in background. Zero disables them.
+    void setTempAuthKeyLifetime(quint32 lifetime);
+
+    // Socket tuning, framing and protocol of the main connection and of the extra (e.g. media) connections.
+    // The options are applied to the existing connections, the buffer sizes and the protocol take effect on the next connection.
+    // HTTP is media-only: the main connection refuses it and returns false.
+    bool setMainTransportOptions(const STransportOptions &options);
+    void setExtraTransportOptions(const STransportOptions &options);
+
     bool initConnection(const QVector<Telegram::DcOption> &dcs = QVector<Telegram::DcOption>()); // Uses builtin dc options by default
     bool restoreConnection(const QByteArray &secret);
     void closeConnection();
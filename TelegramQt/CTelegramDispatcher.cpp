@@ -21,12 +21,15 @@
 #include "TelegramNamespace_p.hpp"
 #include "CTelegramConnection.hpp"
 #include "CTelegramModule.hpp"
+#include "CTempAuthKeyManager.hpp"
+#include "CAuthKeyGenerator.hpp"
 #include "CRawStream.hpp"
 #include "Utils.hpp"
 #include "TelegramUtils.hpp"
 
 using namespace TelegramUtils;
 
+#include <QThread>
 #include <QTimer>
 
 #include <QCryptographicHash>
@@ -45,6 +48,10 @@ static const QVector<Telegram::DcOption> s_builtInDcs = QVector<Telegram::DcOpti
         << Telegram::DcOption(QLatin1String("91.108.56.165")  , 443);
 
 static const quint32 s_defaultPingInterval = 15000; // 15 sec
+static const quint32 s_defaultConnectionAttemptDelay = 250; // The "Connection Attempt Delay" recommended by RFC 8305
+static const int s_connectionAttemptsRestartDelay = 1000; // Do not spin if no address is reachable at all
+static const qint64 s_defaultExtraConnectionSendBufferHighWatermark = 512 * 1024; // A few file parts in flight
+static const qint64 s_defaultExtraConnectionSendBufferLowWatermark = 128 * 1024;
 
 const quint32 secretFormatVersion = 3;
 const int s_userTypingActionPeriod = 6000; // 6 sec
@@ -66,12 +73,19 @@ CTelegramDispatcher::CTelegramDispatcher(QObject *parent) :
     m_messageReceivingFilterFlags(TelegramNamespace::MessageFlagRead),
     m_acceptableMessageTypes(TelegramNamespace::MessageTypeAll),
     m_autoReconnectionEnabled(false),
+    m_connectionThreadsEnabled(false),
+    m_parallelConnectionAttempts(1),
+    m_connectionAttemptDelay(s_defaultConnectionAttemptDelay),
+    m_authKeyPreGenerationEnabled(false),
+    m_tempAuthKeyLifetime(0),
     m_pingInterval(s_defaultPingInterval),
     m_initializationState(0),
     m_requestedSteps(0),
     m_wantedActiveDc(0),
     m_autoConnectionDcIndex(s_autoConnectionIndexInvalid),
     m_mainConnection(0),
+    m_connectionAttemptTimer(new QTimer(this)),
+    m_authKeyGenerator(0),
     m_updateRequestId(0),
     m_updatesStateIsLocked(false),
     m_selfUserId(0),
@@ -80,11 +94,25 @@ CTelegramDispatcher::CTelegramDispatcher(QObject *parent) :
 {
     m_typingUpdateTimer->setSingleShot(true);
     connect(m_typingUpdateTimer, SIGNAL(timeout()), SLOT(messageActionTimerTimeout()));
+
+    m_connectionAttemptTimer->setSingleShot(true);
+    connect(m_connectionAttemptTimer, SIGNAL(timeout()), SLOT(startConnectionAttempt()));
+
+    // Main connection carries interactive traffic, so do not delay small packages.
+    m_mainTransportOptions.noDelay = true;
+    m_extraTransportOptions.sendBufferHighWatermark = s_defaultExtraConnectionSendBufferHighWatermark;
+    m_extraTransportOptions.sendBufferLowWatermark = s_defaultExtraConnectionSendBufferLowWatermark;
 }
 
 CTelegramDispatcher::~CTelegramDispatcher()
 {
     closeConnection();
+
+    // The connections are already scheduled for deletion, which is processed on the thread exit.
+    foreach (QThread *thread, findChildren<QThread *>(QString(), Qt::FindDirectChildrenOnly)) {
+        thread->quit();
+        thread->wait();
+    }
 }
 
 void CTelegramDispatcher::plugModule(CTelegramModule *module)
@@ -263,6 +291,51 @@ void CTelegramDispatcher::setPingInterval(quint32 ms, quint32 serverDisconnectio
     m_pingServerAdditionDisconnectionTime = serverDisconnectionAdditionTime;
 }
 
+void CTelegramDispatcher::setParallelConnectionAttempts(int count, quint32 attemptDelay)
+{
+    m_parallelConnectionAttempts = qMax(count, 1);
+    m_connectionAttemptDelay = attemptDelay;
+}
+
+void CTelegramDispatcher::setAuthKeyPreGenerationEnabled(bool enabled)
+{
+    m_authKeyPreGenerationEnabled = enabled;
+
+    if (m_connectionState >= TelegramNamespace::ConnectionStateAuthenticated) {
+        preGenerateAuthKeys();
+    }
+}
+
+bool CTelegramDispatcher::setMainTransportOptions(const STransportOptions &options)
+{
+    if (options.protocol == STransportOptions::ProtocolHttp) {
+        // No http_wait long poll is kept, so the updates would arrive only with the answers to our own requests
+        qWarning() << Q_FUNC_INFO << "HTTP is supported only for the extra connections.";
+        return false;
+    }
+
+    m_mainTransportOptions = options;
+
+    if (m_mainConnection) {
+        m_mainConnection->setTransportOptions(options);
+    }
+
+    return true;
+}
+
+void CTelegramDispatcher::setExtraTransportOptions(const STransportOptions &options)
+{
+    m_extraTransportOptions = options;
+
+    foreach (CTelegramConnection *connection, m_extraConnections) {
+        connection->setTransportOptions(options);
+    }
+
+    if (m_authKeyGenerator) {
+        m_authKeyGenerator->setTransportOptions(options);
+    }
+}
+
 bool CTelegramDispatcher::initConnection(const QVector<Telegram::DcOption> &dcs)
 {
     if (!dcs.isEmpty()) {
@@ -284,6 +357,13 @@ void CTelegramDispatcher::tryNextDcAddress()
         return;
     }
 
+    if (m_parallelConnectionAttempts > 1) {
+        clearMainConnection();
+        initConnectionSharedFinal();
+        startConnectionAttempt();
+        return;
+    }
+
     ++m_autoConnectionDcIndex;
 
     qDebug() << "CTelegramDispatcher::tryNextBuiltInDcAddress(): Dc index" << m_autoConnectionDcIndex;
@@ -304,10 +384,75 @@ void CTelegramDispatcher::tryNextDcAddress()
     dcInfo.port = m_connectionAddresses.at(m_autoConnectionDcIndex).port;
 
     clearMainConnection();
-    m_mainConnection = createConnection(dcInfo);
+    m_mainConnection = createConnection(dcInfo, m_mainTransportOptions);
     initConnectionSharedFinal();
 }
 
+// Happy eyeballs: the next address is tried once the previous attempt has been running for the
+// m_connectionAttemptDelay or has failed, so an unreachable address does not hold the others for the whole
+// transport timeout. The first attempt that connects becomes the main connection, the rest are dropped.
+void CTelegramDispatcher::startConnectionAttempt()
+{
+    m_connectionAttemptTimer->stop();
+
+    if (m_connectionAttempts.count() >= m_parallelConnectionAttempts) {
+        return;
+    }
+
+    if (m_autoConnectionDcIndex + 1 >= m_connectionAddresses.count()) {
+        if (!m_connectionAttempts.isEmpty()) {
+            return; // Wait for the running attempts
+        }
+
+        if (m_autoReconnectionEnabled) {
+            qDebug() << Q_FUNC_INFO << "Could not connect to any known dc. Reconnection enabled -> wrapping up and trying again.";
+            m_autoConnectionDcIndex = s_autoConnectionIndexInvalid;
+            m_connectionAttemptTimer->start(s_connectionAttemptsRestartDelay);
+        } else {
+            qDebug() << Q_FUNC_INFO << "Could not connect to any known dc. Giving up.";
+            setConnectionState(TelegramNamespace::ConnectionStateDisconnected);
+        }
+        return;
+    }
+
+    ++m_autoConnectionDcIndex;
+
+    qDebug() << Q_FUNC_INFO << "Dc index" << m_autoConnectionDcIndex;
+
+    TLDcOption dcInfo;
+    dcInfo.ipAddress = m_connectionAddresses.at(m_autoConnectionDcIndex).address;
+    dcInfo.port = m_connectionAddresses.at(m_autoConnectionDcIndex).port;
+
+    CTelegramConnection *connection = createConnection(dcInfo, m_mainTransportOptions);
+    m_connectionAttempts.append(connection);
+    connection->connectToDc();
+
+    if ((m_connectionAttempts.count() < m_parallelConnectionAttempts)
+            && (m_autoConnectionDcIndex + 1 < m_connectionAddresses.count())) {
+        m_connectionAttemptTimer->start(m_connectionAttemptDelay);
+    }
+}
+
+void CTelegramDispatcher::processConnectionAttemptStatus(CTelegramConnection *connection, int newStatus)
+{
+    if (newStatus == CTelegramConnection::ConnectionStatusDisconnected) {
+        m_connectionAttempts.removeOne(connection);
+        disconnect(connection, nullptr, this, nullptr);
+        connection->deleteLater();
+
+        // Do not wait for the delay, the failed address is already out of the race.
+        startConnectionAttempt();
+    } else if (newStatus >= CTelegramConnection::ConnectionStatusConnected) {
+        qDebug() << Q_FUNC_INFO << "Connected to" << connection->dcInfo().ipAddress;
+
+        m_connectionAttempts.removeOne(connection);
+        clearConnectionAttempts();
+
+        m_autoConnectionDcIndex = s_autoConnectionIndexInvalid;
+        m_mainConnection = connection;
+    }
+}
+
 bool CTelegramDispatcher::restoreConnection(const QByteArray &secret)
 {
     CRawStreamEx inputStream(secret);
@@ -390,7 +535,7 @@ bool CTelegramDispatcher::restoreConnection(const QByteArray &secret)
 
     clearMainConnection();
     m_wantedActiveDc = dcInfo.id;
-    m_mainConnection = createConnection(dcInfo);
+    m_mainConnection = createConnection(dcInfo, m_mainTransportOptions);
     m_mainConnection->setAuthKey(authKey);
     m_mainConnection->setServerSalt(serverSalt);
 
@@ -426,7 +571,10 @@ void CTelegramDispatcher::initConnectionSharedFinal()
     m_selfUserId = 0;
 
     m_actualState = TLUpdatesState();
-    m_mainConnection->connectToDc();
+
+    if (m_mainConnection) { // Otherwise the main connection is yet to be picked from the connection attempts
+        m_mainConnection->connectToDc();
+    }
 }
 
 void CTelegramDispatcher::closeConnection()
@@ -1752,11 +1900,20 @@ CTelegramConnection *CTelegramDispatcher::getExtraConnection(quint32 dc)
         return nullptr;
     }
 
-    CTelegramConnection *connection = createConnection(dcInfo);
+    CTelegramConnection *connection = createConnection(dcInfo, m_extraTransportOptions);
     if (activeConnection()->dcInfo().id == dc) {
         connection->setDeltaTime(activeConnection()->deltaTime());
         connection->setAuthKey(activeConnection()->authKey());
         connection->setServerSalt(activeConnection()->serverSalt());
+    } else if (m_authKeyGenerator) {
+        QByteArray authKey;
+        quint64 serverSalt;
+        if (m_authKeyGenerator->takeKey(dc, &authKey, &serverSalt)) {
+            // The pre-generated key skips the handshake, but the connection still has to import the authorization
+            connection->setAuthKey(authKey);
+            connection->setAuthKeyAuthorized(false);
+            connection->setServerSalt(serverSalt);
+        }
     }
 
     m_extraConnections.append(connection);
@@ -1822,6 +1979,10 @@ void CTelegramDispatcher::onConnectionAuthChanged(int newState, quint32 dc)
         }
     }
 
+    if ((newState == CTelegramConnection::AuthStateSignedIn) && m_tempAuthKeyLifetime) {
+        startTempAuthKeyManager(connection);
+    }
+
     if (newState >= CTelegramConnection::AuthStateHaveAKey) {
         if (m_delayedPackages.contains(dc)) {
             qDebug() << Q_FUNC_INFO << "process" << m_delayedPackages.count(dc) << "redirected packages" << "for dc" << dc;
@@ -1854,6 +2015,11 @@ void CTelegramDispatcher::onConnectionStatusChanged(int newStatus, int reason, q
         return;
     }
 
+    if (m_connectionAttempts.contains(connection)) {
+        processConnectionAttemptStatus(connection, newStatus);
+        return;
+    }
+
     if (connection == activeConnection()) {
         if (newStatus == CTelegramConnection::ConnectionStatusDisconnected) {
             if (connectionState() == TelegramNamespace::ConnectionStateDisconnected) {
@@ -1923,6 +2089,11 @@ void CTelegramDispatcher::onConnectionDcIdUpdated(quint32 connectionId, quint32
     }
 }
 
+void CTelegramDispatcher::onConnectionDestroyed(QObject *connection)
+{
+    m_tempAuthKeyConnections.remove(connection);
+}
+
 void CTelegramDispatcher::onPackageRedirected(const QByteArray &data, quint32 dc)
 {
     CTelegramConnection *connection = getExtraConnection(dc);
@@ -2112,6 +2283,7 @@ void CTelegramDispatcher::continueInitialization(CTelegramDispatcher::Initializa
         if (!(m_requestedSteps & StepKnowSelf)) {
             getInitialUsers();
             m_requestedSteps |= StepKnowSelf;
+            preGenerateAuthKeys();
             return;
         }
 
@@ -2247,14 +2419,32 @@ void CTelegramDispatcher::checkStateAndCallGetDifference()
     }
 }
 
-CTelegramConnection *CTelegramDispatcher::createConnection(const TLDcOption &dcInfo)
+CTelegramConnection *CTelegramDispatcher::createConnection(const TLDcOption &dcInfo, const STransportOptions &transportOptions)
 {
     qDebug() << Q_FUNC_INFO << dcInfo.id << dcInfo.ipAddress << dcInfo.port;
 
-    CTelegramConnection *connection = new CTelegramConnection(m_appInformation, this);
+    // An object with a parent can not be moved to another thread
+    CTelegramConnection *connection = new CTelegramConnection(m_appInformation, m_connectionThreadsEnabled ? nullptr : this);
     connection->setDcInfo(dcInfo);
+    connection->setServerRsaKey(m_serverRsaKey);
+
+    CTelegramTransport *transport = createTransport(dcInfo);
+    if (transport) {
+        connection->setTransport(transport); // A custom transport is kept by setTransportOptions()
+    }
+    connection->setTransportOptions(transportOptions);
     connection->setDeltaTime(m_deltaTime);
 
+    if (m_connectionThreadsEnabled) {
+        QThread *thread = new QThread(this);
+        thread->setObjectName(QString(QLatin1String("TelegramDc%1")).arg(dcInfo.id));
+        connection->moveToThread(thread);
+
+        connect(connection, SIGNAL(destroyed()), thread, SLOT(quit()));
+        connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+        thread->start();
+    }
+
     connect(connection, SIGNAL(authStateChanged(int,quint32)), SLOT(onConnectionAuthChanged(int,quint32)));
     connect(connection, SIGNAL(statusChanged(int,int,quint32)), SLOT(onConnectionStatusChanged(int,int,quint32)));
     connect(connection, SIGNAL(dcConfigurationReceived(quint32)), SLOT(onDcConfigurationUpdated()));
@@ -2272,6 +2462,12 @@ CTelegramConnection *CTelegramDispatcher::createConnection(const TLDcOption &dcI
     return connection;
 }
 
+CTelegramTransport *CTelegramDispatcher::createTransport(const TLDcOption &dcInfo)
+{
+    Q_UNUSED(dcInfo)
+    return nullptr;
+}
+
 void CTelegramDispatcher::ensureSignedConnection(CTelegramConnection *connection)
 {
     if (connection->status() == CTelegramConnection::ConnectionStatusDisconnected) {
@@ -2305,6 +2501,8 @@ void CTelegramDispatcher::ensureSignedConnection(CTelegramConnection *connection
 
 void CTelegramDispatcher::clearMainConnection()
 {
+    clearConnectionAttempts();
+
     if (!m_mainConnection) {
         return;
     }
@@ -2320,6 +2518,77 @@ void CTelegramDispatcher::clearExtraConnections()
     }
 
     m_extraConnections.clear();
+
+    if (m_authKeyGenerator) {
+        m_authKeyGenerator->clear();
+    }
+}
+
+void CTelegramDispatcher::clearConnectionAttempts()
+{
+    m_connectionAttemptTimer->stop();
+
+    foreach (CTelegramConnection *connection, m_connectionAttempts) {
+        disconnect(connection, nullptr, this, nullptr);
+        connection->deleteLater();
+    }
+
+    m_connectionAttempts.clear();
+}
+
+void CTelegramDispatcher::preGenerateAuthKeys()
+{
+    if (!m_authKeyPreGenerationEnabled || !activeConnection()) {
+        return;
+    }
+
+    if (!m_authKeyGenerator) {
+        m_authKeyGenerator = new CAuthKeyGenerator(m_appInformation, this);
+    }
+
+    m_authKeyGenerator->setTransportOptions(m_extraTransportOptions);
+    m_authKeyGenerator->setDeltaTime(m_deltaTime);
+
+    const quint32 activeDc = activeConnection()->dcInfo().id;
+
+    foreach (const TLDcOption &option, m_dcConfiguration) {
+        if (option.id == activeDc) {
+            continue; // The active connection key is used
+        }
+
+        bool haveConnection = false;
+        foreach (CTelegramConnection *connection, m_extraConnections) {
+            if (connection->dcInfo().id == option.id) {
+                haveConnection = true;
+                break;
+            }
+        }
+
+        // Only the key is kept, the connection is established on the first request to the DC.
+        // The generator skips the DCs, which already have a key or a pending generation.
+        if (!haveConnection) {
+            m_authKeyGenerator->generateKey(dcInfoById(option.id));
+        }
+    }
+}
+
+void CTelegramDispatcher::startTempAuthKeyManager(CTelegramConnection *connection)
+{
+    if (m_tempAuthKeyConnections.contains(connection)) {
+        return;
+    }
+
+    // The manager calls the connection directly, so it lives in the connection thread (which can be a worker one).
+    // It is deleted along with the connection; the deferred deletion is processed even if the thread is finished.
+    CTempAuthKeyManager *manager = new CTempAuthKeyManager(m_appInformation, connection);
+    manager->setKeyLifetime(m_tempAuthKeyLifetime);
+    manager->moveToThread(connection->thread());
+    connect(connection, SIGNAL(destroyed()), manager, SLOT(deleteLater()));
+
+    m_tempAuthKeyConnections.insert(connection);
+    connect(connection, SIGNAL(destroyed(QObject*)), SLOT(onConnectionDestroyed(QObject*)));
+
+    QMetaObject::invokeMethod(manager, "start", Qt::QueuedConnection);
 }
 
 void CTelegramDispatcher::ensureMainConnectToWantedDc()
@@ -2347,7 +2616,7 @@ void CTelegramDispatcher::ensureMainConnectToWantedDc()
     }
 
     clearMainConnection();
-    m_mainConnection = createConnection(wantedDcInfo);
+    m_mainConnection = createConnection(wantedDcInfo, m_mainTransportOptions);
     m_mainConnection->connectToDc();
 }
 
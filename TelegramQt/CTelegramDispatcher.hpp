@@ -20,22 +20,28 @@
 
 #include <QObject>
 
+#include <QHash>
 #include <QMap>
 #include <QMultiMap>
 #include <QPair>
+#include <QSet>
 #include <QStringList>
 #include <QVector>
 
+#include "CTelegramTransport.hpp"
 #include "FileRequestDescriptor.hpp"
 #include "TLTypes.hpp"
 #include "TelegramNamespace.hpp"
+#include "crypto-rsa.hpp"
 
 class QTimer;
 class QCryptographicHash;
 class QIODevice;
 
 class CAppInformation;
+class CAuthKeyGenerator;
 class CTelegramConnection;
+class CTelegramTransport;
 class CTelegramModule;
 
 class CTelegramDispatcher : public QObject
@@ -94,6 +100,33 @@ public:
     void setAutoReconnection(bool enable);
     void setPingInterval(quint32 ms, quint32 serverDisconnectionAdditionTime);
 
+    STransportOptions mainTransportOptions() const { return m_mainTransportOptions; }
+    bool setMainTransportOptions(const STransportOptions &options); // HTTP is refused, see STransportOptions::protocol
+    STransportOptions extraTransportOptions() const { return m_extraTransportOptions; }
+    void setExtraTransportOptions(const STransportOptions &options);
+
+    // An empty key means the key of the official servers
+    SRsaKey serverRsaKey() const { return m_serverRsaKey; }
+    void setServerRsaKey(const SRsaKey &key) { m_serverRsaKey = key; }
+
+    // If enabled, each new connection runs its I/O, crypto and parsing in a dedicated thread.
+    bool connectionThreadsEnabled() const { return m_connectionThreadsEnabled; }
+    void setConnectionThreadsEnabled(bool enabled) { m_connectionThreadsEnabled = enabled; }
+
+    int parallelConnectionAttempts() const { return m_parallelConnectionAttempts; }
+    quint32 connectionAttemptDelay() const { return m_connectionAttemptDelay; }
+    void setParallelConnectionAttempts(int count, quint32 attemptDelay);
+
+    // If enabled, the auth keys for all known DCs are generated right after the sign in. Each key connection is closed
+    // once the key is ready, so the first media request to a DC connects with the key and only imports the authorization.
+    bool authKeyPreGenerationEnabled() const { return m_authKeyPreGenerationEnabled; }
+    void setAuthKeyPreGenerationEnabled(bool enabled);
+
+    // If the lifetime (sec) is not zero, each signed connection switches to a temporary auth key, bound to the permanent one.
+    // The keys are renewed in background ahead of the expiration. Affects the connections, which are signed in later.
+    quint32 tempAuthKeyLifetime() const { return m_tempAuthKeyLifetime; }
+    void setTempAuthKeyLifetime(quint32 lifetime) { m_tempAuthKeyLifetime = lifetime; }
+
     bool initConnection(const QVector<Telegram::DcOption> &dcs);
     bool restoreConnection(const QByteArray &secret);
     void closeConnection();
@@ -123,11 +156,14 @@ public:
     CTelegramConnection *activeConnection() const { return m_mainConnection; }
     CTelegramConnection *getExtraConnection(quint32 dc);
 
-    CTelegramConnection *createConnection(const TLDcOption &dcInfo);
+    CTelegramConnection *createConnection(const TLDcOption &dcInfo, const STransportOptions &transportOptions);
     void ensureSignedConnection(CTelegramConnection *connection);
     void clearMainConnection();
     void clearExtraConnections();
+    void clearConnectionAttempts();
     void ensureMainConnectToWantedDc();
+    void preGenerateAuthKeys();
+    void startTempAuthKeyManager(CTelegramConnection *connection);
 
     TLDcOption dcInfoById(quint32 dc) const;
 
@@ -176,6 +212,7 @@ protected slots:
     void onConnectionStatusChanged(int newStatus, int reason, quint32 dc);
     void onDcConfigurationUpdated();
     void onConnectionDcIdUpdated(quint32 connectionId, quint32 newDcId);
+    void onConnectionDestroyed(QObject *connection);
     void onPackageRedirected(const QByteArray &data, quint32 dc);
 
     void onUpdatesReceived(const TLUpdates &updates, quint64 id);
@@ -204,7 +241,13 @@ protected slots:
     void onChatsReceived(const QVector<TLChat> &chats);
     void onMessagesFullChatReceived(const TLChatFull &chat, const QVector<TLChat> &chats, const QVector<TLUser> &users);
 
+    void startConnectionAttempt();
+
 protected:
+    // Returns the transport for a new connection, or nullptr to use the one selected by the transport options.
+    // Tests return an in-memory transport to run the whole stack without the network.
+    virtual CTelegramTransport *createTransport(const TLDcOption &dcInfo);
+
     void setConnectionState(TelegramNamespace::ConnectionState state);
 
     void processUpdate(const TLUpdate &update);
@@ -236,6 +279,7 @@ protected:
 
     void checkStateAndCallGetDifference();
     void tryNextDcAddress();
+    void processConnectionAttemptStatus(CTelegramConnection *connection, int newStatus);
 
     void continueInitialization(InitializationStep justDone);
 
@@ -285,8 +329,16 @@ protected:
     TelegramNamespace::MessageFlags m_messageReceivingFilterFlags;
     TelegramNamespace::MessageTypeFlags m_acceptableMessageTypes;
     bool m_autoReconnectionEnabled;
+    bool m_connectionThreadsEnabled;
+    int m_parallelConnectionAttempts;
+    quint32 m_connectionAttemptDelay;
+    bool m_authKeyPreGenerationEnabled;
+    quint32 m_tempAuthKeyLifetime;
     quint32 m_pingInterval;
     quint32 m_pingServerAdditionDisconnectionTime;
+    STransportOptions m_mainTransportOptions;
+    STransportOptions m_extraTransportOptions; // Used for the media connections
+    SRsaKey m_serverRsaKey;
 
     InitializationStepFlags m_initializationState;
     InitializationStepFlags m_requestedSteps;
@@ -297,7 +349,11 @@ protected:
     QVector<Telegram::DcOption> m_connectionAddresses;
     QVector<TLDcOption> m_dcConfiguration;
     CTelegramConnection *m_mainConnection;
+    QVector<CTelegramConnection *> m_connectionAttempts; // Candidates for the main connection, racing to connect first
+    QTimer *m_connectionAttemptTimer;
     QVector<CTelegramConnection *> m_extraConnections;
+    CAuthKeyGenerator *m_authKeyGenerator; // Created on the first pre-generation
+    QSet<QObject *> m_tempAuthKeyConnections; // The connections, which have a temporary key manager
     QString m_requestedCodeForPhone;
 
     quint64 m_updateRequestId;
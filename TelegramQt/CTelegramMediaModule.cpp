@@ -235,6 +235,7 @@ void CTelegramMediaModule::clear()
 {
     m_requestedFileDescriptors.clear();
     m_fileRequestCounter = 0;
+    m_uploadsWaitingForSendBuffer.clear();
 }
 
 void CTelegramMediaModule::onFileDataReceived(const TLUploadFile &file, quint32 requestId, quint32 offset)
@@ -409,6 +410,37 @@ void CTelegramMediaModule::onNewConnection(CTelegramConnection *connection)
     qDebug() << Q_FUNC_INFO << connection;
     connect(connection, SIGNAL(fileDataReceived(TLUploadFile,quint32,quint32)), SLOT(onFileDataReceived(TLUploadFile,quint32,quint32)));
     connect(connection, SIGNAL(fileDataSent(quint32)), SLOT(onFileDataUploaded(quint32)));
+    connect(connection, SIGNAL(sendBufferFullChanged(bool)), SLOT(onConnectionSendBufferFullChanged(bool)));
+}
+
+void CTelegramMediaModule::onConnectionSendBufferFullChanged(bool full)
+{
+    if (full) {
+        return;
+    }
+
+    CTelegramConnection *connection = qobject_cast<CTelegramConnection*>(sender());
+    if (!connection) {
+        qDebug() << Q_FUNC_INFO << "Invalid call. The method must be called only on CTelegramConnection signal.";
+        return;
+    }
+
+    const quint32 dc = connection->dcInfo().id;
+    const QVector<quint32> requests = m_uploadsWaitingForSendBuffer;
+
+    foreach (quint32 requestId, requests) {
+        if (!m_requestedFileDescriptors.contains(requestId)) {
+            m_uploadsWaitingForSendBuffer.removeOne(requestId);
+            continue;
+        }
+
+        if (m_requestedFileDescriptors.value(requestId).dcId() != dc) {
+            continue;
+        }
+
+        m_uploadsWaitingForSendBuffer.removeOne(requestId);
+        processFileRequestForConnection(connection, requestId);
+    }
 }
 
 QString CTelegramMediaModule::userAvatarToken(const TLUser *user) const
@@ -463,6 +495,13 @@ void CTelegramMediaModule::processFileRequestForConnection(CTelegramConnection *
         connection->downloadFile(descriptor.inputLocation(), descriptor.offset(), descriptor.chunkSize(), requestId);
         break;
     case FileRequestDescriptor::Upload:
+        if (connection->isSendBufferFull()) {
+            // Do not queue more file parts behind the pings and the other requests
+            if (!m_uploadsWaitingForSendBuffer.contains(requestId)) {
+                m_uploadsWaitingForSendBuffer.append(requestId);
+            }
+            break;
+        }
         connection->uploadFile(descriptor.fileId(), descriptor.part(), descriptor.data(), requestId);
         break;
     default:
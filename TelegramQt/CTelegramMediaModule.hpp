@@ -21,6 +21,7 @@
 #include "CTelegramModule.hpp"
 
 #include <QMap>
+#include <QVector>
 
 #include "TLTypes.hpp"
 #include "TelegramNamespace.hpp"
@@ -62,6 +63,7 @@ signals:
 protected slots:
     void onFileDataReceived(const TLUploadFile &file, quint32 requestId, quint32 offset);
     void onFileDataUploaded(quint32 requestId);
+    void onConnectionSendBufferFullChanged(bool full);
 
 protected:
     void onConnectionAuthChanged(CTelegramConnection *connection, int newState) override;
@@ -75,6 +77,7 @@ protected:
     quint32 m_mediaDataBufferSize;
     QMap<quint32, FileRequestDescriptor> m_requestedFileDescriptors; // fileId, file request descriptor
     quint32 m_fileRequestCounter;
+    QVector<quint32> m_uploadsWaitingForSendBuffer; // Upload requests postponed because of a full connection send buffer
 
 };
 
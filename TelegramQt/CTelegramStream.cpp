@@ -105,14 +105,16 @@ CTelegramStream &CTelegramStream::operator>>(TLVector<T> &v)
     if (result.tlType == TLValue::Vector) {
         quint32 length = 0;
         *this >> length;
+        // Each item takes at least four bytes, so a broken length can not cause a huge allocation
+        result.reserve(qMin<quint32>(length, bytesRemaining() / 4));
         for (quint32 i = 0; i < length; ++i) {
             T value;
             *this >> value;
-            result.append(value);
+            result.append(std::move(value));
         }
     }
 
-    v = result;
+    v = std::move(result);
     return *this;
 }
 
@@ -131,7 +133,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAccountDaysTTL &accountDaysTTLVal
         break;
     }
 
-    accountDaysTTLValue = result;
+    accountDaysTTLValue = std::move(result);
 
     return *this;
 }
@@ -158,7 +160,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAccountPassword &accountPasswordV
         break;
     }
 
-    accountPasswordValue = result;
+    accountPasswordValue = std::move(result);
 
     return *this;
 }
@@ -189,7 +191,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAccountPasswordInputSettings &acc
         break;
     }
 
-    accountPasswordInputSettingsValue = result;
+    accountPasswordInputSettingsValue = std::move(result);
 
     return *this;
 }
@@ -208,7 +210,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAccountPasswordSettings &accountP
         break;
     }
 
-    accountPasswordSettingsValue = result;
+    accountPasswordSettingsValue = std::move(result);
 
     return *this;
 }
@@ -228,7 +230,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAccountSentChangePhoneCode &accou
         break;
     }
 
-    accountSentChangePhoneCodeValue = result;
+    accountSentChangePhoneCodeValue = std::move(result);
 
     return *this;
 }
@@ -256,7 +258,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAudio &audioValue)
         break;
     }
 
-    audioValue = result;
+    audioValue = std::move(result);
 
     return *this;
 }
@@ -275,7 +277,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAuthCheckedPhone &authCheckedPhon
         break;
     }
 
-    authCheckedPhoneValue = result;
+    authCheckedPhoneValue = std::move(result);
 
     return *this;
 }
@@ -295,7 +297,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAuthExportedAuthorization &authEx
         break;
     }
 
-    authExportedAuthorizationValue = result;
+    authExportedAuthorizationValue = std::move(result);
 
     return *this;
 }
@@ -314,7 +316,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAuthPasswordRecovery &authPasswor
         break;
     }
 
-    authPasswordRecoveryValue = result;
+    authPasswordRecoveryValue = std::move(result);
 
     return *this;
 }
@@ -342,7 +344,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAuthSentCode &authSentCodeValue)
         break;
     }
 
-    authSentCodeValue = result;
+    authSentCodeValue = std::move(result);
 
     return *this;
 }
@@ -373,7 +375,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAuthorization &authorizationValue
         break;
     }
 
-    authorizationValue = result;
+    authorizationValue = std::move(result);
 
     return *this;
 }
@@ -393,7 +395,7 @@ CTelegramStream &CTelegramStream::operator>>(TLBotCommand &botCommandValue)
         break;
     }
 
-    botCommandValue = result;
+    botCommandValue = std::move(result);
 
     return *this;
 }
@@ -418,7 +420,7 @@ CTelegramStream &CTelegramStream::operator>>(TLBotInfo &botInfoValue)
         break;
     }
 
-    botInfoValue = result;
+    botInfoValue = std::move(result);
 
     return *this;
 }
@@ -461,7 +463,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChannelParticipant &channelPartic
         break;
     }
 
-    channelParticipantValue = result;
+    channelParticipantValue = std::move(result);
 
     return *this;
 }
@@ -483,7 +485,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChannelParticipantRole &channelPa
         break;
     }
 
-    channelParticipantRoleValue = result;
+    channelParticipantRoleValue = std::move(result);
 
     return *this;
 }
@@ -507,7 +509,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChannelParticipantsFilter &channe
         break;
     }
 
-    channelParticipantsFilterValue = result;
+    channelParticipantsFilterValue = std::move(result);
 
     return *this;
 }
@@ -536,7 +538,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChatParticipant &chatParticipantV
         break;
     }
 
-    chatParticipantValue = result;
+    chatParticipantValue = std::move(result);
 
     return *this;
 }
@@ -564,7 +566,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChatParticipants &chatParticipant
         break;
     }
 
-    chatParticipantsValue = result;
+    chatParticipantsValue = std::move(result);
 
     return *this;
 }
@@ -584,7 +586,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContact &contactValue)
         break;
     }
 
-    contactValue = result;
+    contactValue = std::move(result);
 
     return *this;
 }
@@ -604,7 +606,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactBlocked &contactBlockedVal
         break;
     }
 
-    contactBlockedValue = result;
+    contactBlockedValue = std::move(result);
 
     return *this;
 }
@@ -628,7 +630,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactLink &contactLinkValue)
         break;
     }
 
-    contactLinkValue = result;
+    contactLinkValue = std::move(result);
 
     return *this;
 }
@@ -648,7 +650,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactSuggested &contactSuggeste
         break;
     }
 
-    contactSuggestedValue = result;
+    contactSuggestedValue = std::move(result);
 
     return *this;
 }
@@ -668,7 +670,7 @@ CTelegramStream &CTelegramStream::operator>>(TLDisabledFeature &disabledFeatureV
         break;
     }
 
-    disabledFeatureValue = result;
+    disabledFeatureValue = std::move(result);
 
     return *this;
 }
@@ -714,7 +716,7 @@ CTelegramStream &CTelegramStream::operator>>(TLEncryptedChat &encryptedChatValue
         break;
     }
 
-    encryptedChatValue = result;
+    encryptedChatValue = std::move(result);
 
     return *this;
 }
@@ -739,7 +741,7 @@ CTelegramStream &CTelegramStream::operator>>(TLEncryptedFile &encryptedFileValue
         break;
     }
 
-    encryptedFileValue = result;
+    encryptedFileValue = std::move(result);
 
     return *this;
 }
@@ -768,7 +770,7 @@ CTelegramStream &CTelegramStream::operator>>(TLEncryptedMessage &encryptedMessag
         break;
     }
 
-    encryptedMessageValue = result;
+    encryptedMessageValue = std::move(result);
 
     return *this;
 }
@@ -788,7 +790,7 @@ CTelegramStream &CTelegramStream::operator>>(TLError &errorValue)
         break;
     }
 
-    errorValue = result;
+    errorValue = std::move(result);
 
     return *this;
 }
@@ -809,7 +811,7 @@ CTelegramStream &CTelegramStream::operator>>(TLExportedChatInvite &exportedChatI
         break;
     }
 
-    exportedChatInviteValue = result;
+    exportedChatInviteValue = std::move(result);
 
     return *this;
 }
@@ -836,7 +838,7 @@ CTelegramStream &CTelegramStream::operator>>(TLFileLocation &fileLocationValue)
         break;
     }
 
-    fileLocationValue = result;
+    fileLocationValue = std::move(result);
 
     return *this;
 }
@@ -858,7 +860,7 @@ CTelegramStream &CTelegramStream::operator>>(TLGeoPoint &geoPointValue)
         break;
     }
 
-    geoPointValue = result;
+    geoPointValue = std::move(result);
 
     return *this;
 }
@@ -879,7 +881,7 @@ CTelegramStream &CTelegramStream::operator>>(TLHelpAppChangelog &helpAppChangelo
         break;
     }
 
-    helpAppChangelogValue = result;
+    helpAppChangelogValue = std::move(result);
 
     return *this;
 }
@@ -903,7 +905,7 @@ CTelegramStream &CTelegramStream::operator>>(TLHelpAppUpdate &helpAppUpdateValue
         break;
     }
 
-    helpAppUpdateValue = result;
+    helpAppUpdateValue = std::move(result);
 
     return *this;
 }
@@ -922,7 +924,7 @@ CTelegramStream &CTelegramStream::operator>>(TLHelpInviteText &helpInviteTextVal
         break;
     }
 
-    helpInviteTextValue = result;
+    helpInviteTextValue = std::move(result);
 
     return *this;
 }
@@ -941,7 +943,7 @@ CTelegramStream &CTelegramStream::operator>>(TLHelpTermsOfService &helpTermsOfSe
         break;
     }
 
-    helpTermsOfServiceValue = result;
+    helpTermsOfServiceValue = std::move(result);
 
     return *this;
 }
@@ -961,7 +963,7 @@ CTelegramStream &CTelegramStream::operator>>(TLImportedContact &importedContactV
         break;
     }
 
-    importedContactValue = result;
+    importedContactValue = std::move(result);
 
     return *this;
 }
@@ -983,7 +985,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputAppEvent &inputAppEventValue
         break;
     }
 
-    inputAppEventValue = result;
+    inputAppEventValue = std::move(result);
 
     return *this;
 }
@@ -1005,7 +1007,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputAudio &inputAudioValue)
         break;
     }
 
-    inputAudioValue = result;
+    inputAudioValue = std::move(result);
 
     return *this;
 }
@@ -1027,7 +1029,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputChannel &inputChannelValue)
         break;
     }
 
-    inputChannelValue = result;
+    inputChannelValue = std::move(result);
 
     return *this;
 }
@@ -1049,7 +1051,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputContact &inputContactValue)
         break;
     }
 
-    inputContactValue = result;
+    inputContactValue = std::move(result);
 
     return *this;
 }
@@ -1071,7 +1073,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputDocument &inputDocumentValue
         break;
     }
 
-    inputDocumentValue = result;
+    inputDocumentValue = std::move(result);
 
     return *this;
 }
@@ -1091,7 +1093,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputEncryptedChat &inputEncrypte
         break;
     }
 
-    inputEncryptedChatValue = result;
+    inputEncryptedChatValue = std::move(result);
 
     return *this;
 }
@@ -1124,7 +1126,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputEncryptedFile &inputEncrypte
         break;
     }
 
-    inputEncryptedFileValue = result;
+    inputEncryptedFileValue = std::move(result);
 
     return *this;
 }
@@ -1151,7 +1153,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputFile &inputFileValue)
         break;
     }
 
-    inputFileValue = result;
+    inputFileValue = std::move(result);
 
     return *this;
 }
@@ -1188,7 +1190,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputFileLocation &inputFileLocat
         break;
     }
 
-    inputFileLocationValue = result;
+    inputFileLocationValue = std::move(result);
 
     return *this;
 }
@@ -1210,7 +1212,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputGeoPoint &inputGeoPointValue
         break;
     }
 
-    inputGeoPointValue = result;
+    inputGeoPointValue = std::move(result);
 
     return *this;
 }
@@ -1241,7 +1243,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputPeer &inputPeerValue)
         break;
     }
 
-    inputPeerValue = result;
+    inputPeerValue = std::move(result);
 
     return *this;
 }
@@ -1261,7 +1263,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputPeerNotifyEvents &inputPeerN
         break;
     }
 
-    inputPeerNotifyEventsValue = result;
+    inputPeerNotifyEventsValue = std::move(result);
 
     return *this;
 }
@@ -1283,7 +1285,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputPeerNotifySettings &inputPee
         break;
     }
 
-    inputPeerNotifySettingsValue = result;
+    inputPeerNotifySettingsValue = std::move(result);
 
     return *this;
 }
@@ -1305,7 +1307,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputPhoto &inputPhotoValue)
         break;
     }
 
-    inputPhotoValue = result;
+    inputPhotoValue = std::move(result);
 
     return *this;
 }
@@ -1328,7 +1330,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputPhotoCrop &inputPhotoCropVal
         break;
     }
 
-    inputPhotoCropValue = result;
+    inputPhotoCropValue = std::move(result);
 
     return *this;
 }
@@ -1346,7 +1348,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputPrivacyKey &inputPrivacyKeyV
         break;
     }
 
-    inputPrivacyKeyValue = result;
+    inputPrivacyKeyValue = std::move(result);
 
     return *this;
 }
@@ -1371,7 +1373,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputStickerSet &inputStickerSetV
         break;
     }
 
-    inputStickerSetValue = result;
+    inputStickerSetValue = std::move(result);
 
     return *this;
 }
@@ -1395,7 +1397,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputUser &inputUserValue)
         break;
     }
 
-    inputUserValue = result;
+    inputUserValue = std::move(result);
 
     return *this;
 }
@@ -1417,7 +1419,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputVideo &inputVideoValue)
         break;
     }
 
-    inputVideoValue = result;
+    inputVideoValue = std::move(result);
 
     return *this;
 }
@@ -1436,7 +1438,7 @@ CTelegramStream &CTelegramStream::operator>>(TLKeyboardButton &keyboardButtonVal
         break;
     }
 
-    keyboardButtonValue = result;
+    keyboardButtonValue = std::move(result);
 
     return *this;
 }
@@ -1455,7 +1457,7 @@ CTelegramStream &CTelegramStream::operator>>(TLKeyboardButtonRow &keyboardButton
         break;
     }
 
-    keyboardButtonRowValue = result;
+    keyboardButtonRowValue = std::move(result);
 
     return *this;
 }
@@ -1517,7 +1519,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessageEntity &messageEntityValue
         break;
     }
 
-    messageEntityValue = result;
+    messageEntityValue = std::move(result);
 
     return *this;
 }
@@ -1539,7 +1541,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessageGroup &messageGroupValue)
         break;
     }
 
-    messageGroupValue = result;
+    messageGroupValue = std::move(result);
 
     return *this;
 }
@@ -1559,7 +1561,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessageRange &messageRangeValue)
         break;
     }
 
-    messageRangeValue = result;
+    messageRangeValue = std::move(result);
 
     return *this;
 }
@@ -1580,7 +1582,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesAffectedHistory &messages
         break;
     }
 
-    messagesAffectedHistoryValue = result;
+    messagesAffectedHistoryValue = std::move(result);
 
     return *this;
 }
@@ -1600,7 +1602,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesAffectedMessages &message
         break;
     }
 
-    messagesAffectedMessagesValue = result;
+    messagesAffectedMessagesValue = std::move(result);
 
     return *this;
 }
@@ -1625,7 +1627,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesDhConfig &messagesDhConfi
         break;
     }
 
-    messagesDhConfigValue = result;
+    messagesDhConfigValue = std::move(result);
 
     return *this;
 }
@@ -1661,7 +1663,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesFilter &messagesFilterVal
         break;
     }
 
-    messagesFilterValue = result;
+    messagesFilterValue = std::move(result);
 
     return *this;
 }
@@ -1684,7 +1686,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesSentEncryptedMessage &mes
         break;
     }
 
-    messagesSentEncryptedMessageValue = result;
+    messagesSentEncryptedMessageValue = std::move(result);
 
     return *this;
 }
@@ -1705,7 +1707,7 @@ CTelegramStream &CTelegramStream::operator>>(TLNearestDc &nearestDcValue)
         break;
     }
 
-    nearestDcValue = result;
+    nearestDcValue = std::move(result);
 
     return *this;
 }
@@ -1730,7 +1732,7 @@ CTelegramStream &CTelegramStream::operator>>(TLPeer &peerValue)
         break;
     }
 
-    peerValue = result;
+    peerValue = std::move(result);
 
     return *this;
 }
@@ -1750,7 +1752,7 @@ CTelegramStream &CTelegramStream::operator>>(TLPeerNotifyEvents &peerNotifyEvent
         break;
     }
 
-    peerNotifyEventsValue = result;
+    peerNotifyEventsValue = std::move(result);
 
     return *this;
 }
@@ -1774,7 +1776,7 @@ CTelegramStream &CTelegramStream::operator>>(TLPeerNotifySettings &peerNotifySet
         break;
     }
 
-    peerNotifySettingsValue = result;
+    peerNotifySettingsValue = std::move(result);
 
     return *this;
 }
@@ -1807,7 +1809,7 @@ CTelegramStream &CTelegramStream::operator>>(TLPhotoSize &photoSizeValue)
         break;
     }
 
-    photoSizeValue = result;
+    photoSizeValue = std::move(result);
 
     return *this;
 }
@@ -1825,7 +1827,7 @@ CTelegramStream &CTelegramStream::operator>>(TLPrivacyKey &privacyKeyValue)
         break;
     }
 
-    privacyKeyValue = result;
+    privacyKeyValue = std::move(result);
 
     return *this;
 }
@@ -1855,7 +1857,7 @@ CTelegramStream &CTelegramStream::operator>>(TLPrivacyRule &privacyRuleValue)
         break;
     }
 
-    privacyRuleValue = result;
+    privacyRuleValue = std::move(result);
 
     return *this;
 }
@@ -1875,7 +1877,7 @@ CTelegramStream &CTelegramStream::operator>>(TLReceivedNotifyMessage &receivedNo
         break;
     }
 
-    receivedNotifyMessageValue = result;
+    receivedNotifyMessageValue = std::move(result);
 
     return *this;
 }
@@ -1900,7 +1902,7 @@ CTelegramStream &CTelegramStream::operator>>(TLReportReason &reportReasonValue)
         break;
     }
 
-    reportReasonValue = result;
+    reportReasonValue = std::move(result);
 
     return *this;
 }
@@ -1940,7 +1942,7 @@ CTelegramStream &CTelegramStream::operator>>(TLSendMessageAction &sendMessageAct
         break;
     }
 
-    sendMessageActionValue = result;
+    sendMessageActionValue = std::move(result);
 
     return *this;
 }
@@ -1960,7 +1962,7 @@ CTelegramStream &CTelegramStream::operator>>(TLStickerPack &stickerPackValue)
         break;
     }
 
-    stickerPackValue = result;
+    stickerPackValue = std::move(result);
 
     return *this;
 }
@@ -1996,7 +1998,7 @@ CTelegramStream &CTelegramStream::operator>>(TLStorageFileType &storageFileTypeV
         break;
     }
 
-    storageFileTypeValue = result;
+    storageFileTypeValue = std::move(result);
 
     return *this;
 }
@@ -2014,7 +2016,7 @@ CTelegramStream &CTelegramStream::operator>>(TLTrue &trueValue)
         break;
     }
 
-    trueValue = result;
+    trueValue = std::move(result);
 
     return *this;
 }
@@ -2037,7 +2039,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUpdatesState &updatesStateValue)
         break;
     }
 
-    updatesStateValue = result;
+    updatesStateValue = std::move(result);
 
     return *this;
 }
@@ -2058,7 +2060,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUploadFile &uploadFileValue)
         break;
     }
 
-    uploadFileValue = result;
+    uploadFileValue = std::move(result);
 
     return *this;
 }
@@ -2081,7 +2083,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUserProfilePhoto &userProfilePhot
         break;
     }
 
-    userProfilePhotoValue = result;
+    userProfilePhotoValue = std::move(result);
 
     return *this;
 }
@@ -2111,7 +2113,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUserStatus &userStatusValue)
         break;
     }
 
-    userStatusValue = result;
+    userStatusValue = std::move(result);
 
     return *this;
 }
@@ -2142,7 +2144,7 @@ CTelegramStream &CTelegramStream::operator>>(TLVideo &videoValue)
         break;
     }
 
-    videoValue = result;
+    videoValue = std::move(result);
 
     return *this;
 }
@@ -2170,7 +2172,7 @@ CTelegramStream &CTelegramStream::operator>>(TLWallPaper &wallPaperValue)
         break;
     }
 
-    wallPaperValue = result;
+    wallPaperValue = std::move(result);
 
     return *this;
 }
@@ -2189,7 +2191,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAccountAuthorizations &accountAut
         break;
     }
 
-    accountAuthorizationsValue = result;
+    accountAuthorizationsValue = std::move(result);
 
     return *this;
 }
@@ -2215,7 +2217,7 @@ CTelegramStream &CTelegramStream::operator>>(TLBotInlineMessage &botInlineMessag
         break;
     }
 
-    botInlineMessageValue = result;
+    botInlineMessageValue = std::move(result);
 
     return *this;
 }
@@ -2239,7 +2241,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChannelMessagesFilter &channelMes
         break;
     }
 
-    channelMessagesFilterValue = result;
+    channelMessagesFilterValue = std::move(result);
 
     return *this;
 }
@@ -2261,7 +2263,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChatPhoto &chatPhotoValue)
         break;
     }
 
-    chatPhotoValue = result;
+    chatPhotoValue = std::move(result);
 
     return *this;
 }
@@ -2281,7 +2283,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactStatus &contactStatusValue
         break;
     }
 
-    contactStatusValue = result;
+    contactStatusValue = std::move(result);
 
     return *this;
 }
@@ -2303,7 +2305,7 @@ CTelegramStream &CTelegramStream::operator>>(TLDcOption &dcOptionValue)
         break;
     }
 
-    dcOptionValue = result;
+    dcOptionValue = std::move(result);
 
     return *this;
 }
@@ -2336,7 +2338,7 @@ CTelegramStream &CTelegramStream::operator>>(TLDialog &dialogValue)
         break;
     }
 
-    dialogValue = result;
+    dialogValue = std::move(result);
 
     return *this;
 }
@@ -2375,7 +2377,7 @@ CTelegramStream &CTelegramStream::operator>>(TLDocumentAttribute &documentAttrib
         break;
     }
 
-    documentAttributeValue = result;
+    documentAttributeValue = std::move(result);
 
     return *this;
 }
@@ -2401,7 +2403,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputBotInlineMessage &inputBotIn
         break;
     }
 
-    inputBotInlineMessageValue = result;
+    inputBotInlineMessageValue = std::move(result);
 
     return *this;
 }
@@ -2450,7 +2452,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputBotInlineResult &inputBotInl
         break;
     }
 
-    inputBotInlineResultValue = result;
+    inputBotInlineResultValue = std::move(result);
 
     return *this;
 }
@@ -2476,7 +2478,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputChatPhoto &inputChatPhotoVal
         break;
     }
 
-    inputChatPhotoValue = result;
+    inputChatPhotoValue = std::move(result);
 
     return *this;
 }
@@ -2567,7 +2569,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputMedia &inputMediaValue)
         break;
     }
 
-    inputMediaValue = result;
+    inputMediaValue = std::move(result);
 
     return *this;
 }
@@ -2592,7 +2594,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputNotifyPeer &inputNotifyPeerV
         break;
     }
 
-    inputNotifyPeerValue = result;
+    inputNotifyPeerValue = std::move(result);
 
     return *this;
 }
@@ -2622,7 +2624,7 @@ CTelegramStream &CTelegramStream::operator>>(TLInputPrivacyRule &inputPrivacyRul
         break;
     }
 
-    inputPrivacyRuleValue = result;
+    inputPrivacyRuleValue = std::move(result);
 
     return *this;
 }
@@ -2647,7 +2649,7 @@ CTelegramStream &CTelegramStream::operator>>(TLNotifyPeer &notifyPeerValue)
         break;
     }
 
-    notifyPeerValue = result;
+    notifyPeerValue = std::move(result);
 
     return *this;
 }
@@ -2672,7 +2674,7 @@ CTelegramStream &CTelegramStream::operator>>(TLPhoto &photoValue)
         break;
     }
 
-    photoValue = result;
+    photoValue = std::move(result);
 
     return *this;
 }
@@ -2698,7 +2700,7 @@ CTelegramStream &CTelegramStream::operator>>(TLReplyMarkup &replyMarkupValue)
         break;
     }
 
-    replyMarkupValue = result;
+    replyMarkupValue = std::move(result);
 
     return *this;
 }
@@ -2723,7 +2725,7 @@ CTelegramStream &CTelegramStream::operator>>(TLStickerSet &stickerSetValue)
         break;
     }
 
-    stickerSetValue = result;
+    stickerSetValue = std::move(result);
 
     return *this;
 }
@@ -2776,7 +2778,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUser &userValue)
         break;
     }
 
-    userValue = result;
+    userValue = std::move(result);
 
     return *this;
 }
@@ -2796,7 +2798,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAccountPrivacyRules &accountPriva
         break;
     }
 
-    accountPrivacyRulesValue = result;
+    accountPrivacyRulesValue = std::move(result);
 
     return *this;
 }
@@ -2815,7 +2817,7 @@ CTelegramStream &CTelegramStream::operator>>(TLAuthAuthorization &authAuthorizat
         break;
     }
 
-    authAuthorizationValue = result;
+    authAuthorizationValue = std::move(result);
 
     return *this;
 }
@@ -2835,7 +2837,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChannelsChannelParticipant &chann
         break;
     }
 
-    channelsChannelParticipantValue = result;
+    channelsChannelParticipantValue = std::move(result);
 
     return *this;
 }
@@ -2856,7 +2858,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChannelsChannelParticipants &chan
         break;
     }
 
-    channelsChannelParticipantsValue = result;
+    channelsChannelParticipantsValue = std::move(result);
 
     return *this;
 }
@@ -2911,7 +2913,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChat &chatValue)
         break;
     }
 
-    chatValue = result;
+    chatValue = std::move(result);
 
     return *this;
 }
@@ -2962,7 +2964,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChatFull &chatFullValue)
         break;
     }
 
-    chatFullValue = result;
+    chatFullValue = std::move(result);
 
     return *this;
 }
@@ -2985,7 +2987,7 @@ CTelegramStream &CTelegramStream::operator>>(TLChatInvite &chatInviteValue)
         break;
     }
 
-    chatInviteValue = result;
+    chatInviteValue = std::move(result);
 
     return *this;
 }
@@ -3022,7 +3024,7 @@ CTelegramStream &CTelegramStream::operator>>(TLConfig &configValue)
         break;
     }
 
-    configValue = result;
+    configValue = std::move(result);
 
     return *this;
 }
@@ -3047,7 +3049,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactsBlocked &contactsBlockedV
         break;
     }
 
-    contactsBlockedValue = result;
+    contactsBlockedValue = std::move(result);
 
     return *this;
 }
@@ -3069,7 +3071,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactsContacts &contactsContact
         break;
     }
 
-    contactsContactsValue = result;
+    contactsContactsValue = std::move(result);
 
     return *this;
 }
@@ -3090,7 +3092,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactsFound &contactsFoundValue
         break;
     }
 
-    contactsFoundValue = result;
+    contactsFoundValue = std::move(result);
 
     return *this;
 }
@@ -3111,7 +3113,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactsImportedContacts &contact
         break;
     }
 
-    contactsImportedContactsValue = result;
+    contactsImportedContactsValue = std::move(result);
 
     return *this;
 }
@@ -3132,7 +3134,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactsLink &contactsLinkValue)
         break;
     }
 
-    contactsLinkValue = result;
+    contactsLinkValue = std::move(result);
 
     return *this;
 }
@@ -3153,7 +3155,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactsResolvedPeer &contactsRes
         break;
     }
 
-    contactsResolvedPeerValue = result;
+    contactsResolvedPeerValue = std::move(result);
 
     return *this;
 }
@@ -3173,7 +3175,7 @@ CTelegramStream &CTelegramStream::operator>>(TLContactsSuggested &contactsSugges
         break;
     }
 
-    contactsSuggestedValue = result;
+    contactsSuggestedValue = std::move(result);
 
     return *this;
 }
@@ -3202,7 +3204,7 @@ CTelegramStream &CTelegramStream::operator>>(TLDocument &documentValue)
         break;
     }
 
-    documentValue = result;
+    documentValue = std::move(result);
 
     return *this;
 }
@@ -3231,7 +3233,7 @@ CTelegramStream &CTelegramStream::operator>>(TLFoundGif &foundGifValue)
         break;
     }
 
-    foundGifValue = result;
+    foundGifValue = std::move(result);
 
     return *this;
 }
@@ -3251,7 +3253,7 @@ CTelegramStream &CTelegramStream::operator>>(TLHelpSupport &helpSupportValue)
         break;
     }
 
-    helpSupportValue = result;
+    helpSupportValue = std::move(result);
 
     return *this;
 }
@@ -3300,7 +3302,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessageAction &messageActionValue
         break;
     }
 
-    messageActionValue = result;
+    messageActionValue = std::move(result);
 
     return *this;
 }
@@ -3322,7 +3324,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesAllStickers &messagesAllS
         break;
     }
 
-    messagesAllStickersValue = result;
+    messagesAllStickersValue = std::move(result);
 
     return *this;
 }
@@ -3343,7 +3345,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesChatFull &messagesChatFul
         break;
     }
 
-    messagesChatFullValue = result;
+    messagesChatFullValue = std::move(result);
 
     return *this;
 }
@@ -3362,7 +3364,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesChats &messagesChatsValue
         break;
     }
 
-    messagesChatsValue = result;
+    messagesChatsValue = std::move(result);
 
     return *this;
 }
@@ -3382,7 +3384,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesFoundGifs &messagesFoundG
         break;
     }
 
-    messagesFoundGifsValue = result;
+    messagesFoundGifsValue = std::move(result);
 
     return *this;
 }
@@ -3404,7 +3406,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesSavedGifs &messagesSavedG
         break;
     }
 
-    messagesSavedGifsValue = result;
+    messagesSavedGifsValue = std::move(result);
 
     return *this;
 }
@@ -3425,7 +3427,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesStickerSet &messagesStick
         break;
     }
 
-    messagesStickerSetValue = result;
+    messagesStickerSetValue = std::move(result);
 
     return *this;
 }
@@ -3447,7 +3449,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesStickers &messagesSticker
         break;
     }
 
-    messagesStickersValue = result;
+    messagesStickersValue = std::move(result);
 
     return *this;
 }
@@ -3467,7 +3469,7 @@ CTelegramStream &CTelegramStream::operator>>(TLPhotosPhoto &photosPhotoValue)
         break;
     }
 
-    photosPhotoValue = result;
+    photosPhotoValue = std::move(result);
 
     return *this;
 }
@@ -3492,7 +3494,7 @@ CTelegramStream &CTelegramStream::operator>>(TLPhotosPhotos &photosPhotosValue)
         break;
     }
 
-    photosPhotosValue = result;
+    photosPhotosValue = std::move(result);
 
     return *this;
 }
@@ -3516,7 +3518,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUserFull &userFullValue)
         break;
     }
 
-    userFullValue = result;
+    userFullValue = std::move(result);
 
     return *this;
 }
@@ -3581,7 +3583,7 @@ CTelegramStream &CTelegramStream::operator>>(TLWebPage &webPageValue)
         break;
     }
 
-    webPageValue = result;
+    webPageValue = std::move(result);
 
     return *this;
 }
@@ -3642,7 +3644,7 @@ CTelegramStream &CTelegramStream::operator>>(TLBotInlineResult &botInlineResultV
         break;
     }
 
-    botInlineResultValue = result;
+    botInlineResultValue = std::move(result);
 
     return *this;
 }
@@ -3696,7 +3698,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessageMedia &messageMediaValue)
         break;
     }
 
-    messageMediaValue = result;
+    messageMediaValue = std::move(result);
 
     return *this;
 }
@@ -3720,7 +3722,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesBotResults &messagesBotRe
         break;
     }
 
-    messagesBotResultsValue = result;
+    messagesBotResultsValue = std::move(result);
 
     return *this;
 }
@@ -3783,7 +3785,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessage &messageValue)
         break;
     }
 
-    messageValue = result;
+    messageValue = std::move(result);
 
     return *this;
 }
@@ -3812,7 +3814,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesDialogs &messagesDialogsV
         break;
     }
 
-    messagesDialogsValue = result;
+    messagesDialogsValue = std::move(result);
 
     return *this;
 }
@@ -3850,7 +3852,7 @@ CTelegramStream &CTelegramStream::operator>>(TLMessagesMessages &messagesMessage
         break;
     }
 
-    messagesMessagesValue = result;
+    messagesMessagesValue = std::move(result);
 
     return *this;
 }
@@ -4055,7 +4057,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUpdate &updateValue)
         break;
     }
 
-    updateValue = result;
+    updateValue = std::move(result);
 
     return *this;
 }
@@ -4154,7 +4156,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUpdates &updatesValue)
         break;
     }
 
-    updatesValue = result;
+    updatesValue = std::move(result);
 
     return *this;
 }
@@ -4203,7 +4205,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUpdatesChannelDifference &updates
         break;
     }
 
-    updatesChannelDifferenceValue = result;
+    updatesChannelDifferenceValue = std::move(result);
 
     return *this;
 }
@@ -4239,7 +4241,7 @@ CTelegramStream &CTelegramStream::operator>>(TLUpdatesDifference &updatesDiffere
         break;
     }
 
-    updatesDifferenceValue = result;
+    updatesDifferenceValue = std::move(result);
 
     return *this;
 }
@@ -4262,6 +4264,28 @@ CTelegramStream &CTelegramStream::operator<<(const TLVector<T> &v)
     return *this;
 }
 
+int CTelegramStream::serializedSize(const QString &str)
+{
+    // UTF-8 length without the conversion
+    int length = 0;
+    const int size = str.size();
+    for (int i = 0; i < size; ++i) {
+        const ushort c = str.at(i).unicode();
+        if (c < 0x80) {
+            length += 1;
+        } else if (c < 0x800) {
+            length += 2;
+        } else if (QChar::isHighSurrogate(c) && (i + 1 < size) && str.at(i + 1).isLowSurrogate()) {
+            length += 4;
+            ++i;
+        } else {
+            length += 3;
+        }
+    }
+
+    return bytesSerializedSize(length);
+}
+
 CTelegramStream &CTelegramStream::operator<<(const TLDcOption &dcOption)
 {
     *this << dcOption.tlType;
@@ -5226,3 +5250,957 @@ CTelegramStream &CTelegramStream::operator<<(const TLReplyMarkup &replyMarkupVal
 }
 
 // End of generated write operators implementation
+
+// Generated serialized size implementation
+int CTelegramStream::serializedSize(const TLAccountDaysTTL &accountDaysTTLValue)
+{
+    int size = serializedSize(accountDaysTTLValue.tlType);
+
+    switch (accountDaysTTLValue.tlType) {
+    case TLValue::AccountDaysTTL:
+        size += serializedSize(accountDaysTTLValue.days);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLAccountPasswordInputSettings &accountPasswordInputSettingsValue)
+{
+    int size = serializedSize(accountPasswordInputSettingsValue.tlType);
+
+    switch (accountPasswordInputSettingsValue.tlType) {
+    case TLValue::AccountPasswordInputSettings:
+        size += serializedSize(accountPasswordInputSettingsValue.flags);
+        if (accountPasswordInputSettingsValue.flags & 1 << 0) {
+            size += serializedSize(accountPasswordInputSettingsValue.newSalt);
+        }
+        if (accountPasswordInputSettingsValue.flags & 1 << 0) {
+            size += serializedSize(accountPasswordInputSettingsValue.newPasswordHash);
+        }
+        if (accountPasswordInputSettingsValue.flags & 1 << 0) {
+            size += serializedSize(accountPasswordInputSettingsValue.hint);
+        }
+        if (accountPasswordInputSettingsValue.flags & 1 << 1) {
+            size += serializedSize(accountPasswordInputSettingsValue.email);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLChannelParticipantRole &channelParticipantRoleValue)
+{
+    int size = serializedSize(channelParticipantRoleValue.tlType);
+
+    switch (channelParticipantRoleValue.tlType) {
+    case TLValue::ChannelRoleEmpty:
+        break;
+    case TLValue::ChannelRoleModerator:
+        break;
+    case TLValue::ChannelRoleEditor:
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLChannelParticipantsFilter &channelParticipantsFilterValue)
+{
+    int size = serializedSize(channelParticipantsFilterValue.tlType);
+
+    switch (channelParticipantsFilterValue.tlType) {
+    case TLValue::ChannelParticipantsRecent:
+        break;
+    case TLValue::ChannelParticipantsAdmins:
+        break;
+    case TLValue::ChannelParticipantsKicked:
+        break;
+    case TLValue::ChannelParticipantsBots:
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputAppEvent &inputAppEventValue)
+{
+    int size = serializedSize(inputAppEventValue.tlType);
+
+    switch (inputAppEventValue.tlType) {
+    case TLValue::InputAppEvent:
+        size += serializedSize(inputAppEventValue.time);
+        size += serializedSize(inputAppEventValue.type);
+        size += serializedSize(inputAppEventValue.peer);
+        size += serializedSize(inputAppEventValue.data);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputAudio &inputAudioValue)
+{
+    int size = serializedSize(inputAudioValue.tlType);
+
+    switch (inputAudioValue.tlType) {
+    case TLValue::InputAudioEmpty:
+        break;
+    case TLValue::InputAudio:
+        size += serializedSize(inputAudioValue.id);
+        size += serializedSize(inputAudioValue.accessHash);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputChannel &inputChannelValue)
+{
+    int size = serializedSize(inputChannelValue.tlType);
+
+    switch (inputChannelValue.tlType) {
+    case TLValue::InputChannelEmpty:
+        break;
+    case TLValue::InputChannel:
+        size += serializedSize(inputChannelValue.channelId);
+        size += serializedSize(inputChannelValue.accessHash);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputContact &inputContactValue)
+{
+    int size = serializedSize(inputContactValue.tlType);
+
+    switch (inputContactValue.tlType) {
+    case TLValue::InputPhoneContact:
+        size += serializedSize(inputContactValue.clientId);
+        size += serializedSize(inputContactValue.phone);
+        size += serializedSize(inputContactValue.firstName);
+        size += serializedSize(inputContactValue.lastName);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputDocument &inputDocumentValue)
+{
+    int size = serializedSize(inputDocumentValue.tlType);
+
+    switch (inputDocumentValue.tlType) {
+    case TLValue::InputDocumentEmpty:
+        break;
+    case TLValue::InputDocument:
+        size += serializedSize(inputDocumentValue.id);
+        size += serializedSize(inputDocumentValue.accessHash);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputEncryptedChat &inputEncryptedChatValue)
+{
+    int size = serializedSize(inputEncryptedChatValue.tlType);
+
+    switch (inputEncryptedChatValue.tlType) {
+    case TLValue::InputEncryptedChat:
+        size += serializedSize(inputEncryptedChatValue.chatId);
+        size += serializedSize(inputEncryptedChatValue.accessHash);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputEncryptedFile &inputEncryptedFileValue)
+{
+    int size = serializedSize(inputEncryptedFileValue.tlType);
+
+    switch (inputEncryptedFileValue.tlType) {
+    case TLValue::InputEncryptedFileEmpty:
+        break;
+    case TLValue::InputEncryptedFileUploaded:
+        size += serializedSize(inputEncryptedFileValue.id);
+        size += serializedSize(inputEncryptedFileValue.parts);
+        size += serializedSize(inputEncryptedFileValue.md5Checksum);
+        size += serializedSize(inputEncryptedFileValue.keyFingerprint);
+        break;
+    case TLValue::InputEncryptedFile:
+        size += serializedSize(inputEncryptedFileValue.id);
+        size += serializedSize(inputEncryptedFileValue.accessHash);
+        break;
+    case TLValue::InputEncryptedFileBigUploaded:
+        size += serializedSize(inputEncryptedFileValue.id);
+        size += serializedSize(inputEncryptedFileValue.parts);
+        size += serializedSize(inputEncryptedFileValue.keyFingerprint);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputFile &inputFileValue)
+{
+    int size = serializedSize(inputFileValue.tlType);
+
+    switch (inputFileValue.tlType) {
+    case TLValue::InputFile:
+        size += serializedSize(inputFileValue.id);
+        size += serializedSize(inputFileValue.parts);
+        size += serializedSize(inputFileValue.name);
+        size += serializedSize(inputFileValue.md5Checksum);
+        break;
+    case TLValue::InputFileBig:
+        size += serializedSize(inputFileValue.id);
+        size += serializedSize(inputFileValue.parts);
+        size += serializedSize(inputFileValue.name);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputFileLocation &inputFileLocationValue)
+{
+    int size = serializedSize(inputFileLocationValue.tlType);
+
+    switch (inputFileLocationValue.tlType) {
+    case TLValue::InputFileLocation:
+        size += serializedSize(inputFileLocationValue.volumeId);
+        size += serializedSize(inputFileLocationValue.localId);
+        size += serializedSize(inputFileLocationValue.secret);
+        break;
+    case TLValue::InputVideoFileLocation:
+        size += serializedSize(inputFileLocationValue.id);
+        size += serializedSize(inputFileLocationValue.accessHash);
+        break;
+    case TLValue::InputEncryptedFileLocation:
+        size += serializedSize(inputFileLocationValue.id);
+        size += serializedSize(inputFileLocationValue.accessHash);
+        break;
+    case TLValue::InputAudioFileLocation:
+        size += serializedSize(inputFileLocationValue.id);
+        size += serializedSize(inputFileLocationValue.accessHash);
+        break;
+    case TLValue::InputDocumentFileLocation:
+        size += serializedSize(inputFileLocationValue.id);
+        size += serializedSize(inputFileLocationValue.accessHash);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputGeoPoint &inputGeoPointValue)
+{
+    int size = serializedSize(inputGeoPointValue.tlType);
+
+    switch (inputGeoPointValue.tlType) {
+    case TLValue::InputGeoPointEmpty:
+        break;
+    case TLValue::InputGeoPoint:
+        size += serializedSize(inputGeoPointValue.latitude);
+        size += serializedSize(inputGeoPointValue.longitude);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputPeer &inputPeerValue)
+{
+    int size = serializedSize(inputPeerValue.tlType);
+
+    switch (inputPeerValue.tlType) {
+    case TLValue::InputPeerEmpty:
+        break;
+    case TLValue::InputPeerSelf:
+        break;
+    case TLValue::InputPeerChat:
+        size += serializedSize(inputPeerValue.chatId);
+        break;
+    case TLValue::InputPeerUser:
+        size += serializedSize(inputPeerValue.userId);
+        size += serializedSize(inputPeerValue.accessHash);
+        break;
+    case TLValue::InputPeerChannel:
+        size += serializedSize(inputPeerValue.channelId);
+        size += serializedSize(inputPeerValue.accessHash);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputPeerNotifySettings &inputPeerNotifySettingsValue)
+{
+    int size = serializedSize(inputPeerNotifySettingsValue.tlType);
+
+    switch (inputPeerNotifySettingsValue.tlType) {
+    case TLValue::InputPeerNotifySettings:
+        size += serializedSize(inputPeerNotifySettingsValue.muteUntil);
+        size += serializedSize(inputPeerNotifySettingsValue.sound);
+        size += serializedSize(inputPeerNotifySettingsValue.showPreviews);
+        size += serializedSize(inputPeerNotifySettingsValue.eventsMask);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputPhoto &inputPhotoValue)
+{
+    int size = serializedSize(inputPhotoValue.tlType);
+
+    switch (inputPhotoValue.tlType) {
+    case TLValue::InputPhotoEmpty:
+        break;
+    case TLValue::InputPhoto:
+        size += serializedSize(inputPhotoValue.id);
+        size += serializedSize(inputPhotoValue.accessHash);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputPhotoCrop &inputPhotoCropValue)
+{
+    int size = serializedSize(inputPhotoCropValue.tlType);
+
+    switch (inputPhotoCropValue.tlType) {
+    case TLValue::InputPhotoCropAuto:
+        break;
+    case TLValue::InputPhotoCrop:
+        size += serializedSize(inputPhotoCropValue.cropLeft);
+        size += serializedSize(inputPhotoCropValue.cropTop);
+        size += serializedSize(inputPhotoCropValue.cropWidth);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputPrivacyKey &inputPrivacyKeyValue)
+{
+    int size = serializedSize(inputPrivacyKeyValue.tlType);
+
+    switch (inputPrivacyKeyValue.tlType) {
+    case TLValue::InputPrivacyKeyStatusTimestamp:
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputStickerSet &inputStickerSetValue)
+{
+    int size = serializedSize(inputStickerSetValue.tlType);
+
+    switch (inputStickerSetValue.tlType) {
+    case TLValue::InputStickerSetEmpty:
+        break;
+    case TLValue::InputStickerSetID:
+        size += serializedSize(inputStickerSetValue.id);
+        size += serializedSize(inputStickerSetValue.accessHash);
+        break;
+    case TLValue::InputStickerSetShortName:
+        size += serializedSize(inputStickerSetValue.shortName);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputUser &inputUserValue)
+{
+    int size = serializedSize(inputUserValue.tlType);
+
+    switch (inputUserValue.tlType) {
+    case TLValue::InputUserEmpty:
+        break;
+    case TLValue::InputUserSelf:
+        break;
+    case TLValue::InputUser:
+        size += serializedSize(inputUserValue.userId);
+        size += serializedSize(inputUserValue.accessHash);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputVideo &inputVideoValue)
+{
+    int size = serializedSize(inputVideoValue.tlType);
+
+    switch (inputVideoValue.tlType) {
+    case TLValue::InputVideoEmpty:
+        break;
+    case TLValue::InputVideo:
+        size += serializedSize(inputVideoValue.id);
+        size += serializedSize(inputVideoValue.accessHash);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLKeyboardButton &keyboardButtonValue)
+{
+    int size = serializedSize(keyboardButtonValue.tlType);
+
+    switch (keyboardButtonValue.tlType) {
+    case TLValue::KeyboardButton:
+        size += serializedSize(keyboardButtonValue.text);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLKeyboardButtonRow &keyboardButtonRowValue)
+{
+    int size = serializedSize(keyboardButtonRowValue.tlType);
+
+    switch (keyboardButtonRowValue.tlType) {
+    case TLValue::KeyboardButtonRow:
+        size += serializedSize(keyboardButtonRowValue.buttons);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLMessageEntity &messageEntityValue)
+{
+    int size = serializedSize(messageEntityValue.tlType);
+
+    switch (messageEntityValue.tlType) {
+    case TLValue::MessageEntityUnknown:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        break;
+    case TLValue::MessageEntityMention:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        break;
+    case TLValue::MessageEntityHashtag:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        break;
+    case TLValue::MessageEntityBotCommand:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        break;
+    case TLValue::MessageEntityUrl:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        break;
+    case TLValue::MessageEntityEmail:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        break;
+    case TLValue::MessageEntityBold:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        break;
+    case TLValue::MessageEntityItalic:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        break;
+    case TLValue::MessageEntityCode:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        break;
+    case TLValue::MessageEntityPre:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        size += serializedSize(messageEntityValue.language);
+        break;
+    case TLValue::MessageEntityTextUrl:
+        size += serializedSize(messageEntityValue.offset);
+        size += serializedSize(messageEntityValue.length);
+        size += serializedSize(messageEntityValue.url);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLMessageRange &messageRangeValue)
+{
+    int size = serializedSize(messageRangeValue.tlType);
+
+    switch (messageRangeValue.tlType) {
+    case TLValue::MessageRange:
+        size += serializedSize(messageRangeValue.minId);
+        size += serializedSize(messageRangeValue.maxId);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLMessagesFilter &messagesFilterValue)
+{
+    int size = serializedSize(messagesFilterValue.tlType);
+
+    switch (messagesFilterValue.tlType) {
+    case TLValue::InputMessagesFilterEmpty:
+        break;
+    case TLValue::InputMessagesFilterPhotos:
+        break;
+    case TLValue::InputMessagesFilterVideo:
+        break;
+    case TLValue::InputMessagesFilterPhotoVideo:
+        break;
+    case TLValue::InputMessagesFilterPhotoVideoDocuments:
+        break;
+    case TLValue::InputMessagesFilterDocument:
+        break;
+    case TLValue::InputMessagesFilterAudio:
+        break;
+    case TLValue::InputMessagesFilterAudioDocuments:
+        break;
+    case TLValue::InputMessagesFilterUrl:
+        break;
+    case TLValue::InputMessagesFilterGif:
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLReportReason &reportReasonValue)
+{
+    int size = serializedSize(reportReasonValue.tlType);
+
+    switch (reportReasonValue.tlType) {
+    case TLValue::InputReportReasonSpam:
+        break;
+    case TLValue::InputReportReasonViolence:
+        break;
+    case TLValue::InputReportReasonPornography:
+        break;
+    case TLValue::InputReportReasonOther:
+        size += serializedSize(reportReasonValue.text);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLSendMessageAction &sendMessageActionValue)
+{
+    int size = serializedSize(sendMessageActionValue.tlType);
+
+    switch (sendMessageActionValue.tlType) {
+    case TLValue::SendMessageTypingAction:
+        break;
+    case TLValue::SendMessageCancelAction:
+        break;
+    case TLValue::SendMessageRecordVideoAction:
+        break;
+    case TLValue::SendMessageUploadVideoAction:
+        size += serializedSize(sendMessageActionValue.progress);
+        break;
+    case TLValue::SendMessageRecordAudioAction:
+        break;
+    case TLValue::SendMessageUploadAudioAction:
+        size += serializedSize(sendMessageActionValue.progress);
+        break;
+    case TLValue::SendMessageUploadPhotoAction:
+        size += serializedSize(sendMessageActionValue.progress);
+        break;
+    case TLValue::SendMessageUploadDocumentAction:
+        size += serializedSize(sendMessageActionValue.progress);
+        break;
+    case TLValue::SendMessageGeoLocationAction:
+        break;
+    case TLValue::SendMessageChooseContactAction:
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLTrue &trueValue)
+{
+    int size = serializedSize(trueValue.tlType);
+
+    switch (trueValue.tlType) {
+    case TLValue::True:
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLChannelMessagesFilter &channelMessagesFilterValue)
+{
+    int size = serializedSize(channelMessagesFilterValue.tlType);
+
+    switch (channelMessagesFilterValue.tlType) {
+    case TLValue::ChannelMessagesFilterEmpty:
+        break;
+    case TLValue::ChannelMessagesFilter:
+        size += serializedSize(channelMessagesFilterValue.flags);
+        size += serializedSize(channelMessagesFilterValue.ranges);
+        break;
+    case TLValue::ChannelMessagesFilterCollapsed:
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLDocumentAttribute &documentAttributeValue)
+{
+    int size = serializedSize(documentAttributeValue.tlType);
+
+    switch (documentAttributeValue.tlType) {
+    case TLValue::DocumentAttributeImageSize:
+        size += serializedSize(documentAttributeValue.w);
+        size += serializedSize(documentAttributeValue.h);
+        break;
+    case TLValue::DocumentAttributeAnimated:
+        break;
+    case TLValue::DocumentAttributeSticker:
+        size += serializedSize(documentAttributeValue.alt);
+        size += serializedSize(documentAttributeValue.stickerset);
+        break;
+    case TLValue::DocumentAttributeVideo:
+        size += serializedSize(documentAttributeValue.duration);
+        size += serializedSize(documentAttributeValue.w);
+        size += serializedSize(documentAttributeValue.h);
+        break;
+    case TLValue::DocumentAttributeAudio:
+        size += serializedSize(documentAttributeValue.duration);
+        size += serializedSize(documentAttributeValue.title);
+        size += serializedSize(documentAttributeValue.performer);
+        break;
+    case TLValue::DocumentAttributeFilename:
+        size += serializedSize(documentAttributeValue.fileName);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputBotInlineMessage &inputBotInlineMessageValue)
+{
+    int size = serializedSize(inputBotInlineMessageValue.tlType);
+
+    switch (inputBotInlineMessageValue.tlType) {
+    case TLValue::InputBotInlineMessageMediaAuto:
+        size += serializedSize(inputBotInlineMessageValue.caption);
+        break;
+    case TLValue::InputBotInlineMessageText:
+        size += serializedSize(inputBotInlineMessageValue.flags);
+        size += serializedSize(inputBotInlineMessageValue.message);
+        if (inputBotInlineMessageValue.flags & 1 << 1) {
+            size += serializedSize(inputBotInlineMessageValue.entities);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputBotInlineResult &inputBotInlineResultValue)
+{
+    int size = serializedSize(inputBotInlineResultValue.tlType);
+
+    switch (inputBotInlineResultValue.tlType) {
+    case TLValue::InputBotInlineResult:
+        size += serializedSize(inputBotInlineResultValue.flags);
+        size += serializedSize(inputBotInlineResultValue.id);
+        size += serializedSize(inputBotInlineResultValue.type);
+        if (inputBotInlineResultValue.flags & 1 << 1) {
+            size += serializedSize(inputBotInlineResultValue.title);
+        }
+        if (inputBotInlineResultValue.flags & 1 << 2) {
+            size += serializedSize(inputBotInlineResultValue.description);
+        }
+        if (inputBotInlineResultValue.flags & 1 << 3) {
+            size += serializedSize(inputBotInlineResultValue.url);
+        }
+        if (inputBotInlineResultValue.flags & 1 << 4) {
+            size += serializedSize(inputBotInlineResultValue.thumbUrl);
+        }
+        if (inputBotInlineResultValue.flags & 1 << 5) {
+            size += serializedSize(inputBotInlineResultValue.contentUrl);
+        }
+        if (inputBotInlineResultValue.flags & 1 << 5) {
+            size += serializedSize(inputBotInlineResultValue.contentType);
+        }
+        if (inputBotInlineResultValue.flags & 1 << 6) {
+            size += serializedSize(inputBotInlineResultValue.w);
+        }
+        if (inputBotInlineResultValue.flags & 1 << 6) {
+            size += serializedSize(inputBotInlineResultValue.h);
+        }
+        if (inputBotInlineResultValue.flags & 1 << 7) {
+            size += serializedSize(inputBotInlineResultValue.duration);
+        }
+        size += serializedSize(inputBotInlineResultValue.sendMessage);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputChatPhoto &inputChatPhotoValue)
+{
+    int size = serializedSize(inputChatPhotoValue.tlType);
+
+    switch (inputChatPhotoValue.tlType) {
+    case TLValue::InputChatPhotoEmpty:
+        break;
+    case TLValue::InputChatUploadedPhoto:
+        size += serializedSize(inputChatPhotoValue.file);
+        size += serializedSize(inputChatPhotoValue.crop);
+        break;
+    case TLValue::InputChatPhoto:
+        size += serializedSize(inputChatPhotoValue.id);
+        size += serializedSize(inputChatPhotoValue.crop);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputMedia &inputMediaValue)
+{
+    int size = serializedSize(inputMediaValue.tlType);
+
+    switch (inputMediaValue.tlType) {
+    case TLValue::InputMediaEmpty:
+        break;
+    case TLValue::InputMediaUploadedPhoto:
+        size += serializedSize(inputMediaValue.file);
+        size += serializedSize(inputMediaValue.caption);
+        break;
+    case TLValue::InputMediaPhoto:
+        size += serializedSize(inputMediaValue.idInputPhoto);
+        size += serializedSize(inputMediaValue.caption);
+        break;
+    case TLValue::InputMediaGeoPoint:
+        size += serializedSize(inputMediaValue.geoPoint);
+        break;
+    case TLValue::InputMediaContact:
+        size += serializedSize(inputMediaValue.phoneNumber);
+        size += serializedSize(inputMediaValue.firstName);
+        size += serializedSize(inputMediaValue.lastName);
+        break;
+    case TLValue::InputMediaUploadedVideo:
+        size += serializedSize(inputMediaValue.file);
+        size += serializedSize(inputMediaValue.duration);
+        size += serializedSize(inputMediaValue.w);
+        size += serializedSize(inputMediaValue.h);
+        size += serializedSize(inputMediaValue.mimeType);
+        size += serializedSize(inputMediaValue.caption);
+        break;
+    case TLValue::InputMediaUploadedThumbVideo:
+        size += serializedSize(inputMediaValue.file);
+        size += serializedSize(inputMediaValue.thumb);
+        size += serializedSize(inputMediaValue.duration);
+        size += serializedSize(inputMediaValue.w);
+        size += serializedSize(inputMediaValue.h);
+        size += serializedSize(inputMediaValue.mimeType);
+        size += serializedSize(inputMediaValue.caption);
+        break;
+    case TLValue::InputMediaVideo:
+        size += serializedSize(inputMediaValue.idInputVeo);
+        size += serializedSize(inputMediaValue.caption);
+        break;
+    case TLValue::InputMediaUploadedAudio:
+        size += serializedSize(inputMediaValue.file);
+        size += serializedSize(inputMediaValue.duration);
+        size += serializedSize(inputMediaValue.mimeType);
+        break;
+    case TLValue::InputMediaAudio:
+        size += serializedSize(inputMediaValue.idInputAudio);
+        break;
+    case TLValue::InputMediaUploadedDocument:
+        size += serializedSize(inputMediaValue.file);
+        size += serializedSize(inputMediaValue.mimeType);
+        size += serializedSize(inputMediaValue.attributes);
+        size += serializedSize(inputMediaValue.caption);
+        break;
+    case TLValue::InputMediaUploadedThumbDocument:
+        size += serializedSize(inputMediaValue.file);
+        size += serializedSize(inputMediaValue.thumb);
+        size += serializedSize(inputMediaValue.mimeType);
+        size += serializedSize(inputMediaValue.attributes);
+        size += serializedSize(inputMediaValue.caption);
+        break;
+    case TLValue::InputMediaDocument:
+        size += serializedSize(inputMediaValue.idInputDocument);
+        size += serializedSize(inputMediaValue.caption);
+        break;
+    case TLValue::InputMediaVenue:
+        size += serializedSize(inputMediaValue.geoPoint);
+        size += serializedSize(inputMediaValue.title);
+        size += serializedSize(inputMediaValue.address);
+        size += serializedSize(inputMediaValue.provider);
+        size += serializedSize(inputMediaValue.venueId);
+        break;
+    case TLValue::InputMediaGifExternal:
+        size += serializedSize(inputMediaValue.url);
+        size += serializedSize(inputMediaValue.q);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputNotifyPeer &inputNotifyPeerValue)
+{
+    int size = serializedSize(inputNotifyPeerValue.tlType);
+
+    switch (inputNotifyPeerValue.tlType) {
+    case TLValue::InputNotifyPeer:
+        size += serializedSize(inputNotifyPeerValue.peer);
+        break;
+    case TLValue::InputNotifyUsers:
+        break;
+    case TLValue::InputNotifyChats:
+        break;
+    case TLValue::InputNotifyAll:
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLInputPrivacyRule &inputPrivacyRuleValue)
+{
+    int size = serializedSize(inputPrivacyRuleValue.tlType);
+
+    switch (inputPrivacyRuleValue.tlType) {
+    case TLValue::InputPrivacyValueAllowContacts:
+        break;
+    case TLValue::InputPrivacyValueAllowAll:
+        break;
+    case TLValue::InputPrivacyValueAllowUsers:
+        size += serializedSize(inputPrivacyRuleValue.users);
+        break;
+    case TLValue::InputPrivacyValueDisallowContacts:
+        break;
+    case TLValue::InputPrivacyValueDisallowAll:
+        break;
+    case TLValue::InputPrivacyValueDisallowUsers:
+        size += serializedSize(inputPrivacyRuleValue.users);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+int CTelegramStream::serializedSize(const TLReplyMarkup &replyMarkupValue)
+{
+    int size = serializedSize(replyMarkupValue.tlType);
+
+    switch (replyMarkupValue.tlType) {
+    case TLValue::ReplyKeyboardHide:
+        size += serializedSize(replyMarkupValue.flags);
+        break;
+    case TLValue::ReplyKeyboardForceReply:
+        size += serializedSize(replyMarkupValue.flags);
+        break;
+    case TLValue::ReplyKeyboardMarkup:
+        size += serializedSize(replyMarkupValue.flags);
+        size += serializedSize(replyMarkupValue.rows);
+        break;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+// End of generated serialized size implementation
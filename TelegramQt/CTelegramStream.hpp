@@ -35,6 +35,10 @@ public:
         CRawStreamEx(data)
     {
     }
+    explicit CTelegramStream(const char *data, int size) :
+        CRawStreamEx(data, size)
+    {
+    }
 
     explicit CTelegramStream(QIODevice *d = 0) :
         CRawStreamEx(d)
@@ -247,6 +251,66 @@ public:
     template <typename T>
     CTelegramStream &operator<<(const TLVector<T> &v);
 
+    // Size of the data, written by the corresponding operator<<()
+    static int serializedSize(quint32) { return 4; }
+    static int serializedSize(quint64) { return 8; }
+    static int serializedSize(double) { return 8; }
+    static int serializedSize(TLValue) { return 4; }
+    static int serializedSize(const bool &) { return 4; }
+    static int serializedSize(const QByteArray &data);
+    static int serializedSize(const QString &str);
+
+    template <int Size>
+    static int serializedSize(const TLNumbers<Size> &) { return Size / 8; }
+
+    template <typename T>
+    static int serializedSize(const TLVector<T> &v);
+
+    // Generated serialized size declarations
+    static int serializedSize(const TLAccountDaysTTL &accountDaysTTLValue);
+    static int serializedSize(const TLAccountPasswordInputSettings &accountPasswordInputSettingsValue);
+    static int serializedSize(const TLChannelParticipantRole &channelParticipantRoleValue);
+    static int serializedSize(const TLChannelParticipantsFilter &channelParticipantsFilterValue);
+    static int serializedSize(const TLInputAppEvent &inputAppEventValue);
+    static int serializedSize(const TLInputAudio &inputAudioValue);
+    static int serializedSize(const TLInputChannel &inputChannelValue);
+    static int serializedSize(const TLInputContact &inputContactValue);
+    static int serializedSize(const TLInputDocument &inputDocumentValue);
+    static int serializedSize(const TLInputEncryptedChat &inputEncryptedChatValue);
+    static int serializedSize(const TLInputEncryptedFile &inputEncryptedFileValue);
+    static int serializedSize(const TLInputFile &inputFileValue);
+    static int serializedSize(const TLInputFileLocation &inputFileLocationValue);
+    static int serializedSize(const TLInputGeoPoint &inputGeoPointValue);
+    static int serializedSize(const TLInputPeer &inputPeerValue);
+    static int serializedSize(const TLInputPeerNotifySettings &inputPeerNotifySettingsValue);
+    static int serializedSize(const TLInputPhoto &inputPhotoValue);
+    static int serializedSize(const TLInputPhotoCrop &inputPhotoCropValue);
+    static int serializedSize(const TLInputPrivacyKey &inputPrivacyKeyValue);
+    static int serializedSize(const TLInputStickerSet &inputStickerSetValue);
+    static int serializedSize(const TLInputUser &inputUserValue);
+    static int serializedSize(const TLInputVideo &inputVideoValue);
+    static int serializedSize(const TLKeyboardButton &keyboardButtonValue);
+    static int serializedSize(const TLKeyboardButtonRow &keyboardButtonRowValue);
+    static int serializedSize(const TLMessageEntity &messageEntityValue);
+    static int serializedSize(const TLMessageRange &messageRangeValue);
+    static int serializedSize(const TLMessagesFilter &messagesFilterValue);
+    static int serializedSize(const TLReportReason &reportReasonValue);
+    static int serializedSize(const TLSendMessageAction &sendMessageActionValue);
+    static int serializedSize(const TLTrue &trueValue);
+    static int serializedSize(const TLChannelMessagesFilter &channelMessagesFilterValue);
+    static int serializedSize(const TLDocumentAttribute &documentAttributeValue);
+    static int serializedSize(const TLInputBotInlineMessage &inputBotInlineMessageValue);
+    static int serializedSize(const TLInputBotInlineResult &inputBotInlineResultValue);
+    static int serializedSize(const TLInputChatPhoto &inputChatPhotoValue);
+    static int serializedSize(const TLInputMedia &inputMediaValue);
+    static int serializedSize(const TLInputNotifyPeer &inputNotifyPeerValue);
+    static int serializedSize(const TLInputPrivacyRule &inputPrivacyRuleValue);
+    static int serializedSize(const TLReplyMarkup &replyMarkupValue);
+    // End of generated serialized size declarations
+
+protected:
+    static int bytesSerializedSize(int length);
+
 };
 
 inline CTelegramStream &CTelegramStream::operator>>(QString &str)
@@ -288,4 +352,32 @@ inline CTelegramStream &CTelegramStream::operator<<(const bool &data)
     return *this;
 }
 
+inline int CTelegramStream::bytesSerializedSize(int length)
+{
+    // One byte of length for the short data and four bytes otherwise, padded to a multiple of four
+    length += length < 0xfe ? 1 : 4;
+    return (length + 3) & ~3;
+}
+
+inline int CTelegramStream::serializedSize(const QByteArray &data)
+{
+    return bytesSerializedSize(data.size());
+}
+
+template <typename T>
+inline int CTelegramStream::serializedSize(const TLVector<T> &v)
+{
+    int size = serializedSize(v.tlType);
+
+    if (v.tlType == TLValue::Vector) {
+        size += serializedSize(quint32(v.count()));
+
+        for (int i = 0; i < v.count(); ++i) {
+            size += serializedSize(v.at(i));
+        }
+    }
+
+    return size;
+}
+
 #endif // CTELEGRAMSTREAM_HPP
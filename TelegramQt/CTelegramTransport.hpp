@@ -22,23 +22,67 @@
 
 #include <QByteArray>
 #include <QAbstractSocket>
+#include <QAtomicInt>
+
+#include "STransportOptions.hpp"
 
 class CTelegramTransport : public QObject
 {
     Q_OBJECT
 public:
-    CTelegramTransport(QObject *parent = 0) : QObject(parent) { }
+    CTelegramTransport(QObject *parent = 0) :
+        QObject(parent),
+        m_error(QAbstractSocket::UnknownSocketError),
+        m_state(QAbstractSocket::UnconnectedState),
+        m_framing(STransportOptions::FramingAbridged),
+        m_writeCoalescingEnabled(false),
+        m_packageCaptureEnabled(false),
+        m_sendBufferFull(false),
+        m_sendBufferHighWatermark(0),
+        m_sendBufferLowWatermark(0),
+        m_queuedBytes(0)
+    {
+    }
     virtual void connectToHost(const QString &ipAddress, quint32 port) = 0;
     virtual void disconnectFromHost() = 0;
 
     virtual bool isConnected() const = 0;
 
+    // Returns the last received package. The data may be owned by the transport,
+    // so the caller must copy it if it is needed after the readyRead() handler returns.
     virtual QByteArray getPackage() = 0;
 
+    // Same as getPackage(), but the readyRead() handler may modify the returned data in place (e.g. decrypt it).
+    // The default implementation returns a private copy of the package.
+    virtual char *getMutablePackage(int *size);
+
     QAbstractSocket::SocketError error() const { return m_error; }
     QAbstractSocket::SocketState state() const { return m_state; }
 
-    // Method for testing
+    // The framing takes effect on the next connection
+    STransportOptions::Framing framing() const { return m_framing; }
+    void setFraming(STransportOptions::Framing framing) { m_framing = framing; }
+
+    // If enabled, packages sent within one event loop iteration are written to the network at once
+    bool writeCoalescingEnabled() const { return m_writeCoalescingEnabled; }
+    virtual void setWriteCoalescingEnabled(bool enabled) { m_writeCoalescingEnabled = enabled; }
+
+    Q_INVOKABLE virtual void setOptions(const STransportOptions &options);
+
+    // Number of bytes, which are accepted by the transport, but not written to the network yet
+    virtual qint64 bytesToWrite() const { return 0; }
+
+    // Set once bytesToWrite() reaches the high watermark and reset once it drops to the low one.
+    // Bulk senders (e.g. uploads) should stop sending while the buffer is full.
+    bool isSendBufferFull() const { return m_sendBufferFull; }
+
+    // Thread-safe. Posts the package to the transport thread. Until it is sent, its size is counted
+    // by queuedBytes() and the send buffer state. Returns the queued bytes including the package.
+    int queuePackage(const QByteArray &package);
+    int queuedBytes() const { return m_queuedBytes.load(); }
+
+    // Methods for testing
+    void setPackageCaptureEnabled(bool enabled) { m_packageCaptureEnabled = enabled; }
     virtual QByteArray lastPackage() const = 0;
 
 signals:
@@ -47,20 +91,55 @@ signals:
 
     void readyRead();
     void timeout();
+    void sendBufferFullChanged(bool full);
 
 public slots:
     virtual void sendPackage(const QByteArray &package) = 0;
+    virtual void flush() { }
 
 protected:
     void setError(QAbstractSocket::SocketError error);
     void setState(QAbstractSocket::SocketState state);
 
+    bool packageCaptureEnabled() const { return m_packageCaptureEnabled; }
+
+    void updateSendBufferState();
+    void resetSendBufferState();
+
+private slots:
+    void sendQueuedPackage(const QByteArray &package);
+
 private:
     QAbstractSocket::SocketError m_error;
     QAbstractSocket::SocketState m_state;
+    STransportOptions::Framing m_framing;
+    bool m_writeCoalescingEnabled;
+    bool m_packageCaptureEnabled;
+    bool m_sendBufferFull;
+    qint64 m_sendBufferHighWatermark;
+    qint64 m_sendBufferLowWatermark;
+    QAtomicInt m_queuedBytes;
+    QByteArray m_mutablePackage;
 
 };
 
+inline void CTelegramTransport::setOptions(const STransportOptions &options)
+{
+    setFraming(options.framing);
+    setWriteCoalescingEnabled(options.writeCoalescing);
+
+    m_sendBufferHighWatermark = options.sendBufferHighWatermark;
+    m_sendBufferLowWatermark = qMin(options.sendBufferLowWatermark, options.sendBufferHighWatermark);
+    updateSendBufferState();
+}
+
+inline char *CTelegramTransport::getMutablePackage(int *size)
+{
+    m_mutablePackage = getPackage();
+    *size = m_mutablePackage.size();
+    return m_mutablePackage.data(); // Detaches
+}
+
 inline void CTelegramTransport::setError(QAbstractSocket::SocketError e)
 {
     m_error = e;
@@ -73,4 +152,45 @@ inline void CTelegramTransport::setState(QAbstractSocket::SocketState s)
     emit stateChanged(s);
 }
 
+inline int CTelegramTransport::queuePackage(const QByteArray &package)
+{
+    const int queuedBytes = m_queuedBytes.fetchAndAddOrdered(package.size()) + package.size();
+    QMetaObject::invokeMethod(this, "sendQueuedPackage", Qt::QueuedConnection, Q_ARG(QByteArray, package));
+    return queuedBytes;
+}
+
+inline void CTelegramTransport::sendQueuedPackage(const QByteArray &package)
+{
+    m_queuedBytes.fetchAndAddOrdered(-package.size());
+    sendPackage(package);
+
+    if (!m_queuedBytes.load() && !m_sendBufferFull) {
+        // The senders in other threads may consider the buffer full because of the queued bytes only
+        emit sendBufferFullChanged(false);
+    }
+}
+
+inline void CTelegramTransport::updateSendBufferState()
+{
+    const qint64 bytes = bytesToWrite() + m_queuedBytes.load();
+
+    if (m_sendBufferFull) {
+        if (!m_sendBufferHighWatermark || (bytes <= m_sendBufferLowWatermark)) {
+            m_sendBufferFull = false;
+            emit sendBufferFullChanged(false);
+        }
+    } else if (m_sendBufferHighWatermark && (bytes >= m_sendBufferHighWatermark)) {
+        m_sendBufferFull = true;
+        emit sendBufferFullChanged(true);
+    }
+}
+
+inline void CTelegramTransport::resetSendBufferState()
+{
+    if (m_sendBufferFull) {
+        m_sendBufferFull = false;
+        emit sendBufferFullChanged(false);
+    }
+}
+
 #endif // CTELEGRAMTRANSPORT_HPP
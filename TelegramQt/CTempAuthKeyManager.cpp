@@ -0,0 +1,157 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include "CTempAuthKeyManager.hpp"
+
+#include "CTelegramConnection.hpp"
+
+#include <QDateTime>
+#include <QTimer>
+#include <QDebug>
+
+#include <climits>
+
+static const quint32 s_defaultKeyLifetime = 24 * 60 * 60; // 1 day
+static const quint32 s_defaultRenewalMargin = 10 * 60; // 10 min
+static const quint32 s_retryInterval = 30; // sec
+
+CTempAuthKeyManager::CTempAuthKeyManager(const CAppInformation *appInfo, CTelegramConnection *connection, QObject *parent) :
+    QObject(parent),
+    m_appInfo(appInfo),
+    m_connection(connection),
+    m_keyConnection(0),
+    m_renewalTimer(new QTimer(this)),
+    m_keyLifetime(s_defaultKeyLifetime),
+    m_renewalMargin(s_defaultRenewalMargin),
+    m_keyExpiresAt(0),
+    m_active(false)
+{
+    m_renewalTimer->setSingleShot(true);
+    connect(m_renewalTimer, SIGNAL(timeout()), SLOT(prepareKey()));
+}
+
+CTempAuthKeyManager::~CTempAuthKeyManager()
+{
+    releaseKeyConnection();
+}
+
+void CTempAuthKeyManager::start()
+{
+    // The connection and the key connection are used directly, so they must be in the manager thread
+    Q_ASSERT(!m_connection || (m_connection->thread() == thread()));
+
+    if (m_active) {
+        return;
+    }
+
+    m_active = true;
+    prepareKey();
+}
+
+void CTempAuthKeyManager::stop()
+{
+    m_active = false;
+    m_renewalTimer->stop();
+    releaseKeyConnection();
+}
+
+void CTempAuthKeyManager::prepareKey()
+{
+    if (!m_active || m_keyConnection) {
+        return;
+    }
+
+    if (!m_connection || m_connection->authKey().isEmpty()) {
+        qWarning() << Q_FUNC_INFO << "There is no permanent key to bind to.";
+        return;
+    }
+
+    m_keyConnection = createKeyConnection();
+    m_keyConnection->setTempAuthKeyLifetime(m_keyLifetime);
+
+    connect(m_keyConnection, SIGNAL(authStateChanged(int,quint32)), SLOT(onKeyConnectionAuthStateChanged(int)));
+    connect(m_keyConnection, SIGNAL(tempAuthKeyBindingFinished(bool)), SLOT(onKeyBindingFinished(bool)));
+
+    m_keyConnection->connectToDc();
+}
+
+void CTempAuthKeyManager::onKeyConnectionAuthStateChanged(int state)
+{
+    if (sender() != m_keyConnection) {
+        return;
+    }
+
+    if (state != CTelegramConnection::AuthStateHaveAKey) {
+        return;
+    }
+
+    if (!m_connection || !m_keyConnection->bindTempAuthKey(m_connection->authKey())) {
+        onKeyBindingFinished(false);
+    }
+}
+
+void CTempAuthKeyManager::onKeyBindingFinished(bool bound)
+{
+    if (!m_keyConnection) {
+        return;
+    }
+
+    if (!bound || !m_connection) {
+        qDebug() << Q_FUNC_INFO << "Unable to bind the temporary key for dc" << m_keyConnection->dcInfo().id;
+        releaseKeyConnection();
+
+        // The current key (if any) is still valid, so retry a bit later
+        if (m_active) {
+            m_renewalTimer->start(s_retryInterval * 1000);
+        }
+        emit bindingFailed();
+        return;
+    }
+
+    // The requests in flight are answered with the previous key, so the connection is not interrupted
+    m_connection->setTempAuthKey(m_keyConnection->authKey(), m_keyConnection->serverSalt());
+    m_keyExpiresAt = m_keyConnection->authKeyExpiresAt();
+    releaseKeyConnection();
+
+    const quint32 renewIn = m_keyLifetime > m_renewalMargin * 2 ? m_keyLifetime - m_renewalMargin : m_keyLifetime / 2;
+    m_renewalTimer->start(qMin<quint32>(renewIn, INT_MAX / 1000) * 1000);
+
+    emit keyBound(m_keyExpiresAt);
+}
+
+CTelegramConnection *CTempAuthKeyManager::createKeyConnection()
+{
+    CTelegramConnection *keyConnection = new CTelegramConnection(m_appInfo, this);
+    keyConnection->setDcInfo(m_connection->dcInfo());
+    keyConnection->setTransportOptions(m_connection->transportOptions()); // Proxy, buffer sizes, etc
+    keyConnection->setServerRsaKey(m_connection->serverRsaKey());
+    keyConnection->setDeltaTime(m_connection->deltaTime());
+
+    return keyConnection;
+}
+
+void CTempAuthKeyManager::releaseKeyConnection()
+{
+    if (!m_keyConnection) {
+        return;
+    }
+
+    m_keyConnection->disconnect(this);
+    m_keyConnection->transport()->disconnectFromHost();
+    m_keyConnection->deleteLater();
+    m_keyConnection = 0;
+}
@@ -0,0 +1,83 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#ifndef CTEMPAUTHKEYMANAGER_HPP
+#define CTEMPAUTHKEYMANAGER_HPP
+
+#include <QObject>
+#include <QByteArray>
+#include <QPointer>
+
+class QTimer;
+
+class CAppInformation;
+class CTelegramConnection;
+
+// Keeps the connection on a bound temporary auth key (perfect forward secrecy).
+// The next key is generated and bound on a separate key connection ahead of the expiration,
+// so the connection switches to it without waiting for the DH exchange.
+// The manager must live in the thread of the connection.
+class CTempAuthKeyManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CTempAuthKeyManager(const CAppInformation *appInfo, CTelegramConnection *connection, QObject *parent = 0);
+    ~CTempAuthKeyManager();
+
+    CTelegramConnection *connection() const { return m_connection; }
+
+    quint32 keyLifetime() const { return m_keyLifetime; }
+    void setKeyLifetime(quint32 lifetime) { m_keyLifetime = lifetime; }
+
+    // The next key is prepared this number of seconds before the current one expires
+    quint32 renewalMargin() const { return m_renewalMargin; }
+    void setRenewalMargin(quint32 margin) { m_renewalMargin = margin; }
+
+    bool isActive() const { return m_active; }
+    quint32 keyExpiresAt() const { return m_keyExpiresAt; }
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void keyBound(quint32 expiresAt);
+    void bindingFailed();
+
+protected slots:
+    void prepareKey();
+    void onKeyConnectionAuthStateChanged(int state);
+    void onKeyBindingFinished(bool bound);
+
+protected:
+    // Creates a connection to the same DC, which generates the next temporary key
+    virtual CTelegramConnection *createKeyConnection();
+    void releaseKeyConnection();
+
+    const CAppInformation *m_appInfo;
+    QPointer<CTelegramConnection> m_connection;
+    CTelegramConnection *m_keyConnection;
+    QTimer *m_renewalTimer;
+
+    quint32 m_keyLifetime;
+    quint32 m_renewalMargin;
+    quint32 m_keyExpiresAt;
+    bool m_active;
+
+};
+
+#endif // CTEMPAUTHKEYMANAGER_HPP
@@ -0,0 +1,73 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#ifndef STRANSPORTOPTIONS_HPP
+#define STRANSPORTOPTIONS_HPP
+
+#include <QMetaType>
+
+struct STransportOptions {
+    enum Protocol {
+        ProtocolTcp,
+        ProtocolHttp
+    };
+
+    enum Framing {
+        FramingAbridged,
+        FramingIntermediate,
+        FramingFull
+    };
+
+    STransportOptions() :
+        protocol(ProtocolTcp),
+        framing(FramingAbridged),
+        writeCoalescing(false),
+        noDelay(false),
+        keepAlive(false),
+        keepAliveIdleTime(0),
+        keepAliveInterval(0),
+        keepAliveProbes(0),
+        sendBufferSize(0),
+        receiveBufferSize(0),
+        readBufferLimit(0),
+        sendBufferHighWatermark(0),
+        sendBufferLowWatermark(0)
+    {
+    }
+
+    // Takes effect on the next connection. HTTP is for the extra (media) connections only:
+    // no http_wait long poll is kept, so the updates would be delayed up to the ping interval.
+    Protocol protocol;
+    Framing framing; // Not used by the HTTP transport
+    bool writeCoalescing; // Packages sent within one event loop iteration are written to the network at once
+    bool noDelay; // TCP_NODELAY
+    bool keepAlive; // SO_KEEPALIVE
+    int keepAliveIdleTime; // (sec) 0 means system default
+    int keepAliveInterval; // (sec) 0 means system default
+    int keepAliveProbes; // 0 means system default
+    // The buffer sizes are applied before the connection, so they take effect on the next one.
+    // A fixed SO_RCVBUF disables the receive buffer autotuning on Linux.
+    int sendBufferSize; // SO_SNDBUF, 0 means system default
+    int receiveBufferSize; // SO_RCVBUF, 0 means system default (autotuning)
+    qint64 readBufferLimit; // Socket read buffer limit, 0 means unlimited
+    qint64 sendBufferHighWatermark; // 0 means unlimited
+    qint64 sendBufferLowWatermark;
+};
+
+Q_DECLARE_METATYPE(STransportOptions)
+
+#endif // STRANSPORTOPTIONS_HPP
@@ -23,6 +23,8 @@
 #include <QMetaType>
 #include <QVector>
 
+#include <utility>
+
 template <typename T>
 class TLVector : public QVector<T>
 {
@@ -31,6 +33,7 @@ public:
     explicit TLVector(int size) : QVector<T>(size), tlType(TLValue::Vector) { }
     TLVector(int size, const T &t) : QVector<T>(size, t), tlType(TLValue::Vector) { }
     TLVector(const TLVector<T> &v) : QVector<T>(v), tlType(v.tlType) { }
+    TLVector(TLVector<T> &&v) : QVector<T>(std::move(v)), tlType(v.tlType) { }
     TLVector(const QVector<T> &v) : QVector<T>(v), tlType(TLValue::Vector) { }
     TLVector(std::initializer_list<T> args) : QVector<T>(args) { }
 
@@ -62,6 +65,12 @@ public:
         return *this;
     }
 
+    TLVector &operator=(TLVector &&v) {
+        tlType = v.tlType;
+        QVector<T>::operator =(std::move(v));
+        return *this;
+    }
+
     TLValue tlType;
 };
 
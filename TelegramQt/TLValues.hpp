@@ -31,6 +31,7 @@ public:
         // Generated TLValues (proto)
         ResPQ = 0x05162463,
         PQInnerData = 0x83c95aec,
+        PQInnerDataTemp = 0x3c6a84d4,
         ServerDHParamsFail = 0x79cb045d,
         ServerDHParamsOk = 0xd0e8075c,
         ServerDHInnerData = 0xb5890dba,
@@ -61,6 +62,7 @@ public:
         MsgsAllInfo = 0x8cc0d131,
         MsgDetailedInfo = 0x276d3ec6,
         MsgNewDetailedInfo = 0x809db6df,
+        BindAuthKeyInner = 0x75a3f765,
         ReqPq = 0x60469778,
         ReqDHParams = 0xd712e4be,
         SetClientDHParams = 0xf5045f1f,
@@ -1,5 +1,5 @@
 
-QT = core network
+QT = core network concurrent
 
 TEMPLATE = lib
 TARGET   = TelegramQt$${QT_MAJOR_VERSION}
@@ -30,11 +30,16 @@ SOURCES = CTelegramCore.cpp \
     CRawStream.cpp \
     CTelegramStream.cpp \
     Utils.cpp \
+    CAesIgeCipher.cpp \
     FileRequestDescriptor.cpp \
     TelegramUtils.cpp \
     CTcpTransport.cpp \
+    CLoopbackTransport.cpp \
+    CHttpTransport.cpp \
     TelegramNamespace.cpp \
     CTelegramConnection.cpp \
+    CTempAuthKeyManager.cpp \
+    CAuthKeyGenerator.cpp \
     RpcProcessingContext.cpp \
     TLValues.cpp
 
@@ -43,8 +48,10 @@ PUBLIC_HEADERS += \
     CAppInformation.hpp \
     TelegramNamespace.hpp \
     CTelegramCore.hpp \
+    STransportOptions.hpp \
     TelegramQt/CAppInformation \
     TelegramQt/CTelegramCore \
+    TelegramQt/STransportOptions \
     TelegramQt/TelegramNamespace
 
 HEADERS = CTelegramCore.hpp \
@@ -56,15 +63,21 @@ HEADERS = CTelegramCore.hpp \
     CTelegramStream.hpp \
     CRawStream.hpp \
     Utils.hpp \
+    CAesIgeCipher.hpp \
     FileRequestDescriptor.hpp \
     TelegramUtils.hpp \
     CTelegramTransport.hpp \
+    STransportOptions.hpp \
     CTcpTransport.hpp \
+    CLoopbackTransport.hpp \
+    CHttpTransport.hpp \
     TLTypes.hpp \
     TLNumbers.hpp \
     crypto-aes.hpp \
     crypto-rsa.hpp \
     CTelegramConnection.hpp \
+    CTempAuthKeyManager.hpp \
+    CAuthKeyGenerator.hpp \
     RpcProcessingContext.hpp \
     TelegramNamespace.hpp \
     TelegramNamespace_p.hpp \
@@ -17,8 +17,11 @@
 
 #include "Utils.hpp"
 
-#include <openssl/aes.h>
+#include "CAesIgeCipher.hpp"
+
 #include <openssl/bn.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
 #include <openssl/pem.h>
 #include <openssl/rand.h>
 #include <openssl/rsa.h>
@@ -26,8 +29,21 @@
 #include <zlib.h>
 
 #include <QBuffer>
-#include <QCryptographicHash>
 #include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QThreadStorage>
+#include <QVector>
+#include <QtEndian>
+
+#ifdef Q_OS_UNIX
+#include <pthread.h>
+#endif
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#define EVP_MD_CTX_new EVP_MD_CTX_create
+#define EVP_MD_CTX_free EVP_MD_CTX_destroy
+#endif
 
 static const QByteArray s_hardcodedRsaDataKey("0c150023e2f70db7985ded064759cfecf0af328e69a41daf4d6f01b53813"
                                               "5a6f91f8f8b2a0ec9ba9720ce352efcf6c5680ffc424bd634864902de0b4"
@@ -41,9 +57,84 @@ static const QByteArray s_hardcodedRsaDataKey("0c150023e2f70db7985ded064759cfecf
 static const QByteArray s_hardcodedRsaDataExp("010001");
 static const quint64 s_hardcodedRsaDataFingersprint(0xc3b42b026ce86b21);
 
+namespace {
+
+// The padding, nonces and ids are taken from a per-thread buffer, which is refilled in large batches,
+// so RAND_bytes() (and the DRBG locking inside) is not called for every package.
+class CRandomPool
+{
+public:
+    CRandomPool() :
+        m_position(s_poolSize),
+        m_forkGeneration(s_forkGeneration.load())
+    {
+    }
+
+    ~CRandomPool()
+    {
+        OPENSSL_cleanse(m_buffer, sizeof(m_buffer));
+    }
+
+    int read(char *buffer, int count)
+    {
+        if (count > s_poolSize / 4) {
+            return RAND_bytes((unsigned char *) buffer, count);
+        }
+
+        if (m_forkGeneration != s_forkGeneration.load()) {
+            // The child process must not repeat the bytes of the parent one
+            m_forkGeneration = s_forkGeneration.load();
+            m_position = s_poolSize;
+        }
+
+        if (m_position + count > s_poolSize) {
+            if (RAND_bytes(m_buffer, s_poolSize) != 1) {
+                m_position = s_poolSize;
+                return 0;
+            }
+            m_position = 0;
+        }
+
+        // The used bytes are wiped, so they can not be recovered from the memory later
+        memcpy(buffer, m_buffer + m_position, count);
+        OPENSSL_cleanse(m_buffer + m_position, count);
+        m_position += count;
+
+        return 1;
+    }
+
+    static void onFork()
+    {
+        s_forkGeneration.ref();
+    }
+
+private:
+    static const int s_poolSize = 4096;
+    static QBasicAtomicInt s_forkGeneration;
+
+    unsigned char m_buffer[s_poolSize];
+    int m_position;
+    int m_forkGeneration;
+
+};
+
+QBasicAtomicInt CRandomPool::s_forkGeneration = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+} // namespace
+
+static QThreadStorage<CRandomPool *> s_randomPools;
+
 int Utils::randomBytes(char *buffer, int count)
 {
-    return RAND_bytes((unsigned char *) buffer, count);
+    if (!s_randomPools.hasLocalData()) {
+#ifdef Q_OS_UNIX
+        static const int forkHandlerRegistered = pthread_atfork(0, 0, &CRandomPool::onFork);
+        Q_UNUSED(forkHandlerRegistered)
+#endif
+        s_randomPools.setLocalData(new CRandomPool());
+    }
+
+    return s_randomPools.localData()->read(buffer, count);
 }
 
 // Slightly modified version of Euclidean algorithm. Once we are looking for prime numbers, we can drop parity of asked numbers.
@@ -65,50 +156,100 @@ quint64 Utils::greatestCommonOddDivisor(quint64 a, quint64 b)
     return b == 0 ? a : b;
 }
 
-// Yet another copy of some unknown pq-solver algorithm.
+static inline quint64 mulMod(quint64 a, quint64 b, quint64 modulo)
+{
+#if defined(__SIZEOF_INT128__)
+    return quint64((unsigned __int128)(a) * b % modulo);
+#else
+    // Add-and-double, which never overflows for modulo < 2^63
+    quint64 result = 0;
+    a %= modulo;
+    while (b) {
+        if (b & 1) {
+            result += a;
+            if (result >= modulo) {
+                result -= modulo;
+            }
+        }
+        a += a;
+        if (a >= modulo) {
+            a -= modulo;
+        }
+        b >>= 1;
+    }
+    return result;
+#endif
+}
+
+// f(x) = (x^2 + c) mod number
+static inline quint64 rhoStep(quint64 value, quint64 c, quint64 number)
+{
+    value = mulMod(value, value, number);
+    return value >= number - c ? value - (number - c) : value + c;
+}
+
+// SplitMix64. The generator is local and seeded, so the factorization does not depend on (or affect) the global rand() state.
+static inline quint64 nextRandom(quint64 *state)
+{
+    quint64 z = (*state += Q_UINT64_C(0x9e3779b97f4a7c15));
+    z = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+
+// Pollard's rho with the Brent's cycle detection. The gcd is computed once per s_batchSize steps on the product of the differences.
 // Links:
-// https://github.com/DrKLO/Telegram/blob/433f59c5b9ed17543d8e206c83f0bc7c7edb43a6/TMessagesProj/jni/jni.c#L86
-// https://github.com/ex3ndr/telegram-mt/blob/91b1186e567b0484d6f371b8e5c61c425daf867e/src/main/java/org/telegram/mtproto/secure/pq/PQLopatin.java#L35
-// https://github.com/vysheng/tg/blob/1dad2e89933085ea1e3d9fb1becb1907ce5de55f/mtproto-client.c#L296
+// https://maths-people.anu.edu.au/~brent/pd/rpb051i.pdf
 quint64 Utils::findDivider(quint64 number)
 {
-    int it = 0;
-    quint64 g = 0;
-    for (int i = 0; i < 3 || it < 10000; i++) {
-        const quint64 q = ((rand() & 15) + 17) % number;
-        quint64 x = (quint64) rand() % (number - 1) + 1;
-        quint64 y = x;
-        const quint32 lim = 1 << (i + 18);
-        for (quint32 j = 1; j < lim; j++) {
-            ++it;
-            quint64 a = x;
-            quint64 b = x;
-            quint64 c = q;
-            while (b) {
-                if (b & 1) {
-                    c += a;
-                    if (c >= number) {
-                        c -= number;
-                    }
-                }
-                a += a;
-                if (a >= number) {
-                    a -= number;
-                }
-                b >>= 1;
-            }
-            x = c;
-            const quint64 z = x < y ? number + x - y : x - y;
-            g = greatestCommonOddDivisor(z, number);
-            if (g != 1) {
-                return g;
+    static const quint64 s_batchSize = 128;
+    static const quint64 s_maxCycleLength = 1 << 24; // pq is a product of two 32-bit primes, so the expected length is about 2^16
+    static const int s_maxAttempts = 8;
+
+    if (number < 4) {
+        return 1;
+    }
+
+    if (!(number & 1)) {
+        return 2;
+    }
+
+    quint64 randomState = number;
+
+    for (int attempt = 0; attempt < s_maxAttempts; ++attempt) {
+        const quint64 c = nextRandom(&randomState) % (number - 1) + 1;
+        quint64 y = nextRandom(&randomState) % number;
+        quint64 x = y;
+        quint64 ys = y;
+        quint64 product = 1;
+        quint64 g = 1;
+
+        for (quint64 r = 1; (g == 1) && (r <= s_maxCycleLength); r <<= 1) {
+            x = y;
+            for (quint64 i = 0; i < r; ++i) {
+                y = rhoStep(y, c, number);
             }
-            if (!(j & (j - 1))) {
-                y = x;
+
+            for (quint64 k = 0; (k < r) && (g == 1); k += s_batchSize) {
+                ys = y;
+                const quint64 steps = qMin(s_batchSize, r - k);
+                for (quint64 i = 0; i < steps; ++i) {
+                    y = rhoStep(y, c, number);
+                    product = mulMod(product, x > y ? x - y : y - x, number);
+                }
+                g = greatestCommonOddDivisor(product, number);
             }
         }
 
-        if (g > 1 && g < number) {
+        if (g == number) {
+            // The batch went over the factor (or the product became zero), so repeat its steps one by one.
+            do {
+                ys = rhoStep(ys, c, number);
+                g = greatestCommonOddDivisor(x > ys ? x - ys : ys - x, number);
+            } while (g == 1);
+        }
+
+        if ((g > 1) && (g < number)) {
             return g;
         }
     }
@@ -116,14 +257,91 @@ quint64 Utils::findDivider(quint64 number)
     return 1;
 }
 
+static const EVP_MD *hashAlgorithm(CHashContext::Algorithm algorithm)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    // The digests are fetched once. The implicitly fetched EVP_sha1() would be fetched again on each reinitialization.
+    static EVP_MD *sha1 = EVP_MD_fetch(nullptr, "SHA1", nullptr);
+    static EVP_MD *sha256 = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    return algorithm == CHashContext::Sha1 ? sha1 : sha256;
+#else
+    return algorithm == CHashContext::Sha1 ? EVP_sha1() : EVP_sha256();
+#endif
+}
+
+CHashContext::CHashContext(Algorithm algorithm) :
+    m_context(EVP_MD_CTX_new()),
+    m_algorithm(algorithm)
+{
+    reset();
+}
+
+CHashContext::~CHashContext()
+{
+    EVP_MD_CTX_free(m_context);
+}
+
+void CHashContext::reset()
+{
+    EVP_DigestInit_ex(m_context, hashAlgorithm(m_algorithm), nullptr);
+}
+
+void CHashContext::addData(const char *data, int size)
+{
+    EVP_DigestUpdate(m_context, data, size);
+}
+
+void CHashContext::result(uchar *digest)
+{
+    EVP_DigestFinal_ex(m_context, digest, nullptr);
+    reset();
+}
+
+QByteArray CHashContext::result()
+{
+    QByteArray digest(resultSize(), Qt::Uninitialized);
+    result(reinterpret_cast<uchar *>(digest.data()));
+    return digest;
+}
+
+static QThreadStorage<CHashContext *> s_sha1Contexts;
+static QThreadStorage<CHashContext *> s_sha256Contexts;
+
+// The one-shot digests reuse a per-thread context instead of allocating one per call
+static CHashContext *localHashContext(CHashContext::Algorithm algorithm)
+{
+    QThreadStorage<CHashContext *> &contexts = algorithm == CHashContext::Sha1 ? s_sha1Contexts : s_sha256Contexts;
+    if (!contexts.hasLocalData()) {
+        contexts.setLocalData(new CHashContext(algorithm));
+    }
+
+    return contexts.localData();
+}
+
+static QByteArray hash(const QByteArray &data, CHashContext::Algorithm algorithm)
+{
+    CHashContext *context = localHashContext(algorithm);
+    context->addData(data);
+    return context->result();
+}
+
 QByteArray Utils::sha1(const QByteArray &data)
 {
-    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+    return hash(data, CHashContext::Sha1);
+}
+
+QByteArray Utils::sha1(std::initializer_list<QByteArray> segments)
+{
+    CHashContext *context = localHashContext(CHashContext::Sha1);
+    for (const QByteArray &segment : segments) {
+        context->addData(segment);
+    }
+    return context->result();
 }
 
 QByteArray Utils::sha256(const QByteArray &data)
 {
-    return QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+    return hash(data, CHashContext::Sha256);
 }
 
 QByteArray bnToBinArray(const BIGNUM *n)
@@ -191,60 +409,375 @@ SRsaKey Utils::loadRsaKey()
 //    return loadRsaKeyFromFile("telegram_server_key.pub");
 }
 
-QByteArray Utils::binaryNumberModExp(const QByteArray &data, const QByteArray &mod, const QByteArray &exp)
+namespace {
+
+// Neither BN_CTX nor BN_MONT_CTX may be shared between threads, so each thread has its own set of contexts.
+// The Montgomery context is cached per modulus: there are only a few of them (the DH prime and the RSA keys).
+class CModExpContext
 {
-    QByteArray result;
-    result.fill(char(0), 256);
+public:
+    CModExpContext() :
+        m_context(BN_CTX_new())
+    {
+    }
 
-    BN_CTX *bn_context = BN_CTX_new();
+    ~CModExpContext()
+    {
+        clearModuli();
+        BN_CTX_free(m_context);
+    }
 
-    BIGNUM *pubModulus = BN_new();
-    BIGNUM *pubExponent = BN_new();
-    BIGNUM *resultNum = BN_new();
-    BIGNUM *dataNum = BN_new();
+    BN_CTX *context() const { return m_context; }
 
-    binArrayToBN(mod, &pubModulus);
-    binArrayToBN(exp, &pubExponent);
+    // Returns false if the modulus is invalid. The returned objects are owned by the cache.
+    bool getModulus(const QByteArray &modulus, const BIGNUM **number, BN_MONT_CTX **montgomeryContext)
+    {
+        if (!m_moduli.contains(modulus)) {
+            if (m_moduli.count() >= s_maxModuliCount) {
+                clearModuli();
+            }
 
-    BN_bin2bn((uchar *) data.constData(), data.length(), dataNum);
+            SModulus entry;
+            entry.number = BN_bin2bn((const uchar *) modulus.constData(), modulus.length(), 0);
+            entry.montgomeryContext = 0;
 
-    BN_mod_exp(resultNum, dataNum, pubExponent, pubModulus, bn_context);
+            if (!entry.number || BN_is_zero(entry.number)) {
+                BN_free(entry.number);
+                return false;
+            }
 
-    BN_bn2bin(resultNum, (uchar *) result.data());
+            // Montgomery multiplication requires an odd modulus
+            if (BN_is_odd(entry.number)) {
+                entry.montgomeryContext = BN_MONT_CTX_new();
+                if (!BN_MONT_CTX_set(entry.montgomeryContext, entry.number, m_context)) {
+                    BN_MONT_CTX_free(entry.montgomeryContext);
+                    entry.montgomeryContext = 0;
+                }
+            }
 
-    BN_free(dataNum);
-    BN_free(resultNum);
-    BN_free(pubExponent);
-    BN_free(pubModulus);
+            m_moduli.insert(modulus, entry);
+        }
 
-    BN_CTX_free(bn_context);
+        const SModulus &entry = m_moduli[modulus];
+        *number = entry.number;
+        *montgomeryContext = entry.montgomeryContext;
+        return true;
+    }
 
-    return result;
+private:
+    struct SModulus {
+        BIGNUM *number;
+        BN_MONT_CTX *montgomeryContext;
+    };
+
+    void clearModuli()
+    {
+        for (const SModulus &entry : m_moduli) {
+            BN_MONT_CTX_free(entry.montgomeryContext);
+            BN_free(entry.number);
+        }
+        m_moduli.clear();
+    }
+
+    static const int s_maxModuliCount = 8;
+
+    BN_CTX *m_context;
+    QHash<QByteArray, SModulus> m_moduli;
+
+};
+
+// The DH primes, which passed the safe prime check, shared by all threads.
+// The entries (and their Montgomery contexts) are never removed, so the pointers stay valid. There are only a few primes in use.
+class CDhPrimeCache
+{
+public:
+    ~CDhPrimeCache()
+    {
+        for (const SPrime &entry : m_primes) {
+            BN_MONT_CTX_free(entry.montgomeryContext);
+            BN_free(entry.number);
+        }
+    }
+
+    // Returns the mask of the validated generators (bit g) or 0 if the prime is unknown
+    quint32 generators(const QByteArray &prime) const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_primes.value(prime).generators;
+    }
+
+    // Montgomery context for a validated prime. It is read only, so it can be used from any thread.
+    bool getModulus(const QByteArray &prime, const BIGNUM **number, BN_MONT_CTX **montgomeryContext) const
+    {
+        QMutexLocker locker(&m_mutex);
+        const QHash<QByteArray, SPrime>::const_iterator it = m_primes.constFind(prime);
+        if ((it == m_primes.constEnd()) || !it->montgomeryContext) {
+            return false;
+        }
+
+        *number = it->number;
+        *montgomeryContext = it->montgomeryContext;
+        return true;
+    }
+
+    void addGenerator(const QByteArray &prime, quint32 g, BN_CTX *context)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_primes.contains(prime)) {
+            m_primes[prime].generators |= 1u << g;
+            return;
+        }
+
+        if (m_primes.count() >= s_maxPrimesCount) {
+            return;
+        }
+
+        SPrime entry;
+        entry.generators = 1u << g;
+        entry.number = BN_bin2bn((const uchar *) prime.constData(), prime.length(), 0);
+        entry.montgomeryContext = BN_MONT_CTX_new();
+        if (!entry.number || !entry.montgomeryContext || !BN_MONT_CTX_set(entry.montgomeryContext, entry.number, context)) {
+            BN_MONT_CTX_free(entry.montgomeryContext);
+            BN_free(entry.number);
+            return;
+        }
+
+        m_primes.insert(prime, entry);
+    }
+
+    QList<QByteArray> primes() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_primes.keys();
+    }
+
+private:
+    struct SPrime {
+        SPrime() : number(0), montgomeryContext(0), generators(0) { }
+
+        BIGNUM *number;
+        BN_MONT_CTX *montgomeryContext;
+        quint32 generators;
+    };
+
+    static const int s_maxPrimesCount = 16;
+
+    mutable QMutex m_mutex;
+    QHash<QByteArray, SPrime> m_primes;
+
+};
+
+} // namespace
+
+static QThreadStorage<CModExpContext *> s_modExpContexts;
+static CDhPrimeCache s_dhPrimeCache;
+
+static CModExpContext *localModExpContext()
+{
+    if (!s_modExpContexts.hasLocalData()) {
+        s_modExpContexts.setLocalData(new CModExpContext());
+    }
+
+    return s_modExpContexts.localData();
 }
 
-QByteArray Utils::aesDecrypt(const QByteArray &data, const SAesKey &key)
+// The checks are described in the MTProto documentation: dh_prime is a 2048-bit safe prime and g generates
+// a cyclic subgroup of prime order (p - 1) / 2. The validated primes are cached, so the other connections skip the checks.
+bool Utils::checkDhParameters(const QByteArray &prime, quint32 g)
 {
-    QByteArray result = data;
+    if ((g < 2) || (g > 7)) {
+        return false;
+    }
+
+    if ((prime.length() != 2048 / 8) || !(prime.at(0) & 128)) {
+        return false;
+    }
 
-    QByteArray initVector = key.iv;
+    if (s_dhPrimeCache.generators(prime) & (1u << g)) {
+        return true;
+    }
+
+    BN_CTX *context = localModExpContext()->context();
+    BN_CTX_start(context);
+
+    BIGNUM *number = BN_CTX_get(context);
+    BIGNUM *halfNumber = BN_CTX_get(context);
+
+    bool valid = halfNumber && BN_bin2bn((const uchar *) prime.constData(), prime.length(), number);
 
-    AES_KEY dec_key;
-    AES_set_decrypt_key((const uchar *) key.key.constData(), key.key.length() * 8, &dec_key);
+    if (valid) {
+        // The generator check is cheap, so it is done first
+        switch (g) {
+        case 2:
+            valid = BN_mod_word(number, 8) == 7;
+            break;
+        case 3:
+            valid = BN_mod_word(number, 3) == 2;
+            break;
+        case 4:
+            break;
+        case 5:
+        {
+            const BN_ULONG mod = BN_mod_word(number, 5);
+            valid = (mod == 1) || (mod == 4);
+        }
+            break;
+        case 6:
+        {
+            const BN_ULONG mod = BN_mod_word(number, 24);
+            valid = (mod == 19) || (mod == 23);
+        }
+            break;
+        case 7:
+        {
+            const BN_ULONG mod = BN_mod_word(number, 7);
+            valid = (mod == 3) || (mod == 5) || (mod == 6);
+        }
+            break;
+        }
+    }
+
+    if (valid && !(s_dhPrimeCache.generators(prime))) {
+        valid = BN_rshift1(halfNumber, number)
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+                && (BN_check_prime(number, context, 0) == 1)
+                && (BN_check_prime(halfNumber, context, 0) == 1);
+#else
+                && (BN_is_prime_ex(number, BN_prime_checks, context, 0) == 1)
+                && (BN_is_prime_ex(halfNumber, BN_prime_checks, context, 0) == 1);
+#endif
+    }
+
+    BN_CTX_end(context);
+
+    if (valid) {
+        s_dhPrimeCache.addGenerator(prime, g, context);
+    }
+
+    return valid;
+}
+
+// Format: quint32 count, then the entries of quint32 generators mask (little endian) and 256 bytes of the prime.
+QByteArray Utils::dhPrimeCacheData()
+{
+    static const int entrySize = 4 + 2048 / 8;
+    const QList<QByteArray> primes = s_dhPrimeCache.primes();
+
+    QByteArray result(4 + primes.count() * entrySize, Qt::Uninitialized);
+    uchar *data = (uchar *) result.data();
+    qToLittleEndian<quint32>(primes.count(), data);
+    data += 4;
+
+    for (const QByteArray &prime : primes) {
+        qToLittleEndian<quint32>(s_dhPrimeCache.generators(prime), data);
+        memcpy(data + 4, prime.constData(), prime.size());
+        data += entrySize;
+    }
 
-    AES_ige_encrypt((const uchar *) data.constData(), (uchar *) result.data(), data.length(), &dec_key, (uchar *) initVector.data(), AES_DECRYPT);
     return result;
 }
 
-QByteArray Utils::aesEncrypt(const QByteArray &data, const SAesKey &key)
+// The data must come from a trusted storage, because the primes are not checked again.
+bool Utils::setDhPrimeCacheData(const QByteArray &cacheData)
 {
-    QByteArray result = data;
+    static const int entrySize = 4 + 2048 / 8;
+    if (cacheData.size() < 4) {
+        return false;
+    }
+
+    const uchar *data = (const uchar *) cacheData.constData();
+    const quint32 count = qFromLittleEndian<quint32>(data);
+    if (cacheData.size() != 4 + int(count) * entrySize) {
+        return false;
+    }
+
+    // The whole data is parsed first, so the cache is not changed if any entry is invalid
+    static const quint32 validGenerators = 0xfc; // Bits 2..7
+    QVector<QPair<QByteArray, quint32> > entries;
+    entries.reserve(count);
+
+    for (quint32 i = 0; i < count; ++i) {
+        const uchar *entry = data + 4 + i * entrySize;
+        const quint32 generators = qFromLittleEndian<quint32>(entry);
+        const QByteArray prime((const char *) entry + 4, 2048 / 8);
+
+        if (!(prime.at(0) & 128) || !generators || (generators & ~validGenerators)) {
+            return false;
+        }
+
+        entries.append(qMakePair(prime, generators));
+    }
+
+    BN_CTX *context = localModExpContext()->context();
+
+    for (const QPair<QByteArray, quint32> &entry : entries) {
+        for (quint32 g = 2; g <= 7; ++g) {
+            if (entry.second & (1u << g)) {
+                s_dhPrimeCache.addGenerator(entry.first, g, context);
+            }
+        }
+    }
+
+    return true;
+}
+
+// The result is padded with zero bytes to the modulus size.
+QByteArray Utils::binaryNumberModExp(const QByteArray &data, const QByteArray &mod, const QByteArray &exp)
+{
+    CModExpContext *modExpContext = localModExpContext();
+    BN_CTX *context = modExpContext->context();
+
+    const BIGNUM *modulus = 0;
+    BN_MONT_CTX *montgomeryContext = 0;
 
-    QByteArray initVector = key.iv;
+    // The validated DH primes have a shared Montgomery context, so the new threads do not set it up again
+    if (!s_dhPrimeCache.getModulus(mod, &modulus, &montgomeryContext)
+            && !modExpContext->getModulus(mod, &modulus, &montgomeryContext)) {
+        qWarning() << Q_FUNC_INFO << "Invalid modulus";
+        return QByteArray();
+    }
+
+    BN_CTX_start(context);
+
+    BIGNUM *dataNum = BN_CTX_get(context);
+    BIGNUM *exponent = BN_CTX_get(context);
+    BIGNUM *resultNum = BN_CTX_get(context);
+
+    QByteArray result;
+
+    if (resultNum
+            && BN_bin2bn((const uchar *) data.constData(), data.length(), dataNum)
+            && BN_bin2bn((const uchar *) exp.constData(), exp.length(), exponent)) {
+        int succeed;
+        if (montgomeryContext) {
+            succeed = BN_mod_exp_mont(resultNum, dataNum, exponent, modulus, context, montgomeryContext);
+        } else {
+            succeed = BN_mod_exp(resultNum, dataNum, exponent, modulus, context);
+        }
 
-    AES_KEY enc_key;
-    AES_set_encrypt_key((const uchar *) key.key.constData(), key.key.length() * 8, &enc_key);
+        if (succeed) {
+            result.fill(char(0), BN_num_bytes(modulus));
+            // The result is a big-endian number, so leading zero bytes must be kept.
+            BN_bn2bin(resultNum, (uchar *) result.data() + result.size() - BN_num_bytes(resultNum));
+        }
+    }
+
+    BN_CTX_end(context);
 
-    AES_ige_encrypt((const uchar *) data.constData(), (uchar *) result.data(), data.length(), &enc_key, (uchar *) initVector.data(), AES_ENCRYPT);
+    return result;
+}
+
+QByteArray Utils::aesDecrypt(const QByteArray &data, const SAesKey &key)
+{
+    QByteArray result = data;
+    CAesIgeCipher(key, CAesIgeCipher::Decryption).process(result.data(), result.size());
+    return result;
+}
+
+QByteArray Utils::aesEncrypt(const QByteArray &data, const SAesKey &key)
+{
+    QByteArray result = data;
+    CAesIgeCipher(key, CAesIgeCipher::Encryption).process(result.data(), result.size());
     return result;
 }
 
@@ -300,3 +833,10 @@ QByteArray Utils::unpackGZip(const QByteArray &data)
 
     return result;
 }
+
+// MTProto uses the zlib (IEEE 802.3) polynomial. It differs from the CRC-32C computed by the SSE4.2 crc32 instruction,
+// so we rely on the zlib implementation, which is table-driven or SIMD-accelerated depending on the zlib build.
+quint32 Utils::crc32(quint32 crc, const char *data, int size)
+{
+    return ::crc32(crc, reinterpret_cast<const Bytef *>(data), size);
+}
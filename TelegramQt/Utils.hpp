@@ -20,9 +20,46 @@
 
 #include <QByteArray>
 
+#include <initializer_list>
+
+#include <openssl/ossl_typ.h>
+
 #include "crypto-rsa.hpp"
 #include "crypto-aes.hpp"
 
+// Incremental hashing. Data segments are added one by one, so they do not need to be concatenated first.
+// It is based on the OpenSSL EVP API, which picks up the SHA-NI implementation if the CPU supports it.
+// The EVP context is allocated once and reinitialized for each digest, so a reused context saves the allocations.
+class CHashContext
+{
+public:
+    enum Algorithm {
+        Sha1,
+        Sha256
+    };
+
+    explicit CHashContext(Algorithm algorithm = Sha1);
+    ~CHashContext();
+
+    Algorithm algorithm() const { return m_algorithm; }
+    int resultSize() const { return m_algorithm == Sha1 ? 20 : 32; }
+
+    void reset();
+    void addData(const char *data, int size);
+    void addData(const QByteArray &data) { addData(data.constData(), data.size()); }
+
+    // Writes resultSize() bytes of the digest and resets the context, so it can be reused.
+    void result(uchar *digest);
+    QByteArray result();
+
+private:
+    Q_DISABLE_COPY(CHashContext)
+
+    EVP_MD_CTX *m_context;
+    Algorithm m_algorithm;
+
+};
+
 class Utils
 {
 public:
@@ -32,15 +69,21 @@ public:
     static quint64 greatestCommonOddDivisor(quint64 a, quint64 b);
     static quint64 findDivider(quint64 number);
     static QByteArray sha1(const QByteArray &data);
+    static QByteArray sha1(std::initializer_list<QByteArray> segments); // Use QByteArray::fromRawData() for zero-copy segments
     static QByteArray sha256(const QByteArray &data);
     static quint64 getFingersprint(const QByteArray &data, bool lowerOrderBits = true);
     static SRsaKey loadHardcodedKey();
     static SRsaKey loadRsaKey();
     static QByteArray binaryNumberModExp(const QByteArray &data, const QByteArray &mod, const QByteArray &exp);
+    static bool checkDhParameters(const QByteArray &prime, quint32 g);
+    // The validated DH primes can be saved and restored, so the checks are not repeated after restart
+    static QByteArray dhPrimeCacheData();
+    static bool setDhPrimeCacheData(const QByteArray &cacheData);
     static QByteArray rsa(const QByteArray &data, const SRsaKey &key);
     static QByteArray aesDecrypt(const QByteArray &data, const SAesKey &key);
     static QByteArray aesEncrypt(const QByteArray &data, const SAesKey &key);
     static QByteArray unpackGZip(const QByteArray &data);
+    static quint32 crc32(quint32 crc, const char *data, int size);
 
 };
 
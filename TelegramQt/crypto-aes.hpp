@@ -35,4 +35,16 @@ struct SAesKey {
     }
 };
 
+// The same key material in fixed-size arrays. It is used for the per-message keys, which must not allocate.
+struct SFixedAesKey {
+    uchar key[32];
+    uchar iv[32];
+
+    inline SAesKey toAesKey() const
+    {
+        return SAesKey(QByteArray(reinterpret_cast<const char *>(key), sizeof(key)),
+                       QByteArray(reinterpret_cast<const char *>(iv), sizeof(iv)));
+    }
+};
+
 #endif // CRYPTOAES_HPP
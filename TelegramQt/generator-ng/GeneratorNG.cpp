@@ -455,7 +455,7 @@ QString GeneratorNG::generateStreamReadOperatorDefinition(const TLType &type)
     }
 
     code.append(QString("%1default:\n%1%1break;\n%1}\n\n").arg(spacing));
-    code.append(QString("%1%2 = result;\n\n%1return *this;\n}\n\n").arg(spacing).arg(argName));
+    code.append(QString("%1%2 = std::move(result);\n\n%1return *this;\n}\n\n").arg(spacing).arg(argName));
 
     return code;
 }
@@ -506,6 +506,50 @@ QString GeneratorNG::generateStreamWriteVectorTemplate(const QString &type)
     return QString(QLatin1String("template %1 &%1::operator<<(const TLVector<%2> &v);")).arg(streamClassName).arg(type);
 }
 
+QString GeneratorNG::generateSerializedSizeDeclaration(const TLType &type)
+{
+    QString argName = removePrefix(type.name);
+    argName[0] = argName.at(0).toLower();
+    argName += QLatin1String("Value");
+    return spacing + QString("static int serializedSize(const %1 &%2);\n").arg(type.name).arg(argName);
+}
+
+QString GeneratorNG::generateSerializedSizeDefinition(const TLType &type)
+{
+    QString code;
+
+    QString argName = removePrefix(type.name);
+    argName[0] = argName.at(0).toLower();
+    argName += QLatin1String("Value");
+
+    code.append(QString("int %1::serializedSize(const %2 &%3)\n{\n").arg(streamClassName).arg(type.name).arg(argName));
+    code.append(QString("%1int size = serializedSize(%2.tlType);\n\n%1switch (%2.tlType) {\n").arg(spacing).arg(argName));
+
+    foreach (const TLSubType &subType, type.subTypes) {
+        code.append(QString("%1case %2::%3:\n").arg(spacing).arg(tlValueName).arg(subType.name));
+
+        foreach (const TLParam &member, subType.members) {
+            if (member.dependOnFlag()) {
+                if (member.type == QLatin1String("TLTrue")) {
+                    continue;
+                }
+                code.append(doubleSpacing + QString("if (%1.%2 & 1 << %3) {\n").arg(argName).arg(member.flagMember).arg(member.flagBit));
+                code.append(doubleSpacing + spacing + QString("size += serializedSize(%1.%2);\n").arg(argName).arg(member.name));
+                code.append(doubleSpacing + QLatin1Literal("}\n"));
+            } else {
+                code.append(doubleSpacing + QString("size += serializedSize(%1.%2);\n").arg(argName).arg(member.name));
+            }
+        }
+
+        code.append(QString("%1break;\n").arg(doubleSpacing));
+    }
+
+    code.append(QString("%1default:\n%1%1break;\n%1}\n\n").arg(spacing));
+    code.append(spacing + QString("return size;\n}\n\n"));
+
+    return code;
+}
+
 QString GeneratorNG::generateDebugWriteOperatorDeclaration(const TLType &type)
 {
     QString argName = removePrefix(type.name);
@@ -580,7 +624,24 @@ QString GeneratorNG::generateConnectionMethodDefinition(const TLMethod &method,
 {
     QString result;
     result += QString("quint64 %1::%2(%3)\n{\n").arg(methodsClassName).arg(method.name).arg(formatMethodParams(method));
+
+    // The payload size is known before the serialization, so the output is allocated once
+    result += spacing + QString("int payloadSize = %1::serializedSize(TLValue(%2::%3));\n").arg(streamClassName).arg(tlValueName).arg(formatName1stCapital(method.name));
+    foreach (const TLParam &param, method.params) {
+        const bool isTrueFlag = param.dependOnFlag() && (param.type == QLatin1String("TLTrue"));
+        const QString value = isTrueFlag ? param.type + QLatin1String("()") : param.name;
+        const QString sizeLine = QString("payloadSize += %1::serializedSize(%2);\n").arg(streamClassName).arg(value);
+        if (param.dependOnFlag()) {
+            result += spacing + QString("if (%1 & 1 << %2) {\n").arg(param.flagMember).arg(param.flagBit);
+            result += spacing + spacing + sizeLine;
+            result += spacing + QLatin1String("}\n");
+        } else {
+            result += spacing + sizeLine;
+        }
+    }
+
     result += spacing + QLatin1String("QByteArray output;\n");
+    result += spacing + QLatin1String("output.reserve(payloadSize);\n");
     result += spacing + streamClassName + QLatin1String(" outputStream(&output, /* write */ true);\n");
 
     result += spacing + QString("outputStream << %1::%2;\n").arg(tlValueName).arg(formatName1stCapital(method.name));
@@ -1005,6 +1066,8 @@ void GeneratorNG::generate()
     codeStreamWriteDeclarations.clear();
     codeStreamWriteDefinitions.clear();
     codeStreamWriteTemplateInstancing.clear();
+    codeSerializedSizeDeclarations.clear();
+    codeSerializedSizeDefinitions.clear();
     codeConnectionDeclarations.clear();
     codeConnectionDefinitions.clear();
     codeRpcProcessDeclarations.clear();
@@ -1181,6 +1244,8 @@ void GeneratorNG::generate()
         if (typesUsedForWrite.contains(type.name)) {
             codeStreamWriteDeclarations.append(generateStreamWriteOperatorDeclaration(type));
             codeStreamWriteDefinitions.append(generateStreamWriteOperatorDefinition(type));
+            codeSerializedSizeDeclarations.append(generateSerializedSizeDeclaration(type));
+            codeSerializedSizeDefinitions.append(generateSerializedSizeDefinition(type));
         }
 
         codeDebugWriteDeclarations.append(generateDebugWriteOperatorDeclaration(type));
@@ -92,6 +92,8 @@ public:
     static QString generateStreamWriteOperatorDeclaration(const TLType &type);
     static QString generateStreamWriteOperatorDefinition(const TLType &type);
     static QString generateStreamWriteVectorTemplate(const QString &type);
+    static QString generateSerializedSizeDeclaration(const TLType &type);
+    static QString generateSerializedSizeDefinition(const TLType &type);
 
     static QString generateDebugWriteOperatorDeclaration(const TLType &type);
     static QString generateDebugWriteOperatorDefinition(const TLType &type);
@@ -118,6 +120,8 @@ public:
     QString codeStreamWriteDeclarations;
     QString codeStreamWriteDefinitions;
     QString codeStreamWriteTemplateInstancing;
+    QString codeSerializedSizeDeclarations;
+    QString codeSerializedSizeDefinitions;
     QString codeConnectionDeclarations;
     QString codeConnectionDefinitions;
     QString codeRpcProcessDeclarations;
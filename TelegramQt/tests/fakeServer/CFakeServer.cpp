@@ -0,0 +1,179 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include "CFakeServer.hpp"
+#include "CFakeServerConnection.hpp"
+
+#include "CLoopbackTransport.hpp"
+#include "CTelegramStream.hpp"
+#include "Utils.hpp"
+
+#include <QDateTime>
+
+// The key pair is generated for the tests only.
+static const QByteArray s_rsaModulus("ca50e3ef143020a5fec4455f93b97f6e24162bcd52276b8cbdea012196c2"
+                                     "1cfebf2b51b17f860706d06055a8a715d9f155f90e5c6368e2cf9052018a"
+                                     "ebdbecd6626564e8707102325d11e5c9c35bca244dc57f6522310239e4a5"
+                                     "9ccacf8bfcda024fc714d89cf4bb8ba0abe79a0279cf7422e8148c8fbed0"
+                                     "05530c6e0a68a613324dec7c1f03adc311478f0ace52ae43a1b4c3713a2e"
+                                     "79ce39373add7433607f2bf09412ff587f80537ed6ad24f0768f273991db"
+                                     "34dfb4a18850180747973806a0e277f30018e27603f6890621c8f47ab368"
+                                     "052c2f6af1f84c73a047995f8bc930eeac7a4eba4c966b1cf9eefd469ca4"
+                                     "f0bc8f27b24d218d7b513d59d2ce4fbf");
+static const QByteArray s_rsaPrivateExponent("57ec197270028e5db53f14aaf9a6f6b325e9a0b5850b6e98e67bc86c1179"
+                                             "6062712fe13bd320aaf312219b7844cca13f594e78283c677b921ab518c8"
+                                             "87c1b6c66052922cd598b70cae17b6161dd9491ac7d5998c98f455745562"
+                                             "87a637d62d578d03a08ff5a718505cd8c17c5018dd5903ae9bcf3a5ac9e0"
+                                             "db3f813a5d39a75a0fc3a87096b92494db0c9dec1c08fc01d0f400c1c8e0"
+                                             "96b24a0596bf0c375ceab2657f950733559006e2210d3ad23741dcfc3c91"
+                                             "01ae7ed8479cbad4760887fe64c875f8696f07b69538b29bf54ef5dfb4ad"
+                                             "38bde6a3535d8418dc6d2c4089e81d7960659321edf9dfef26c431c71b9f"
+                                             "beb864b97a1bfc41e1e18d0f84224789");
+static const QByteArray s_rsaExponent("010001");
+
+// 2048-bit safe prime, which is used by the Telegram servers.
+static const QByteArray s_dhPrime("c71caeb9c6b1c9048e6c522f70f13f73980d40238e3e21c14934d037563d930f"
+                                  "48198a0aa7c14058229493d22530f4dbfa336f6e0ac925139543aed44cce7c37"
+                                  "20fd51f69458705ac68cd4fe6b6b13abdc9746512969328454f18faf8c595f64"
+                                  "2477fe96bb2a941d5bcd1d4ac8cc49880708fa9b378e3c4f3a9060bee67cf9a4"
+                                  "a4a695811051907e162753b56b0f6b410dba74d8a84b2a14b3144e0ef1284754"
+                                  "fd17ed950d5965b4b9dd46582db1178d169c6bc465b0d6ff9ca3928fef5b9ae4"
+                                  "e418fc15e83ebea0f87fa9ff5eed70050ded2849f47bf959d956850ce929851f"
+                                  "0d8115f635b105ee2e4e15d04b2454bf6f4fadf034b10403119cd8e3b92fcc5b");
+static const quint32 s_g = 3;
+
+// pq = 1229739323 * 1402015859, the example from the MTProto documentation.
+static const quint64 s_pq = Q_UINT64_C(0x17ED48941A08F981);
+
+CFakeServer::CFakeServer(QObject *parent) :
+    QObject(parent),
+    m_privateExponent(QByteArray::fromHex(s_rsaPrivateExponent)),
+    m_dhPrime(QByteArray::fromHex(s_dhPrime)),
+    m_g(s_g),
+    m_badServerSaltCount(0)
+{
+    m_publicKey.key = QByteArray::fromHex(s_rsaModulus);
+    m_publicKey.exp = QByteArray::fromHex(s_rsaExponent);
+
+    // RSA key fingerprint is the lower 64 bits of SHA1(n + e), serialized as TL bytes.
+    QByteArray keyData;
+    CTelegramStream keyStream(&keyData, /* write */ true);
+    keyStream << m_publicKey.key;
+    keyStream << m_publicKey.exp;
+    m_publicKey.fingersprint = Utils::getFingersprint(keyData);
+
+    m_dcOption.id = 1;
+    m_dcOption.ipAddress = QLatin1String("127.0.0.1");
+    m_dcOption.port = 443;
+
+    updateConfigAnswer();
+}
+
+quint64 CFakeServer::pq() const
+{
+    return s_pq;
+}
+
+void CFakeServer::setDcOption(const TLDcOption &option)
+{
+    m_dcOption = option;
+    updateConfigAnswer();
+}
+
+void CFakeServer::setScriptedAnswer(TLValue method, const QByteArray &answer)
+{
+    m_scriptedAnswers.insert(method, answer);
+}
+
+void CFakeServer::registerAuthKey(const QByteArray &authKey)
+{
+    m_authKeys.insert(Utils::getFingersprint(authKey), authKey);
+}
+
+void CFakeServer::bindAuthKey(quint64 tempAuthId, quint64 permAuthId)
+{
+    m_boundAuthIds.insert(tempAuthId, permAuthId);
+}
+
+bool CFakeServer::takeBadServerSaltAnswer()
+{
+    if (m_badServerSaltCount <= 0) {
+        return false;
+    }
+
+    --m_badServerSaltCount;
+    return true;
+}
+
+CFakeServerConnection *CFakeServer::addClient(CLoopbackTransport *clientTransport)
+{
+    CLoopbackTransport *serverTransport = new CLoopbackTransport();
+    CLoopbackTransport::link(clientTransport, serverTransport);
+
+    CFakeServerConnection *connection = new CFakeServerConnection(this, serverTransport, this);
+    connect(connection, SIGNAL(authStateChanged(int)), SLOT(onConnectionAuthStateChanged(int)));
+    m_connections.append(connection);
+
+    return connection;
+}
+
+void CFakeServer::onConnectionAuthStateChanged(int state)
+{
+    CFakeServerConnection *connection = qobject_cast<CFakeServerConnection *>(sender());
+
+    if (connection && (state == CFakeServerConnection::AuthStateHaveAKey)) {
+        registerAuthKey(connection->authKey());
+        emit clientAuthorized(connection);
+    }
+}
+
+void CFakeServer::updateConfigAnswer()
+{
+    const quint32 date = QDateTime::currentMSecsSinceEpoch() / 1000;
+
+    TLVector<TLDcOption> dcOptions;
+    dcOptions.append(m_dcOption);
+
+    QByteArray answer;
+    CTelegramStream stream(&answer, /* write */ true);
+
+    stream << TLValue::Config;
+    stream << date;
+    stream << quint32(date + 3600); // expires
+    stream << true; // testMode
+    stream << m_dcOption.id;
+    stream << dcOptions;
+    stream << quint32(200); // chatSizeMax
+    stream << quint32(1000); // megagroupSizeMax
+    stream << quint32(100); // forwardedCountMax
+    stream << quint32(120000); // onlineUpdatePeriodMs
+    stream << quint32(5000); // offlineBlurTimeoutMs
+    stream << quint32(30000); // offlineIdleTimeoutMs
+    stream << quint32(300000); // onlineCloudTimeoutMs
+    stream << quint32(30000); // notifyCloudDelayMs
+    stream << quint32(1500); // notifyDefaultDelayMs
+    stream << quint32(10); // chatBigSize
+    stream << quint32(60000); // pushChatPeriodMs
+    stream << quint32(2); // pushChatLimit
+    stream << quint32(100); // savedGifsLimit
+
+    // Empty disabledFeatures vector
+    stream << TLValue::Vector;
+    stream << quint32(0);
+
+    setScriptedAnswer(TLValue::HelpGetConfig, answer);
+}
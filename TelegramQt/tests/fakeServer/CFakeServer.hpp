@@ -0,0 +1,96 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#ifndef CFAKESERVER_HPP
+#define CFAKESERVER_HPP
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+
+#include "TLTypes.hpp"
+#include "crypto-rsa.hpp"
+
+class CFakeServerConnection;
+class CLoopbackTransport;
+
+// Minimal local MTProto server. It completes the DH key exchange and answers
+// a scripted subset of RPC. Intended for network-free tests and benchmarks.
+class CFakeServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CFakeServer(QObject *parent = 0);
+
+    // Key to be set on the client connections via CTelegramConnection::setServerRsaKey()
+    SRsaKey publicKey() const { return m_publicKey; }
+    QByteArray privateExponent() const { return m_privateExponent; }
+
+    QByteArray dhPrime() const { return m_dhPrime; }
+    quint32 g() const { return m_g; }
+
+    quint64 pq() const;
+
+    TLDcOption dcOption() const { return m_dcOption; }
+    void setDcOption(const TLDcOption &option);
+
+    // The answer is sent to the client as the rpc_result content
+    QByteArray scriptedAnswer(TLValue method) const { return m_scriptedAnswers.value(method); }
+    void setScriptedAnswer(TLValue method, const QByteArray &answer);
+
+    QVector<CFakeServerConnection *> connections() const { return m_connections; }
+
+    // The keys, generated on any connection, are accepted on all of them
+    QByteArray authKey(quint64 authId) const { return m_authKeys.value(authId); }
+    void registerAuthKey(const QByteArray &authKey);
+
+    // Returns the id of the permanent key, which the temporary one is bound to
+    quint64 boundAuthId(quint64 tempAuthId) const { return m_boundAuthIds.value(tempAuthId); }
+    void bindAuthKey(quint64 tempAuthId, quint64 permAuthId);
+
+    // The next count encrypted messages are answered with bad_server_salt and a new salt
+    void setBadServerSaltCount(int count) { m_badServerSaltCount = count; }
+    bool takeBadServerSaltAnswer();
+
+    // Creates a server side transport for the client one and starts a new session on it
+    CFakeServerConnection *addClient(CLoopbackTransport *clientTransport);
+
+signals:
+    void clientAuthorized(CFakeServerConnection *connection);
+
+protected slots:
+    void onConnectionAuthStateChanged(int state);
+
+protected:
+    void updateConfigAnswer();
+
+    SRsaKey m_publicKey;
+    QByteArray m_privateExponent;
+    QByteArray m_dhPrime;
+    quint32 m_g;
+
+    TLDcOption m_dcOption;
+
+    QHash<quint32, QByteArray> m_scriptedAnswers; // <method, rpc_result content>
+    QVector<CFakeServerConnection *> m_connections;
+    QHash<quint64, QByteArray> m_authKeys;
+    QHash<quint64, quint64> m_boundAuthIds; // <temp auth id, perm auth id>
+    int m_badServerSaltCount;
+
+};
+
+#endif // CFAKESERVER_HPP
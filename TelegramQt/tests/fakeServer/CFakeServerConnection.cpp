@@ -0,0 +1,711 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include "CFakeServerConnection.hpp"
+#include "CFakeServer.hpp"
+
+#include "CTelegramConnection.hpp"
+#include "CTelegramStream.hpp"
+#include "CTelegramTransport.hpp"
+#include "Utils.hpp"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QtEndian>
+
+CFakeServerConnection::CFakeServerConnection(CFakeServer *server, CTelegramTransport *transport, QObject *parent) :
+    QObject(parent),
+    m_server(server),
+    m_transport(transport),
+    m_authState(AuthStateNone),
+    m_authId(0),
+    m_serverSalt(0),
+    m_sessionId(0),
+    m_lastMessageId(0),
+    m_contentRelatedMessages(0),
+    m_processedRpcCount(0)
+{
+    m_transport->setParent(this);
+
+    connect(m_transport, SIGNAL(stateChanged(QAbstractSocket::SocketState)), SLOT(onTransportStateChanged()));
+    connect(m_transport, SIGNAL(readyRead()), SLOT(onTransportReadyRead()));
+}
+
+void CFakeServerConnection::onTransportStateChanged()
+{
+    if (m_transport->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    // An unfinished key exchange can not be continued on a new connection
+    if (m_authState != AuthStateHaveAKey) {
+        setAuthState(AuthStateNone);
+    }
+}
+
+void CFakeServerConnection::onTransportReadyRead()
+{
+    const QByteArray package = m_transport->getPackage();
+    CRawStream inputStream(package);
+
+    quint64 authId = 0;
+    inputStream >> authId;
+
+    if (authId) {
+        if (!processEncryptedPackage(package)) {
+            qDebug() << Q_FUNC_INFO << "Unable to process the encrypted package.";
+        }
+        return;
+    }
+
+    quint64 messageId = 0;
+    quint32 length = 0;
+
+    inputStream >> messageId;
+    inputStream >> length;
+
+    if (inputStream.bytesRemaining() != int(length)) {
+        qDebug() << Q_FUNC_INFO << "Corrupted packet. Specified length does not equal to real length";
+        return;
+    }
+
+    const QByteArray payload = inputStream.readBytes(length);
+
+    TLValue request;
+    CTelegramStream requestStream(payload);
+    requestStream >> request;
+
+    bool processed = false;
+
+    switch (request) {
+    case TLValue::ReqPq:
+        processed = processReqPq(payload);
+        break;
+    case TLValue::ReqDHParams:
+        processed = (m_authState == AuthStatePqSent) && processReqDhParams(payload);
+        break;
+    case TLValue::SetClientDHParams:
+        processed = (m_authState == AuthStateDhSent) && processSetClientDhParams(payload);
+        break;
+    default:
+        break;
+    }
+
+    if (!processed) {
+        qDebug() << Q_FUNC_INFO << "Key exchange failed on" << request.toString();
+        setAuthState(AuthStateNone);
+        m_transport->disconnectFromHost();
+    }
+}
+
+bool CFakeServerConnection::processReqPq(const QByteArray &payload)
+{
+    CTelegramStream inputStream(payload);
+
+    TLValue request;
+    inputStream >> request;
+    inputStream >> m_clientNonce;
+
+    if (inputStream.error()) {
+        return false;
+    }
+
+    Utils::randomBytes(m_serverNonce.data, m_serverNonce.size());
+
+    QByteArray pq;
+    pq.resize(8);
+    qToBigEndian(m_server->pq(), (uchar *) pq.data());
+
+    TLVector<quint64> fingersprints;
+    fingersprints.append(m_server->publicKey().fingersprint);
+
+    QByteArray output;
+    CTelegramStream outputStream(&output, /* write */ true);
+
+    outputStream << TLValue::ResPQ;
+    outputStream << m_clientNonce;
+    outputStream << m_serverNonce;
+    outputStream << pq;
+    outputStream << fingersprints;
+
+    sendPlainPackage(output);
+    setAuthState(AuthStatePqSent);
+
+    return true;
+}
+
+bool CFakeServerConnection::processReqDhParams(const QByteArray &payload)
+{
+    CTelegramStream inputStream(payload);
+
+    TLValue request;
+    TLNumber128 clientNonce;
+    TLNumber128 serverNonce;
+    QByteArray p;
+    QByteArray q;
+    quint64 fingersprint;
+    QByteArray encryptedData;
+
+    inputStream >> request;
+    inputStream >> clientNonce;
+    inputStream >> serverNonce;
+    inputStream >> p;
+    inputStream >> q;
+    inputStream >> fingersprint;
+    inputStream >> encryptedData;
+
+    if ((clientNonce != m_clientNonce) || (serverNonce != m_serverNonce)) {
+        qDebug() << Q_FUNC_INFO << "Nonce mismatch.";
+        return false;
+    }
+
+    if (fingersprint != m_server->publicKey().fingersprint) {
+        qDebug() << Q_FUNC_INFO << "Unknown RSA key fingersprint.";
+        return false;
+    }
+
+    // The client encrypts 255 bytes: sha1(data) + data + padding.
+    const QByteArray decrypted = Utils::binaryNumberModExp(encryptedData, m_server->publicKey().key, m_server->privateExponent());
+    const QByteArray sha = decrypted.mid(1, 20);
+    const QByteArray innerPackage = decrypted.mid(21);
+
+    CTelegramStream innerStream(innerPackage);
+
+    QByteArray innerPq;
+    QByteArray innerP;
+    QByteArray innerQ;
+    innerStream >> request;
+    innerStream >> innerPq;
+    innerStream >> innerP;
+    innerStream >> innerQ;
+    innerStream >> clientNonce;
+    innerStream >> serverNonce;
+    innerStream >> m_newNonce;
+
+    if (request == TLValue::PQInnerDataTemp) {
+        quint32 expiresIn;
+        innerStream >> expiresIn;
+    }
+
+    const int innerLength = innerPackage.size() - innerStream.bytesRemaining();
+
+    if (((request != TLValue::PQInnerData) && (request != TLValue::PQInnerDataTemp)) || (Utils::sha1(innerPackage.left(innerLength)) != sha)) {
+        qDebug() << Q_FUNC_INFO << "Unable to decrypt the inner data.";
+        return false;
+    }
+
+    if ((clientNonce != m_clientNonce) || (serverNonce != m_serverNonce)) {
+        qDebug() << Q_FUNC_INFO << "Inner data nonce mismatch.";
+        return false;
+    }
+
+    m_a.resize(256);
+    Utils::randomBytes(&m_a);
+
+    QByteArray binNumber;
+    binNumber.resize(sizeof(quint32));
+    qToBigEndian(m_server->g(), (uchar *) binNumber.data());
+
+    const QByteArray gA = Utils::binaryNumberModExp(binNumber, m_server->dhPrime(), m_a);
+
+    QByteArray answer;
+    {
+        QByteArray innerData;
+        CTelegramStream answerStream(&innerData, /* write */ true);
+
+        answerStream << TLValue::ServerDHInnerData;
+        answerStream << m_clientNonce;
+        answerStream << m_serverNonce;
+        answerStream << m_server->g();
+        answerStream << m_server->dhPrime();
+        answerStream << gA;
+        answerStream << quint32(QDateTime::currentMSecsSinceEpoch() / 1000);
+
+        answer = Utils::sha1(innerData) + innerData;
+
+        if (answer.size() % 16) {
+            QByteArray randomPadding;
+            randomPadding.resize(16 - (answer.size() % 16));
+            Utils::randomBytes(&randomPadding);
+            answer += randomPadding;
+        }
+    }
+
+    QByteArray output;
+    CTelegramStream outputStream(&output, /* write */ true);
+
+    outputStream << TLValue::ServerDHParamsOk;
+    outputStream << m_clientNonce;
+    outputStream << m_serverNonce;
+    outputStream << Utils::aesEncrypt(answer, generateTmpAesKey());
+
+    sendPlainPackage(output);
+    setAuthState(AuthStateDhSent);
+
+    return true;
+}
+
+bool CFakeServerConnection::processSetClientDhParams(const QByteArray &payload)
+{
+    CTelegramStream inputStream(payload);
+
+    TLValue request;
+    TLNumber128 clientNonce;
+    TLNumber128 serverNonce;
+    QByteArray encryptedData;
+
+    inputStream >> request;
+    inputStream >> clientNonce;
+    inputStream >> serverNonce;
+    inputStream >> encryptedData;
+
+    if ((clientNonce != m_clientNonce) || (serverNonce != m_serverNonce)) {
+        qDebug() << Q_FUNC_INFO << "Nonce mismatch.";
+        return false;
+    }
+
+    const QByteArray decrypted = Utils::aesDecrypt(encryptedData, generateTmpAesKey());
+    const QByteArray sha = decrypted.left(20);
+    const QByteArray innerPackage = decrypted.mid(20);
+
+    CTelegramStream innerStream(innerPackage);
+
+    quint64 retryId;
+    QByteArray gB;
+
+    innerStream >> request;
+    innerStream >> clientNonce;
+    innerStream >> serverNonce;
+    innerStream >> retryId;
+    innerStream >> gB;
+
+    const int innerLength = innerPackage.size() - innerStream.bytesRemaining();
+
+    if ((request != TLValue::ClientDHInnerData) || (Utils::sha1(innerPackage.left(innerLength)) != sha)) {
+        qDebug() << Q_FUNC_INFO << "Unable to decrypt the inner data.";
+        return false;
+    }
+
+    m_authKey = Utils::binaryNumberModExp(gB, m_server->dhPrime(), m_a);
+    m_authId = Utils::getFingersprint(m_authKey);
+    m_serverSalt = m_serverNonce.parts[0] ^ m_newNonce.parts[0];
+
+    QByteArray hashData(m_newNonce.data, m_newNonce.size());
+    hashData.append(char(1));
+    hashData.append(Utils::sha1(m_authKey).left(8));
+
+    const QByteArray newNonceHash = Utils::sha1(hashData).mid(4);
+    TLNumber128 newNonceHash1;
+    memcpy(newNonceHash1.data, newNonceHash.constData(), newNonceHash1.size());
+
+    QByteArray output;
+    CTelegramStream outputStream(&output, /* write */ true);
+
+    outputStream << TLValue::DhGenOk;
+    outputStream << m_clientNonce;
+    outputStream << m_serverNonce;
+    outputStream << newNonceHash1;
+
+    sendPlainPackage(output);
+    setAuthState(AuthStateHaveAKey);
+
+    return true;
+}
+
+bool CFakeServerConnection::processEncryptedPackage(const QByteArray &package)
+{
+    CRawStream inputStream(package);
+
+    quint64 authId = 0;
+    inputStream >> authId;
+
+    if ((m_authState != AuthStateHaveAKey) || (authId != m_authId)) {
+        // The client switches to a key, which is generated on another connection
+        const QByteArray authKey = m_server->authKey(authId);
+        if (authKey.isEmpty()) {
+            qDebug() << Q_FUNC_INFO << "Unknown auth key.";
+            return false;
+        }
+
+        m_authKey = authKey;
+        m_authId = authId;
+        setAuthState(AuthStateHaveAKey);
+    }
+
+    const QByteArray messageKey = inputStream.readBytes(16);
+    const QByteArray data = inputStream.readRemainingBytes();
+
+    if (data.size() % 16) {
+        qDebug() << Q_FUNC_INFO << "Encrypted data is not aligned.";
+        return false;
+    }
+
+    const QByteArray decryptedData = Utils::aesDecrypt(data, generateAesKey(messageKey, 0));
+    CRawStream decryptedStream(decryptedData);
+
+    quint64 salt = 0;
+    quint64 sessionId = 0;
+    quint64 messageId = 0;
+    quint32 sequence = 0;
+    quint32 contentLength = 0;
+
+    decryptedStream >> salt;
+    decryptedStream >> sessionId;
+    decryptedStream >> messageId;
+    decryptedStream >> sequence;
+    decryptedStream >> contentLength;
+
+    const int headerLength = sizeof(salt) + sizeof(sessionId) + sizeof(messageId) + sizeof(sequence) + sizeof(contentLength);
+
+    if (int(contentLength) > decryptedData.size() - headerLength) {
+        qDebug() << Q_FUNC_INFO << "Expected data length is more, than actual.";
+        return false;
+    }
+
+    if (Utils::sha1(decryptedData.left(headerLength + contentLength)).mid(4) != messageKey) {
+        qDebug() << Q_FUNC_INFO << "Wrong message key";
+        return false;
+    }
+
+    if (m_sessionId != sessionId) {
+        m_sessionId = sessionId;
+        m_contentRelatedMessages = 0;
+    }
+
+    if (m_server->takeBadServerSaltAnswer()) {
+        // The client takes the new salt from the answer header and resends the message
+        Utils::randomBytes(&m_serverSalt);
+
+        QByteArray output;
+        CTelegramStream outputStream(&output, /* write */ true);
+        outputStream << TLValue::BadServerSalt;
+        outputStream << messageId;
+        outputStream << sequence;
+        outputStream << quint32(48); // Incorrect server salt
+        outputStream << m_serverSalt;
+
+        sendEncryptedPackage(output);
+        return true;
+    }
+
+    processRpcQuery(decryptedStream.readBytes(contentLength), messageId);
+
+    return true;
+}
+
+void CFakeServerConnection::processRpcQuery(const QByteArray &data, quint64 messageId)
+{
+    CTelegramStream stream(data);
+
+    TLValue request;
+    stream >> request;
+
+    switch (request) {
+    case TLValue::InvokeWithLayer:
+    {
+        quint32 layer;
+        stream >> layer;
+        processRpcQuery(stream.readRemainingBytes(), messageId);
+    }
+        return;
+    case TLValue::InitConnection:
+    {
+        quint32 appId;
+        QString deviceInfo;
+        QString osInfo;
+        QString appVersion;
+        QString languageCode;
+        stream >> appId;
+        stream >> deviceInfo;
+        stream >> osInfo;
+        stream >> appVersion;
+        stream >> languageCode;
+        processRpcQuery(stream.readRemainingBytes(), messageId);
+    }
+        return;
+    case TLValue::MsgContainer:
+    {
+        quint32 itemsCount;
+        stream >> itemsCount;
+
+        for (quint32 i = 0; i < itemsCount; ++i) {
+            quint64 id;
+            quint32 seqNo;
+            quint32 size;
+            stream >> id;
+            stream >> seqNo;
+            stream >> size;
+            processRpcQuery(stream.readBytes(size), id);
+        }
+    }
+        return;
+    case TLValue::MsgsAck:
+        return;
+    case TLValue::AuthBindTempAuthKey:
+        processBindTempAuthKey(stream, messageId);
+        break;
+    case TLValue::Ping:
+    case TLValue::PingDelayDisconnect:
+    {
+        quint64 pingId;
+        stream >> pingId;
+
+        QByteArray output;
+        CTelegramStream outputStream(&output, /* write */ true);
+        outputStream << TLValue::Pong;
+        outputStream << messageId;
+        outputStream << pingId;
+
+        sendEncryptedPackage(output);
+    }
+        break;
+    default:
+    {
+        const QByteArray answer = m_server->scriptedAnswer(request);
+        if (answer.isEmpty()) {
+            qDebug() << Q_FUNC_INFO << "There is no scripted answer for" << request.toString();
+            sendRpcError(messageId, 501, QLatin1String("NOT_IMPLEMENTED"));
+        } else {
+            sendRpcResult(messageId, answer);
+        }
+    }
+        break;
+    }
+
+    ++m_processedRpcCount;
+    emit rpcProcessed(request);
+}
+
+void CFakeServerConnection::processBindTempAuthKey(CTelegramStream &stream, quint64 messageId)
+{
+    quint64 permAuthId;
+    quint64 nonce;
+    quint32 expiresAt;
+    QByteArray encryptedMessage;
+
+    stream >> permAuthId;
+    stream >> nonce;
+    stream >> expiresAt;
+    stream >> encryptedMessage;
+
+    const QByteArray permAuthKey = m_server->authKey(permAuthId);
+    if (permAuthKey.isEmpty()) {
+        sendRpcError(messageId, 400, QLatin1String("ENCRYPTED_MESSAGE_INVALID"));
+        return;
+    }
+
+    // The inner message is encrypted by the permanent key
+    CRawStream encryptedStream(encryptedMessage);
+    quint64 authId = 0;
+    encryptedStream >> authId;
+    const QByteArray messageKey = encryptedStream.readBytes(16);
+    const QByteArray data = encryptedStream.readRemainingBytes();
+
+    if ((authId != permAuthId) || data.isEmpty() || (data.size() % 16)) {
+        sendRpcError(messageId, 400, QLatin1String("ENCRYPTED_MESSAGE_INVALID"));
+        return;
+    }
+
+    const QByteArray decryptedData = Utils::aesDecrypt(data, generateAesKey(permAuthKey, messageKey, 0));
+    CRawStream decryptedStream(decryptedData);
+
+    quint64 salt = 0;
+    quint64 sessionId = 0;
+    quint64 innerMessageId = 0;
+    quint32 sequence = 0;
+    quint32 contentLength = 0;
+
+    decryptedStream >> salt;
+    decryptedStream >> sessionId;
+    decryptedStream >> innerMessageId;
+    decryptedStream >> sequence;
+    decryptedStream >> contentLength;
+
+    const int headerLength = sizeof(salt) + sizeof(sessionId) + sizeof(innerMessageId) + sizeof(sequence) + sizeof(contentLength);
+
+    if ((int(contentLength) > decryptedData.size() - headerLength)
+            || (Utils::sha1(decryptedData.left(headerLength + contentLength)).mid(4) != messageKey)
+            || (innerMessageId != messageId)) {
+        sendRpcError(messageId, 400, QLatin1String("ENCRYPTED_MESSAGE_INVALID"));
+        return;
+    }
+
+    CTelegramStream innerStream(decryptedStream.readBytes(contentLength));
+
+    TLValue innerType;
+    quint64 innerNonce;
+    quint64 tempAuthId;
+    quint64 innerPermAuthId;
+    quint64 tempSessionId;
+    quint32 innerExpiresAt;
+
+    innerStream >> innerType;
+    innerStream >> innerNonce;
+    innerStream >> tempAuthId;
+    innerStream >> innerPermAuthId;
+    innerStream >> tempSessionId;
+    innerStream >> innerExpiresAt;
+
+    if ((innerType != TLValue::BindAuthKeyInner) || (innerNonce != nonce) || (tempAuthId != m_authId)
+            || (innerPermAuthId != permAuthId) || (tempSessionId != m_sessionId) || (innerExpiresAt != expiresAt)) {
+        sendRpcError(messageId, 400, QLatin1String("ENCRYPTED_MESSAGE_INVALID"));
+        return;
+    }
+
+    m_server->bindAuthKey(tempAuthId, permAuthId);
+
+    QByteArray answer;
+    CTelegramStream answerStream(&answer, /* write */ true);
+    answerStream << TLValue::BoolTrue;
+
+    sendRpcResult(messageId, answer);
+}
+
+void CFakeServerConnection::sendPlainPackage(const QByteArray &payload)
+{
+    QByteArray output;
+    CRawStream outputStream(&output, /* write */ true);
+
+    outputStream << quint64(0);
+    outputStream << newMessageId(/* isAnswer */ true);
+    outputStream << quint32(payload.length());
+    outputStream << payload;
+
+    m_transport->sendPackage(output);
+}
+
+void CFakeServerConnection::sendEncryptedPackage(const QByteArray &payload)
+{
+    const quint64 messageId = newMessageId(/* isAnswer */ true);
+    const quint32 sequence = m_contentRelatedMessages * 2 + 1;
+    ++m_contentRelatedMessages;
+
+    QByteArray innerData;
+    {
+        CRawStream stream(&innerData, /* write */ true);
+
+        stream << m_serverSalt;
+        stream << m_sessionId;
+        stream << messageId;
+        stream << sequence;
+        stream << quint32(payload.length());
+        stream << payload;
+    }
+
+    const QByteArray messageKey = Utils::sha1(innerData).mid(4);
+
+    if (innerData.size() % 16) {
+        QByteArray randomPadding;
+        randomPadding.resize(16 - (innerData.size() % 16));
+        Utils::randomBytes(&randomPadding);
+        innerData += randomPadding;
+    }
+
+    QByteArray output;
+    CRawStream outputStream(&output, /* write */ true);
+
+    outputStream << m_authId;
+    outputStream << messageKey;
+    outputStream << Utils::aesEncrypt(innerData, generateAesKey(messageKey, 8));
+
+    m_transport->sendPackage(output);
+}
+
+void CFakeServerConnection::sendRpcResult(quint64 requestId, const QByteArray &result)
+{
+    QByteArray output;
+    {
+        CTelegramStream outputStream(&output, /* write */ true);
+        outputStream << TLValue::RpcResult;
+        outputStream << requestId;
+    }
+    output.append(result);
+
+    sendEncryptedPackage(output);
+}
+
+void CFakeServerConnection::sendRpcError(quint64 requestId, quint32 errorCode, const QString &errorMessage)
+{
+    QByteArray output;
+    CTelegramStream outputStream(&output, /* write */ true);
+
+    outputStream << TLValue::RpcError;
+    outputStream << errorCode;
+    outputStream << errorMessage;
+
+    sendRpcResult(requestId, output);
+}
+
+quint64 CFakeServerConnection::newMessageId(bool isAnswer)
+{
+    // Server message id is 1 modulo 4 for the answers and 3 modulo 4 otherwise.
+    quint64 newLastMessageId = CTelegramConnection::formatTimeStamp(QDateTime::currentMSecsSinceEpoch());
+    newLastMessageId = (newLastMessageId & ~quint64(3)) | (isAnswer ? 1 : 3);
+
+    if (newLastMessageId <= m_lastMessageId) {
+        newLastMessageId = m_lastMessageId + 4;
+    }
+
+    m_lastMessageId = newLastMessageId;
+    return m_lastMessageId;
+}
+
+SAesKey CFakeServerConnection::generateTmpAesKey() const
+{
+    QByteArray newNonceAndServerNonce;
+    newNonceAndServerNonce.append(m_newNonce.data, m_newNonce.size());
+    newNonceAndServerNonce.append(m_serverNonce.data, m_serverNonce.size());
+    QByteArray serverNonceAndNewNonce;
+    serverNonceAndNewNonce.append(m_serverNonce.data, m_serverNonce.size());
+    serverNonceAndNewNonce.append(m_newNonce.data, m_newNonce.size());
+    QByteArray newNonceAndNewNonce;
+    newNonceAndNewNonce.append(m_newNonce.data, m_newNonce.size());
+    newNonceAndNewNonce.append(m_newNonce.data, m_newNonce.size());
+
+    const QByteArray key = Utils::sha1(newNonceAndServerNonce) + Utils::sha1(serverNonceAndNewNonce).mid(0, 12);
+    const QByteArray iv  = Utils::sha1(serverNonceAndNewNonce).mid(12, 8) + Utils::sha1(newNonceAndNewNonce) + QByteArray(m_newNonce.data, 4);
+
+    return SAesKey(key, iv);
+}
+
+SAesKey CFakeServerConnection::generateAesKey(const QByteArray &messageKey, int x) const
+{
+    return generateAesKey(m_authKey, messageKey, x);
+}
+
+SAesKey CFakeServerConnection::generateAesKey(const QByteArray &authKey, const QByteArray &messageKey, int x)
+{
+    QByteArray sha1_a = Utils::sha1(messageKey + authKey.mid(x, 32));
+    QByteArray sha1_b = Utils::sha1(authKey.mid(32 + x, 16) + messageKey + authKey.mid(48 + x, 16));
+    QByteArray sha1_c = Utils::sha1(authKey.mid(64 + x, 32) + messageKey);
+    QByteArray sha1_d = Utils::sha1(messageKey + authKey.mid(96 + x, 32));
+
+    const QByteArray key = sha1_a.mid(0, 8) + sha1_b.mid(8, 12) + sha1_c.mid(4, 12);
+    const QByteArray iv  = sha1_a.mid(8, 12) + sha1_b.mid(0, 8) + sha1_c.mid(16, 4) + sha1_d.mid(0, 8);
+
+    return SAesKey(key, iv);
+}
+
+void CFakeServerConnection::setAuthState(AuthState newState)
+{
+    if (m_authState == newState) {
+        return;
+    }
+
+    m_authState = newState;
+    emit authStateChanged(newState);
+}
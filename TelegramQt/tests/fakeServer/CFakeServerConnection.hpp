@@ -0,0 +1,107 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#ifndef CFAKESERVERCONNECTION_HPP
+#define CFAKESERVERCONNECTION_HPP
+
+#include <QObject>
+#include <QByteArray>
+
+#include "TLNumbers.hpp"
+#include "TLValues.hpp"
+#include "crypto-aes.hpp"
+
+class CFakeServer;
+class CTelegramStream;
+class CTelegramTransport;
+
+class CFakeServerConnection : public QObject
+{
+    Q_OBJECT
+public:
+    enum AuthState {
+        AuthStateNone,
+        AuthStatePqSent,
+        AuthStateDhSent,
+        AuthStateHaveAKey
+    };
+
+    explicit CFakeServerConnection(CFakeServer *server, CTelegramTransport *transport, QObject *parent = 0);
+
+    CTelegramTransport *transport() const { return m_transport; }
+
+    AuthState authState() const { return m_authState; }
+    QByteArray authKey() const { return m_authKey; }
+    quint64 authId() const { return m_authId; }
+    quint64 serverSalt() const { return m_serverSalt; }
+    quint64 sessionId() const { return m_sessionId; }
+
+    quint32 processedRpcCount() const { return m_processedRpcCount; }
+
+    // Sends a server-initiated message (e.g. updates), encrypted with the current key of the session
+    void pushMessage(const QByteArray &payload) { sendEncryptedPackage(payload); }
+
+signals:
+    void authStateChanged(int state);
+    void rpcProcessed(quint32 method);
+
+protected slots:
+    void onTransportStateChanged();
+    void onTransportReadyRead();
+
+protected:
+    bool processReqPq(const QByteArray &payload);
+    bool processReqDhParams(const QByteArray &payload);
+    bool processSetClientDhParams(const QByteArray &payload);
+    bool processEncryptedPackage(const QByteArray &package);
+    void processBindTempAuthKey(CTelegramStream &stream, quint64 messageId);
+    void processRpcQuery(const QByteArray &data, quint64 messageId);
+
+    void sendPlainPackage(const QByteArray &payload);
+    void sendEncryptedPackage(const QByteArray &payload);
+    void sendRpcResult(quint64 requestId, const QByteArray &result);
+    void sendRpcError(quint64 requestId, quint32 errorCode, const QString &errorMessage);
+
+    quint64 newMessageId(bool isAnswer);
+
+    SAesKey generateTmpAesKey() const;
+    SAesKey generateAesKey(const QByteArray &messageKey, int xValue) const;
+    static SAesKey generateAesKey(const QByteArray &authKey, const QByteArray &messageKey, int xValue);
+
+    void setAuthState(AuthState newState);
+
+    CFakeServer *m_server;
+    CTelegramTransport *m_transport;
+
+    AuthState m_authState;
+
+    TLNumber128 m_clientNonce;
+    TLNumber128 m_serverNonce;
+    TLNumber256 m_newNonce;
+    QByteArray m_a;
+
+    QByteArray m_authKey;
+    quint64 m_authId;
+    quint64 m_serverSalt;
+    quint64 m_sessionId;
+    quint64 m_lastMessageId;
+    quint32 m_contentRelatedMessages;
+    quint32 m_processedRpcCount;
+
+};
+
+#endif // CFAKESERVERCONNECTION_HPP
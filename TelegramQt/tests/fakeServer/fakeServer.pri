@@ -0,0 +1,9 @@
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/CFakeServer.cpp \
+    $$PWD/CFakeServerConnection.cpp
+
+HEADERS += \
+    $$PWD/CFakeServer.hpp \
+    $$PWD/CFakeServerConnection.hpp
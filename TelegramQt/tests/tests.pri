@@ -1,5 +1,5 @@
 
-QT += core network testlib
+QT += core network concurrent testlib
 TEMPLATE = app
 
 INCLUDEPATH += $$PWD/..
@@ -1,4 +1,9 @@
 TEMPLATE = subdirs
 SUBDIRS += tst_CTelegramConnection
 SUBDIRS += tst_CTelegramStream
+SUBDIRS += tst_CAesIgeCipher
+SUBDIRS += tst_CTcpTransport
+SUBDIRS += tst_CHttpTransport
+SUBDIRS += tst_CFakeServer
+SUBDIRS += tst_Utils
 #SUBDIRS += tst_CTelegramDispatcher
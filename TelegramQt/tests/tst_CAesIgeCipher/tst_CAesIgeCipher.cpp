@@ -0,0 +1,191 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include <QObject>
+
+#include "CAesIgeCipher.hpp"
+#include "Utils.hpp"
+
+#include <QTest>
+#include <QDebug>
+
+#include <openssl/aes.h>
+
+class tst_CAesIgeCipher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_CAesIgeCipher(QObject *parent = 0);
+
+private slots:
+    void initTestCase();
+    void compareWithOpenSsl_data();
+    void compareWithOpenSsl();
+    void chainedCalls();
+    void invalidInput();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    static QByteArray openSslIge(const QByteArray &data, const SAesKey &key, int mode);
+    static QByteArray testData(int size);
+
+    SAesKey m_key;
+
+};
+
+tst_CAesIgeCipher::tst_CAesIgeCipher(QObject *parent) :
+    QObject(parent)
+{
+}
+
+void tst_CAesIgeCipher::initTestCase()
+{
+    qDebug() << "AES-NI:" << CAesIgeCipher::hardwareAccelerated();
+
+    m_key.key = QByteArray(32, Qt::Uninitialized);
+    m_key.iv = QByteArray(32, Qt::Uninitialized);
+    for (int i = 0; i < 32; ++i) {
+        m_key.key[i] = char(i * 13 + 1);
+        m_key.iv[i] = char(i * 29 + 7);
+    }
+}
+
+// The previous implementation of the Utils::aesEncrypt() and Utils::aesDecrypt()
+QByteArray tst_CAesIgeCipher::openSslIge(const QByteArray &data, const SAesKey &key, int mode)
+{
+    QByteArray result = data;
+    QByteArray initVector = key.iv;
+
+    AES_KEY aesKey;
+    if (mode == AES_ENCRYPT) {
+        AES_set_encrypt_key((const uchar *) key.key.constData(), key.key.length() * 8, &aesKey);
+    } else {
+        AES_set_decrypt_key((const uchar *) key.key.constData(), key.key.length() * 8, &aesKey);
+    }
+
+    AES_ige_encrypt((const uchar *) data.constData(), (uchar *) result.data(), data.length(), &aesKey, (uchar *) initVector.data(), mode);
+    return result;
+}
+
+QByteArray tst_CAesIgeCipher::testData(int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        data[i] = char((i * 7) ^ (i >> 3));
+    }
+    return data;
+}
+
+void tst_CAesIgeCipher::compareWithOpenSsl_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("one block") << 16;
+    QTest::newRow("auth answer") << 592;
+    QTest::newRow("file part") << 128 * 1024;
+}
+
+void tst_CAesIgeCipher::compareWithOpenSsl()
+{
+    QFETCH(int, size);
+
+    const QByteArray plain = testData(size);
+    const QByteArray expectedCipher = openSslIge(plain, m_key, AES_ENCRYPT);
+
+    QByteArray data = plain;
+    CAesIgeCipher encryptor(m_key, CAesIgeCipher::Encryption);
+    QVERIFY(encryptor.process(data.data(), data.size()));
+    QCOMPARE(data, expectedCipher);
+
+    CAesIgeCipher decryptor(m_key, CAesIgeCipher::Decryption);
+    QVERIFY(decryptor.process(data.data(), data.size()));
+    QCOMPARE(data, plain);
+
+    QCOMPARE(Utils::aesEncrypt(plain, m_key), expectedCipher);
+    QCOMPARE(Utils::aesDecrypt(expectedCipher, m_key), plain);
+}
+
+void tst_CAesIgeCipher::chainedCalls()
+{
+    const QByteArray plain = testData(1024);
+    const QByteArray expectedCipher = openSslIge(plain, m_key, AES_ENCRYPT);
+
+    QByteArray data = plain;
+    CAesIgeCipher encryptor(m_key, CAesIgeCipher::Encryption);
+    QVERIFY(encryptor.process(data.data(), 16));
+    QVERIFY(encryptor.process(data.data() + 16, 496));
+    QVERIFY(encryptor.process(data.data() + 512, 512));
+    QCOMPARE(data, expectedCipher);
+
+    CAesIgeCipher decryptor(m_key, CAesIgeCipher::Decryption);
+    QVERIFY(decryptor.process(data.data(), 512));
+    QVERIFY(decryptor.process(data.data() + 512, 512));
+    QCOMPARE(data, plain);
+}
+
+void tst_CAesIgeCipher::invalidInput()
+{
+    CAesIgeCipher cipher;
+    QVERIFY(!cipher.isValid());
+
+    QByteArray data(32, char(1));
+    QVERIFY(!cipher.process(data.data(), data.size()));
+
+    cipher.setKey(SAesKey(QByteArray(16, char(1)), QByteArray(32, char(2))), CAesIgeCipher::Encryption);
+    QVERIFY(!cipher.isValid());
+
+    cipher.setKey(m_key, CAesIgeCipher::Encryption);
+    QVERIFY(cipher.isValid());
+    QVERIFY(!cipher.process(data.data(), 20));
+    QCOMPARE(data, QByteArray(32, char(1)));
+}
+
+void tst_CAesIgeCipher::benchmark_data()
+{
+    QTest::addColumn<bool>("legacy");
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("legacy 1 KiB") << true << 1024;
+    QTest::newRow("in-place 1 KiB") << false << 1024;
+    QTest::newRow("legacy 128 KiB") << true << 128 * 1024;
+    QTest::newRow("in-place 128 KiB") << false << 128 * 1024;
+}
+
+void tst_CAesIgeCipher::benchmark()
+{
+    QFETCH(bool, legacy);
+    QFETCH(int, size);
+
+    QByteArray data = testData(size);
+
+    // Each iteration is a new message with its own key, as in the MTProto.
+    if (legacy) {
+        QBENCHMARK {
+            data = openSslIge(data, m_key, AES_ENCRYPT);
+        }
+    } else {
+        QBENCHMARK {
+            CAesIgeCipher cipher(m_key, CAesIgeCipher::Encryption);
+            cipher.process(data.data(), data.size());
+        }
+    }
+}
+
+QTEST_MAIN(tst_CAesIgeCipher)
+
+#include "tst_CAesIgeCipher.moc"
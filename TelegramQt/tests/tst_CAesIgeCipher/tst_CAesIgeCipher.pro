@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_aesigecipher
+SOURCES = tst_CAesIgeCipher.cpp
@@ -0,0 +1,497 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include <QObject>
+
+#include "CAppInformation.hpp"
+#include "CAuthKeyGenerator.hpp"
+#include "CFakeServer.hpp"
+#include "CFakeServerConnection.hpp"
+#include "CLoopbackTransport.hpp"
+#include "CTelegramAuthModule.hpp"
+#include "CTelegramConnection.hpp"
+#include "CTelegramDispatcher.hpp"
+#include "CTelegramStream.hpp"
+#include "CTempAuthKeyManager.hpp"
+
+#include "Utils.hpp"
+
+#include <QDateTime>
+#include <QEventLoop>
+#include <QSignalSpy>
+#include <QTest>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+
+class CTestTempAuthKeyManager : public CTempAuthKeyManager
+{
+    Q_OBJECT
+public:
+    CTestTempAuthKeyManager(const CAppInformation *appInfo, CTelegramConnection *connection, CFakeServer *server) :
+        CTempAuthKeyManager(appInfo, connection, server),
+        m_server(server)
+    {
+    }
+
+    STransportOptions keyTransportOptions() const { return m_keyTransportOptions; }
+
+protected:
+    CTelegramConnection *createKeyConnection() override
+    {
+        CTelegramConnection *keyConnection = CTempAuthKeyManager::createKeyConnection();
+        m_keyTransportOptions = keyConnection->transportOptions();
+
+        CLoopbackTransport *transport = new CLoopbackTransport();
+        keyConnection->setTransport(transport);
+        m_server->addClient(transport);
+
+        return keyConnection;
+    }
+
+    CFakeServer *m_server;
+    STransportOptions m_keyTransportOptions;
+
+};
+
+class CTestAuthKeyGenerator : public CAuthKeyGenerator
+{
+    Q_OBJECT
+public:
+    CTestAuthKeyGenerator(const CAppInformation *appInfo, CFakeServer *server) :
+        CAuthKeyGenerator(appInfo, server),
+        m_server(server)
+    {
+    }
+
+protected:
+    CTelegramConnection *createKeyConnection(const TLDcOption &dcInfo) override
+    {
+        CTelegramConnection *keyConnection = CAuthKeyGenerator::createKeyConnection(dcInfo);
+
+        CLoopbackTransport *transport = new CLoopbackTransport();
+        keyConnection->setTransport(transport);
+        keyConnection->setServerRsaKey(m_server->publicKey());
+        m_server->addClient(transport);
+
+        return keyConnection;
+    }
+
+    CFakeServer *m_server;
+
+};
+
+class CTestFakeServerDispatcher : public CTelegramDispatcher
+{
+    Q_OBJECT
+public:
+    explicit CTestFakeServerDispatcher(CFakeServer *server) :
+        m_server(server)
+    {
+        setServerRsaKey(server->publicKey());
+    }
+
+protected:
+    CTelegramTransport *createTransport(const TLDcOption &dcInfo) override
+    {
+        Q_UNUSED(dcInfo)
+
+        CLoopbackTransport *transport = new CLoopbackTransport();
+        m_server->addClient(transport);
+
+        return transport;
+    }
+
+    CFakeServer *m_server;
+
+};
+
+class tst_CFakeServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_CFakeServer(QObject *parent = 0);
+
+private slots:
+    void initTestCase();
+    void keyExchange();
+    void parallelKeyExchange();
+    void scriptedRpc();
+    void dispatcherScriptedRpc();
+    void workerThreadConnection();
+    void tempAuthKeyBinding();
+    void tempAuthKeyBindingResend();
+    void previousAuthKeyExpiry();
+    void authKeyPreGeneration();
+    void keyExchangeBenchmark();
+    void rpcRoundTripBenchmark();
+
+private:
+    CTelegramConnection *createConnection(CFakeServer *server);
+
+    CAppInformation m_appInfo;
+
+};
+
+tst_CFakeServer::tst_CFakeServer(QObject *parent) :
+    QObject(parent)
+{
+}
+
+void tst_CFakeServer::initTestCase()
+{
+    m_appInfo.setAppId(1);
+    m_appInfo.setAppHash(QLatin1String("00000000000000000000000000000000"));
+    m_appInfo.setAppVersion(QLatin1String("0.1"));
+    m_appInfo.setDeviceInfo(QLatin1String("pc"));
+    m_appInfo.setOsInfo(QLatin1String("GNU/Linux"));
+    m_appInfo.setLanguageCode(QLatin1String("en"));
+}
+
+CTelegramConnection *tst_CFakeServer::createConnection(CFakeServer *server)
+{
+    CTelegramConnection *connection = new CTelegramConnection(&m_appInfo, server);
+
+    CLoopbackTransport *transport = new CLoopbackTransport();
+    connection->setTransport(transport);
+    connection->setServerRsaKey(server->publicKey());
+    connection->setDcInfo(server->dcOption());
+    server->addClient(transport);
+
+    return connection;
+}
+
+void tst_CFakeServer::keyExchange()
+{
+    CFakeServer server;
+    CTelegramConnection *connection = createConnection(&server);
+
+    connection->connectToDc();
+    QTRY_COMPARE(connection->authState(), CTelegramConnection::AuthStateHaveAKey);
+
+    QCOMPARE(server.connections().count(), 1);
+    const CFakeServerConnection *serverConnection = server.connections().first();
+
+    QCOMPARE(serverConnection->authState(), CFakeServerConnection::AuthStateHaveAKey);
+    QCOMPARE(serverConnection->authKey().size(), 256);
+    QCOMPARE(serverConnection->authKey(), connection->authKey());
+    QCOMPARE(serverConnection->authId(), connection->authId());
+    QCOMPARE(serverConnection->serverSalt(), connection->serverSalt());
+}
+
+void tst_CFakeServer::parallelKeyExchange()
+{
+    CFakeServer server;
+    QVector<CTelegramConnection *> connections;
+
+    // The handshake math runs in the thread pool, so the connections do not wait for each other
+    for (int i = 0; i < 4; ++i) {
+        connections.append(createConnection(&server));
+        connections.last()->connectToDc();
+    }
+
+    for (CTelegramConnection *connection : connections) {
+        QTRY_COMPARE(connection->authState(), CTelegramConnection::AuthStateHaveAKey);
+    }
+
+    QCOMPARE(server.connections().count(), connections.count());
+    for (int i = 0; i < connections.count(); ++i) {
+        QCOMPARE(server.connections().at(i)->authKey(), connections.at(i)->authKey());
+    }
+}
+
+void tst_CFakeServer::scriptedRpc()
+{
+    CFakeServer server;
+    CTelegramConnection *connection = createConnection(&server);
+
+    connection->connectToDc();
+    QTRY_COMPARE(connection->authState(), CTelegramConnection::AuthStateHaveAKey);
+
+    QSignalSpy configSpy(connection, SIGNAL(dcConfigurationReceived(quint32)));
+    connection->helpGetConfig();
+
+    QTRY_COMPARE(configSpy.count(), 1);
+    QCOMPARE(connection->dcConfiguration().count(), 1);
+    QCOMPARE(connection->dcConfiguration().first().ipAddress, server.dcOption().ipAddress);
+    QCOMPARE(connection->dcConfiguration().first().port, server.dcOption().port);
+
+    CFakeServerConnection *serverConnection = server.connections().first();
+    QSignalSpy rpcSpy(serverConnection, SIGNAL(rpcProcessed(quint32)));
+    connection->ping();
+
+    QTRY_COMPARE(rpcSpy.count(), 1);
+    QCOMPARE(rpcSpy.first().first().toUInt(), quint32(TLValue::Ping));
+}
+
+void tst_CFakeServer::dispatcherScriptedRpc()
+{
+    CFakeServer server;
+
+    QByteArray checkedPhone;
+    CTelegramStream checkedPhoneStream(&checkedPhone, /* write */ true);
+    checkedPhoneStream << TLValue::AuthCheckedPhone;
+    checkedPhoneStream << TLValue::BoolTrue;
+    server.setScriptedAnswer(TLValue::AuthCheckPhone, checkedPhone);
+
+    CTelegramAuthModule authModule;
+    CTestFakeServerDispatcher dispatcher(&server);
+    dispatcher.setAppInformation(&m_appInfo);
+    dispatcher.plugModule(&authModule);
+
+    const TLDcOption serverDc = server.dcOption();
+    QVERIFY(dispatcher.initConnection({ Telegram::DcOption(serverDc.ipAddress, serverDc.port) }));
+
+    // The key exchange and help.getConfig go through the dispatcher and the fake server
+    QTRY_COMPARE(dispatcher.connectionState(), TelegramNamespace::ConnectionStateAuthRequired);
+    QCOMPARE(server.connections().count(), 1);
+    QCOMPARE(dispatcher.activeConnection()->authKey(), server.connections().first()->authKey());
+
+    QSignalSpy phoneSpy(&authModule, SIGNAL(phoneStatusReceived(QString,bool)));
+    authModule.requestPhoneStatus(QLatin1String("123456789"));
+
+    QTRY_COMPARE(phoneSpy.count(), 1);
+    QCOMPARE(phoneSpy.first().at(0).toString(), QStringLiteral("123456789"));
+    QCOMPARE(phoneSpy.first().at(1).toBool(), true);
+}
+
+void tst_CFakeServer::workerThreadConnection()
+{
+    CFakeServer server;
+    QThread thread;
+
+    CTelegramConnection *connection = createConnection(&server);
+    connection->setParent(0);
+    connection->moveToThread(&thread);
+    thread.start();
+
+    // The connection is driven only through queued calls, which are executed in its own thread
+    QMetaObject::invokeMethod(connection, "connectToDc", Qt::QueuedConnection);
+    QTRY_COMPARE(connection->authState(), CTelegramConnection::AuthStateHaveAKey);
+
+    QEventLoop loop;
+    QTimer timeoutTimer;
+    timeoutTimer.setSingleShot(true);
+    connect(connection, SIGNAL(dcConfigurationReceived(quint32)), &loop, SLOT(quit()));
+    connect(&timeoutTimer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    timeoutTimer.start(5000);
+
+    QTimer::singleShot(0, connection, [connection]() { connection->helpGetConfig(); });
+    loop.exec();
+
+    // The state is read only after the connection thread has reported it
+    QVERIFY(timeoutTimer.isActive());
+    QCOMPARE(connection->dcConfiguration().count(), 1);
+
+    connection->deleteLater();
+    thread.quit();
+    QVERIFY(thread.wait(5000));
+}
+
+void tst_CFakeServer::tempAuthKeyBinding()
+{
+    CFakeServer server;
+    CTelegramConnection *connection = createConnection(&server);
+
+    connection->connectToDc();
+    QTRY_COMPARE(connection->authState(), CTelegramConnection::AuthStateHaveAKey);
+
+    const QByteArray permanentKey = connection->authKey();
+
+    STransportOptions options;
+    options.receiveBufferSize = 256 * 1024;
+    connection->setTransportOptions(options);
+
+    CTestTempAuthKeyManager manager(&m_appInfo, connection, &server);
+    manager.setKeyLifetime(3600);
+    QSignalSpy boundSpy(&manager, SIGNAL(keyBound(quint32)));
+    manager.start();
+
+    QTRY_COMPARE(boundSpy.count(), 1);
+    QCOMPARE(manager.keyTransportOptions().receiveBufferSize, options.receiveBufferSize);
+    QVERIFY(manager.keyExpiresAt() > QDateTime::currentMSecsSinceEpoch() / 1000);
+
+    const QByteArray tempKey = connection->tempAuthKey();
+    QCOMPARE(tempKey.size(), 256);
+    QVERIFY(tempKey != permanentKey);
+    QCOMPARE(connection->authKey(), permanentKey);
+    QCOMPARE(server.boundAuthId(Utils::getFingersprint(tempKey)), connection->authId());
+
+    // The next requests are sent with the temporary key, while the session goes on
+    QSignalSpy configSpy(connection, SIGNAL(dcConfigurationReceived(quint32)));
+    connection->helpGetConfig();
+    QTRY_COMPARE(configSpy.count(), 1);
+
+    CFakeServerConnection *serverConnection = server.connections().first();
+    QCOMPARE(serverConnection->authKey(), tempKey);
+}
+
+void tst_CFakeServer::tempAuthKeyBindingResend()
+{
+    CFakeServer server;
+    CTelegramConnection *connection = createConnection(&server);
+
+    connection->connectToDc();
+    QTRY_COMPARE(connection->authState(), CTelegramConnection::AuthStateHaveAKey);
+
+    CTestTempAuthKeyManager manager(&m_appInfo, connection, &server);
+    QSignalSpy boundSpy(&manager, SIGNAL(keyBound(quint32)));
+    QSignalSpy failedSpy(&manager, SIGNAL(bindingFailed()));
+
+    // The binding is the first encrypted message of the key connection
+    server.setBadServerSaltCount(1);
+    manager.start();
+
+    QTRY_COMPARE(boundSpy.count(), 1);
+    QCOMPARE(failedSpy.count(), 0);
+    QVERIFY(!server.takeBadServerSaltAnswer());
+
+    const QByteArray tempKey = connection->tempAuthKey();
+    QCOMPARE(server.boundAuthId(Utils::getFingersprint(tempKey)), connection->authId());
+}
+
+void tst_CFakeServer::previousAuthKeyExpiry()
+{
+    CFakeServer server;
+    CTelegramConnection *connection = createConnection(&server);
+
+    // The previous key is accepted for a few ping intervals
+    connection->setKeepAliveSettings(500, 5000);
+    connection->connectToDc();
+    QTRY_COMPARE(connection->authState(), CTelegramConnection::AuthStateHaveAKey);
+
+    int updatesCount = 0;
+    connect(connection, &CTelegramConnection::updatesReceived, [&updatesCount]() { ++updatesCount; });
+
+    CFakeServerConnection *serverConnection = server.connections().first();
+    serverConnection->transport()->setPackageCaptureEnabled(true);
+
+    QByteArray updates;
+    CTelegramStream updatesStream(&updates, /* write */ true);
+    updatesStream << TLValue::UpdatesTooLong;
+
+    serverConnection->pushMessage(updates);
+    QTRY_COMPARE(updatesCount, 1);
+    const QByteArray previousKeyPackage = serverConnection->transport()->lastPackage();
+
+    CTestTempAuthKeyManager manager(&m_appInfo, connection, &server);
+    QSignalSpy boundSpy(&manager, SIGNAL(keyBound(quint32)));
+    manager.start();
+    QTRY_COMPARE(boundSpy.count(), 1);
+
+    // The answers, which are in flight during the key rotation, are still accepted
+    serverConnection->transport()->sendPackage(previousKeyPackage);
+    QTRY_COMPARE(updatesCount, 2);
+
+    // Three ping intervals and a margin later, the packages under the replaced key are dropped
+    QTest::qWait(2000);
+    serverConnection->transport()->sendPackage(previousKeyPackage);
+    QTest::qWait(200);
+    QCOMPARE(updatesCount, 2);
+
+    // The connection itself goes on with the new key
+    serverConnection->pushMessage(updates);
+    QTRY_COMPARE(updatesCount, 3);
+}
+
+void tst_CFakeServer::authKeyPreGeneration()
+{
+    CFakeServer server;
+    CTestAuthKeyGenerator generator(&m_appInfo, &server);
+    QSignalSpy generatedSpy(&generator, SIGNAL(keyGenerated(quint32)));
+
+    const TLDcOption firstDc = server.dcOption();
+    TLDcOption secondDc = firstDc;
+    secondDc.id = firstDc.id + 1;
+
+    generator.generateKey(firstDc);
+    generator.generateKey(secondDc);
+    generator.generateKey(secondDc); // Already in progress
+    QCOMPARE(generator.pendingCount(), 2);
+
+    QTRY_COMPARE(generatedSpy.count(), 2);
+    QCOMPARE(generator.pendingCount(), 0);
+    QVERIFY(generator.hasKey(firstDc.id));
+    QVERIFY(generator.hasKey(secondDc.id));
+
+    // The key connections are closed once the keys are ready
+    QCOMPARE(server.connections().count(), 2);
+    for (const CFakeServerConnection *serverConnection : server.connections()) {
+        QTRY_COMPARE(serverConnection->transport()->state(), QAbstractSocket::UnconnectedState);
+    }
+
+    generator.generateKey(secondDc); // Already generated
+    QCOMPARE(generator.pendingCount(), 0);
+
+    QByteArray authKey;
+    quint64 serverSalt = 0;
+    QVERIFY(generator.takeKey(secondDc.id, &authKey, &serverSalt));
+    QVERIFY(!generator.hasKey(secondDc.id));
+    QCOMPARE(authKey.size(), 256);
+    QCOMPARE(server.authKey(Utils::getFingersprint(authKey)), authKey);
+
+    // A connection with the pre-generated key skips the handshake, but it is not signed in yet
+    CTelegramConnection *connection = createConnection(&server);
+    connection->setAuthKey(authKey);
+    connection->setAuthKeyAuthorized(false);
+    connection->setServerSalt(serverSalt);
+    connection->connectToDc();
+
+    QTRY_COMPARE(connection->authState(), CTelegramConnection::AuthStateHaveAKey);
+    QCOMPARE(server.connections().last()->authState(), CFakeServerConnection::AuthStateNone);
+}
+
+void tst_CFakeServer::keyExchangeBenchmark()
+{
+    CFakeServer server;
+    QEventLoop loop;
+
+    QBENCHMARK {
+        CTelegramConnection *connection = createConnection(&server);
+        connect(connection, &CTelegramConnection::authStateChanged, &loop, [&loop](int state) {
+            if (state == CTelegramConnection::AuthStateHaveAKey) {
+                loop.quit();
+            }
+        });
+
+        connection->connectToDc();
+        loop.exec();
+    }
+
+    QCOMPARE(server.connections().last()->authState(), CFakeServerConnection::AuthStateHaveAKey);
+}
+
+void tst_CFakeServer::rpcRoundTripBenchmark()
+{
+    CFakeServer server;
+    CTelegramConnection *connection = createConnection(&server);
+
+    connection->connectToDc();
+    QTRY_COMPARE(connection->authState(), CTelegramConnection::AuthStateHaveAKey);
+
+    QEventLoop loop;
+    connect(connection, SIGNAL(dcConfigurationReceived(quint32)), &loop, SLOT(quit()));
+
+    QBENCHMARK {
+        connection->helpGetConfig();
+        loop.exec();
+    }
+}
+
+QTEST_MAIN(tst_CFakeServer)
+
+#include "tst_CFakeServer.moc"
@@ -0,0 +1,7 @@
+include(../tests.pri)
+include(../fakeServer/fakeServer.pri)
+
+TARGET = tst_fakeserver
+SOURCES += tst_CFakeServer.cpp
+
+LIBS += -lz
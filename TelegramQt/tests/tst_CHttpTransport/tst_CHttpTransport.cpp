@@ -0,0 +1,179 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include <QObject>
+
+#include "CHttpTransport.hpp"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QDebug>
+
+class tst_CHttpTransport : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_CHttpTransport(QObject *parent = 0);
+
+private slots:
+    void pipelining();
+    void responseStatus();
+
+private:
+    static QByteArray response(int status, const QByteArray &body);
+    static QList<QByteArray> readRequestBodies(QByteArray *data);
+
+};
+
+tst_CHttpTransport::tst_CHttpTransport(QObject *parent) :
+    QObject(parent)
+{
+}
+
+QByteArray tst_CHttpTransport::response(int status, const QByteArray &body)
+{
+    return QByteArray("HTTP/1.1 ") + QByteArray::number(status) + (status == 200 ? " OK" : " Not Found")
+            + "\r\nConnection: keep-alive\r\nContent-Type: application/octet-stream\r\nContent-Length: "
+            + QByteArray::number(body.size()) + "\r\n\r\n" + body;
+}
+
+// Takes the complete requests out of the data and returns their bodies
+QList<QByteArray> tst_CHttpTransport::readRequestBodies(QByteArray *data)
+{
+    QList<QByteArray> bodies;
+
+    forever {
+        const int headerEnd = data->indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            break;
+        }
+
+        const QByteArray header = data->left(headerEnd);
+        const QByteArray lengthField("Content-Length: ");
+        const int lengthIndex = header.indexOf(lengthField);
+        if (lengthIndex < 0) {
+            break;
+        }
+
+        const int lengthEnd = header.indexOf("\r\n", lengthIndex);
+        const int length = header.mid(lengthIndex + lengthField.size(), lengthEnd < 0 ? -1 : lengthEnd - lengthIndex - lengthField.size()).toInt();
+
+        if (data->size() < headerEnd + 4 + length) {
+            break;
+        }
+
+        bodies.append(data->mid(headerEnd + 4, length));
+        data->remove(0, headerEnd + 4 + length);
+    }
+
+    return bodies;
+}
+
+void tst_CHttpTransport::pipelining()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    CHttpTransport transport;
+    transport.setPackageCaptureEnabled(true);
+    transport.connectToHost(QStringLiteral("127.0.0.1"), server.serverPort());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *serverSocket = server.nextPendingConnection();
+    QTRY_VERIFY(transport.isConnected());
+
+    QList<QByteArray> payloads;
+    QByteArray expectedData;
+    for (int i = 1; i <= 3; ++i) {
+        payloads.append(QByteArray(i * 16, char(i)));
+        transport.sendPackage(payloads.last());
+        expectedData += transport.lastPackage();
+    }
+
+    QVERIFY(transport.lastPackage().startsWith("POST /api HTTP/1.1\r\n"));
+    QVERIFY(transport.lastPackage().contains("\r\nConnection: keep-alive\r\n"));
+    QVERIFY(transport.lastPackage().contains(QByteArray("\r\nHost: 127.0.0.1:") + QByteArray::number(server.serverPort()) + "\r\n"));
+
+    // All the requests are written without waiting for the answers
+    QCOMPARE(transport.pendingRequestCount(), 3);
+    QTRY_COMPARE(serverSocket->bytesAvailable(), qint64(expectedData.size()));
+
+    QByteArray requests = serverSocket->readAll();
+    QCOMPARE(requests, expectedData);
+    QCOMPARE(readRequestBodies(&requests), payloads);
+    QVERIFY(requests.isEmpty());
+
+    QList<QByteArray> received;
+    connect(&transport, &CTelegramTransport::readyRead, [&transport, &received]() {
+        const QByteArray view = transport.getPackage();
+        received.append(QByteArray(view.constData(), view.size())); // Deep copy
+    });
+
+    QByteArray answers;
+    for (int i = payloads.count() - 1; i >= 0; --i) {
+        answers += response(200, payloads.at(i));
+    }
+
+    // Send the answers in two parts to check partial reads
+    const int splitPosition = answers.size() / 2;
+    serverSocket->write(answers.left(splitPosition));
+    serverSocket->flush();
+    QTRY_COMPARE(received.count(), 1);
+
+    serverSocket->write(answers.mid(splitPosition));
+    QTRY_COMPARE(received.count(), 3);
+
+    QCOMPARE(received.at(0), payloads.at(2));
+    QCOMPARE(received.at(1), payloads.at(1));
+    QCOMPARE(received.at(2), payloads.at(0));
+    QCOMPARE(transport.pendingRequestCount(), 0);
+    QVERIFY(transport.isConnected());
+}
+
+void tst_CHttpTransport::responseStatus()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    CHttpTransport transport;
+    transport.connectToHost(QStringLiteral("127.0.0.1"), server.serverPort());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *serverSocket = server.nextPendingConnection();
+    QTRY_VERIFY(transport.isConnected());
+
+    int receivedCount = 0;
+    connect(&transport, &CTelegramTransport::readyRead, [&receivedCount]() {
+        ++receivedCount;
+    });
+
+    transport.sendPackage(QByteArray(16, char(1)));
+    transport.sendPackage(QByteArray(16, char(2)));
+
+    // An error answer is not passed to the connection, but closes the transport,
+    // so the connection does not wait for the pending answers forever.
+    serverSocket->write(response(404, QByteArray::fromHex("6cfeffff")) + response(200, QByteArray(16, char(2))));
+
+    QTRY_COMPARE(transport.state(), QAbstractSocket::UnconnectedState);
+    QCOMPARE(receivedCount, 0);
+    QCOMPARE(transport.pendingRequestCount(), 0);
+}
+
+QTEST_MAIN(tst_CHttpTransport)
+
+#include "tst_CHttpTransport.moc"
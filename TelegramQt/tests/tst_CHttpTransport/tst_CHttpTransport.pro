@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_httptransport
+SOURCES = tst_CHttpTransport.cpp
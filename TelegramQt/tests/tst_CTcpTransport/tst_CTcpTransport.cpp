@@ -0,0 +1,408 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include <QObject>
+
+#include "CTcpTransport.hpp"
+
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QtEndian>
+#include <QDebug>
+
+#include <zlib.h>
+
+Q_DECLARE_METATYPE(STransportOptions::Framing)
+
+class tst_CTcpTransport : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_CTcpTransport(QObject *parent = 0);
+
+private slots:
+    void framing_data();
+    void framing();
+    void splitPackages_data();
+    void splitPackages();
+    void malformedHeader_data();
+    void malformedHeader();
+    void socketBufferSizes();
+    void writeCoalescing();
+    void sendBufferWatermarks();
+    void queuedPackages();
+
+};
+
+tst_CTcpTransport::tst_CTcpTransport(QObject *parent) :
+    QObject(parent)
+{
+}
+
+// Frames the package as the server does (without the session marker)
+static QByteArray framePackage(STransportOptions::Framing framing, const QByteArray &payload, quint32 packetNumber)
+{
+    QByteArray package;
+    uchar header[8];
+
+    switch (framing) {
+    case STransportOptions::FramingAbridged:
+        if (payload.size() / 4 < 0x7f) {
+            package.append(char(payload.size() / 4));
+        } else {
+            qToLittleEndian<quint32>((payload.size() / 4) << 8 | 0x7f, header);
+            package.append(reinterpret_cast<const char *>(header), 4);
+        }
+        package.append(payload);
+        break;
+    case STransportOptions::FramingIntermediate:
+        qToLittleEndian<quint32>(payload.size(), header);
+        package.append(reinterpret_cast<const char *>(header), 4);
+        package.append(payload);
+        break;
+    case STransportOptions::FramingFull:
+    {
+        qToLittleEndian<quint32>(payload.size() + 12, header);
+        qToLittleEndian<quint32>(packetNumber, header + 4);
+        package.append(reinterpret_cast<const char *>(header), 8);
+        package.append(payload);
+        qToLittleEndian<quint32>(crc32(0, reinterpret_cast<const Bytef *>(package.constData()), package.size()), header);
+        package.append(reinterpret_cast<const char *>(header), 4);
+    }
+        break;
+    }
+
+    return package;
+}
+
+void tst_CTcpTransport::framing_data()
+{
+    QTest::addColumn<STransportOptions::Framing>("framing");
+    QTest::addColumn<int>("payloadSize");
+    QTest::addColumn<int>("headerSize");
+    QTest::addColumn<int>("trailerSize");
+
+    // Header size includes the session marker of the first package
+    QTest::newRow("abridged short") << STransportOptions::FramingAbridged << 64 << 2 << 0;
+    QTest::newRow("abridged long") << STransportOptions::FramingAbridged << 1024 << 5 << 0;
+    QTest::newRow("intermediate") << STransportOptions::FramingIntermediate << 1024 << 8 << 0;
+    QTest::newRow("full") << STransportOptions::FramingFull << 1024 << 8 << 4;
+}
+
+void tst_CTcpTransport::framing()
+{
+    QFETCH(STransportOptions::Framing, framing);
+    QFETCH(int, payloadSize);
+    QFETCH(int, headerSize);
+    QFETCH(int, trailerSize);
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    CTcpTransport transport;
+    transport.setFraming(framing);
+    transport.setPackageCaptureEnabled(true);
+    transport.connectToHost(QStringLiteral("127.0.0.1"), server.serverPort());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *serverSocket = server.nextPendingConnection();
+    QTRY_VERIFY(transport.isConnected());
+
+    QByteArray payload(payloadSize, Qt::Uninitialized);
+    for (int i = 0; i < payload.size(); ++i) {
+        payload[i] = char(i * 7);
+    }
+
+    transport.sendPackage(payload);
+
+    const QByteArray package = transport.lastPackage();
+    QCOMPARE(package.size(), headerSize + payloadSize + trailerSize);
+    QCOMPARE(package.mid(headerSize, payloadSize), payload);
+
+    QTRY_COMPARE(serverSocket->bytesAvailable(), qint64(package.size()));
+    QCOMPARE(serverSocket->readAll(), package);
+
+    QByteArray echo = package;
+
+    switch (framing) {
+    case STransportOptions::FramingAbridged:
+        echo.remove(0, 1); // 0xef marker
+        break;
+    case STransportOptions::FramingIntermediate:
+        echo.remove(0, 4); // 0xeeeeeeee marker
+        break;
+    case STransportOptions::FramingFull:
+    {
+        const quint32 crc = crc32(0, reinterpret_cast<const Bytef *>(package.constData()), package.size() - 4);
+        QCOMPARE(qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(package.constData()) + package.size() - 4), crc);
+    }
+        break;
+    }
+
+    QByteArray received;
+    int receivedCount = 0;
+    bool mutableInPlace = false;
+    connect(&transport, &CTelegramTransport::readyRead, [&transport, &received, &receivedCount, &mutableInPlace]() {
+        const QByteArray view = transport.getPackage();
+        received = QByteArray(view.constData(), view.size()); // Deep copy
+        ++receivedCount;
+
+        // The mutable package must point to the same receive buffer, without a copy
+        int size = 0;
+        const char *data = transport.getMutablePackage(&size);
+        mutableInPlace = (data == view.constData()) && (size == view.size());
+    });
+
+    // Send the echo in two parts to check partial reads
+    serverSocket->write(echo.left(3));
+    serverSocket->flush();
+    QTest::qWait(20);
+    QCOMPARE(receivedCount, 0);
+
+    serverSocket->write(echo.mid(3));
+    QTRY_COMPARE(receivedCount, 1);
+    QCOMPARE(received, payload);
+    QVERIFY(mutableInPlace);
+}
+
+void tst_CTcpTransport::splitPackages_data()
+{
+    QTest::addColumn<STransportOptions::Framing>("framing");
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("abridged, 1 byte chunks") << STransportOptions::FramingAbridged << 1;
+    QTest::newRow("abridged, 7 byte chunks") << STransportOptions::FramingAbridged << 7;
+    QTest::newRow("intermediate, 3 byte chunks") << STransportOptions::FramingIntermediate << 3;
+    QTest::newRow("intermediate, 1000 byte chunks") << STransportOptions::FramingIntermediate << 1000;
+    QTest::newRow("full, 5 byte chunks") << STransportOptions::FramingFull << 5;
+    QTest::newRow("full, 333 byte chunks") << STransportOptions::FramingFull << 333;
+}
+
+void tst_CTcpTransport::splitPackages()
+{
+    QFETCH(STransportOptions::Framing, framing);
+    QFETCH(int, chunkSize);
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    CTcpTransport transport;
+    transport.setFraming(framing);
+    transport.connectToHost(QStringLiteral("127.0.0.1"), server.serverPort());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *serverSocket = server.nextPendingConnection();
+    QTRY_VERIFY(transport.isConnected());
+
+    QList<QByteArray> payloads;
+    QByteArray stream;
+    for (int i = 0; i < 8; ++i) {
+        const QByteArray payload(4 * (1 + i * 97), char('a' + i));
+        payloads.append(payload);
+        stream += framePackage(framing, payload, i);
+    }
+
+    QList<QByteArray> received;
+    connect(&transport, &CTelegramTransport::readyRead, [&transport, &received]() {
+        const QByteArray view = transport.getPackage();
+        received.append(QByteArray(view.constData(), view.size())); // Deep copy
+    });
+
+    for (int offset = 0; offset < stream.size(); offset += chunkSize) {
+        serverSocket->write(stream.mid(offset, chunkSize));
+        serverSocket->flush();
+        // Return to the event loop from time to time, so the data arrives in several readyRead() calls
+        if ((offset / chunkSize) % 16 == 0) {
+            QTest::qWait(1);
+        }
+    }
+
+    QTRY_COMPARE(received.count(), payloads.count());
+    QCOMPARE(received, payloads);
+    QVERIFY(transport.isConnected());
+}
+
+void tst_CTcpTransport::malformedHeader_data()
+{
+    QTest::addColumn<STransportOptions::Framing>("framing");
+    QTest::addColumn<QByteArray>("header");
+
+    QTest::newRow("abridged, invalid first byte") << STransportOptions::FramingAbridged << QByteArray::fromHex("80000000");
+    QTest::newRow("intermediate, oversized") << STransportOptions::FramingIntermediate << QByteArray::fromHex("00000080");
+    QTest::newRow("intermediate, above the limit") << STransportOptions::FramingIntermediate << QByteArray::fromHex("00000004");
+    QTest::newRow("full, oversized") << STransportOptions::FramingFull << QByteArray::fromHex("fcffffff");
+    QTest::newRow("full, too short") << STransportOptions::FramingFull << QByteArray::fromHex("08000000");
+    QTest::newRow("full, not aligned") << STransportOptions::FramingFull << QByteArray::fromHex("0d000000");
+}
+
+void tst_CTcpTransport::malformedHeader()
+{
+    QFETCH(STransportOptions::Framing, framing);
+    QFETCH(QByteArray, header);
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    CTcpTransport transport;
+    transport.setFraming(framing);
+    transport.connectToHost(QStringLiteral("127.0.0.1"), server.serverPort());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *serverSocket = server.nextPendingConnection();
+    QTRY_VERIFY(transport.isConnected());
+
+    QSignalSpy readSpy(&transport, SIGNAL(readyRead()));
+
+    // The data after the header is never interpreted as a package
+    serverSocket->write(header + framePackage(framing, QByteArray(16, 'x'), 0));
+    serverSocket->flush();
+
+    QTRY_VERIFY(!transport.isConnected());
+    QCOMPARE(readSpy.count(), 0);
+}
+
+void tst_CTcpTransport::socketBufferSizes()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    // Below the default net.core.rmem_max/wmem_max, but above the usual initial sizes
+    STransportOptions options;
+    options.receiveBufferSize = 160 * 1024;
+    options.sendBufferSize = 160 * 1024;
+
+    CTcpTransport transport;
+    transport.setOptions(options);
+    transport.connectToHost(QStringLiteral("127.0.0.1"), server.serverPort());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTRY_VERIFY(transport.isConnected());
+
+    // Linux reports the doubled value (it includes the bookkeeping overhead)
+    QVERIFY(transport.socketOption(QAbstractSocket::ReceiveBufferSizeSocketOption).toInt() >= options.receiveBufferSize);
+    QVERIFY(transport.socketOption(QAbstractSocket::SendBufferSizeSocketOption).toInt() >= options.sendBufferSize);
+}
+
+void tst_CTcpTransport::writeCoalescing()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    CTcpTransport transport;
+    transport.setWriteCoalescingEnabled(true);
+    transport.setPackageCaptureEnabled(true);
+    transport.connectToHost(QStringLiteral("127.0.0.1"), server.serverPort());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *serverSocket = server.nextPendingConnection();
+    QTRY_VERIFY(transport.isConnected());
+
+    QByteArray expectedData;
+    for (int i = 1; i <= 3; ++i) {
+        transport.sendPackage(QByteArray(i * 16, char(i)));
+        expectedData += transport.lastPackage();
+    }
+
+    QTRY_COMPARE(serverSocket->bytesAvailable(), qint64(expectedData.size()));
+    QCOMPARE(serverSocket->readAll(), expectedData);
+
+    // Explicit flush writes the pending data without waiting for the event loop
+    transport.sendPackage(QByteArray(16, char(4)));
+    transport.flush();
+    QVERIFY(serverSocket->waitForReadyRead(1000));
+    QCOMPARE(serverSocket->readAll(), transport.lastPackage());
+}
+
+void tst_CTcpTransport::sendBufferWatermarks()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    STransportOptions options;
+    options.sendBufferHighWatermark = 1024;
+    options.sendBufferLowWatermark = 256;
+
+    CTcpTransport transport;
+    transport.setOptions(options);
+    transport.connectToHost(QStringLiteral("127.0.0.1"), server.serverPort());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *serverSocket = server.nextPendingConnection();
+    QTRY_VERIFY(transport.isConnected());
+
+    QSignalSpy spy(&transport, SIGNAL(sendBufferFullChanged(bool)));
+
+    transport.sendPackage(QByteArray(256, char(1)));
+    QVERIFY(!transport.isSendBufferFull());
+    QCOMPARE(spy.count(), 0);
+
+    // The socket buffers the data until the control returns to the event loop
+    transport.sendPackage(QByteArray(4096, char(2)));
+    QVERIFY(transport.bytesToWrite() >= 4096);
+    QVERIFY(transport.isSendBufferFull());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).first().toBool(), true);
+
+    QTRY_VERIFY(!transport.isSendBufferFull());
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).first().toBool(), false);
+    QVERIFY(transport.bytesToWrite() <= options.sendBufferLowWatermark);
+
+    QTRY_VERIFY(serverSocket->bytesAvailable() >= 256 + 4096);
+}
+
+void tst_CTcpTransport::queuedPackages()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    STransportOptions options;
+    options.sendBufferHighWatermark = 1024;
+    options.sendBufferLowWatermark = 256;
+
+    CTcpTransport transport;
+    transport.setOptions(options);
+    transport.connectToHost(QStringLiteral("127.0.0.1"), server.serverPort());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *serverSocket = server.nextPendingConnection();
+    QTRY_VERIFY(transport.isConnected());
+
+    QSignalSpy spy(&transport, SIGNAL(sendBufferFullChanged(bool)));
+
+    // The queued packages are counted until the transport thread sends them
+    QCOMPARE(transport.queuePackage(QByteArray(512, char(1))), 512);
+    QCOMPARE(transport.queuePackage(QByteArray(1024, char(2))), 512 + 1024);
+    QCOMPARE(transport.queuedBytes(), 512 + 1024);
+    QCOMPARE(transport.bytesToWrite(), qint64(0));
+
+    // The first package is sent while the second one is still queued, so the buffer is full at once
+    QTRY_VERIFY(spy.count() >= 1);
+    QCOMPARE(spy.at(0).first().toBool(), true);
+
+    QTRY_VERIFY(!transport.isSendBufferFull());
+    QCOMPARE(transport.queuedBytes(), 0);
+    QCOMPARE(spy.last().first().toBool(), false);
+
+    QTRY_VERIFY(serverSocket->bytesAvailable() >= 512 + 1024);
+}
+
+QTEST_MAIN(tst_CTcpTransport)
+
+#include "tst_CTcpTransport.moc"
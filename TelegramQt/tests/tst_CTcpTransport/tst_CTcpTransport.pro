@@ -0,0 +1,6 @@
+include(../tests.pri)
+
+TARGET = tst_tcptransport
+SOURCES = tst_CTcpTransport.cpp
+
+LIBS += -lz
@@ -16,10 +16,12 @@
  */
 
 #include "CTestConnection.hpp"
+#include "CTelegramTransport.hpp"
 
 CTestConnection::CTestConnection(QObject *parent) :
     CTelegramConnection(0, parent)
 {
+    m_transport->setPackageCaptureEnabled(true);
 }
 
 void CTestConnection::setClientNonce(TLNumber128 newClientNonce)
@@ -62,7 +64,22 @@ SAesKey CTestConnection::testGenerateClientToServerAesKey(const QByteArray &mess
     return generateClientToServerAesKey(messageKey);
 }
 
+void CTestConnection::testGenerateClientToServerAesKey(SFixedAesKey *key, const char *messageKey) const
+{
+    generateClientToServerAesKey(key, messageKey);
+}
+
 quint64 CTestConnection::testNewMessageId()
 {
     return newMessageId();
 }
+
+void CTestConnection::setContentRelatedMessages(quint32 count)
+{
+    m_contentRelatedMessages = count;
+}
+
+quint64 CTestConnection::testSendEncryptedPackage(const QByteArray &buffer)
+{
+    return sendEncryptedPackage(buffer, /* savePackage */ false);
+}
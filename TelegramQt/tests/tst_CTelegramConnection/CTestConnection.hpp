@@ -26,8 +26,6 @@ class CTestConnection : public CTelegramConnection
 public:
     explicit CTestConnection(QObject *parent = 0);
 
-    inline CTelegramTransport *transport() const { return m_transport; }
-
     void setClientNonce(TLNumber128 newClientNonce);
     void setServerNonce(TLNumber128 newServerNonce);
     void setNewNonce(TLNumber256 newNewNonce);
@@ -37,7 +35,10 @@ public:
     void setB(const QByteArray &newB);
 
     SAesKey testGenerateClientToServerAesKey(const QByteArray &messageKey) const;
+    void testGenerateClientToServerAesKey(SFixedAesKey *key, const char *messageKey) const;
     quint64 testNewMessageId();
+    void setContentRelatedMessages(quint32 count);
+    quint64 testSendEncryptedPackage(const QByteArray &buffer);
 
 };
 
@@ -19,11 +19,64 @@
 
 #include "CTestConnection.hpp"
 #include "CTelegramTransport.hpp"
+#include "Utils.hpp"
 
 #include <QTest>
 #include <QDebug>
 
 #include <QDateTime>
+#include <QtEndian>
+
+#if defined(__GLIBC__)
+// Counts the heap allocations of the whole process. QByteArray data is allocated with malloc()/realloc().
+#define ALLOCATION_COUNTING_ENABLED
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+static QBasicAtomicInt s_allocationCount = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+// The allocations of at least this size are counted separately, as copies of the payload
+static const size_t s_payloadAllocationSize = 1024;
+static QBasicAtomicInt s_payloadAllocationCount = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+static void countAllocation(size_t size)
+{
+    s_allocationCount.ref();
+    if (size >= s_payloadAllocationSize) {
+        s_payloadAllocationCount.ref();
+    }
+}
+
+extern "C" void *malloc(size_t size)
+{
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+#endif
+
+// Keeps the sent packages as is, without any framing
+class CCapturingTransport : public CTelegramTransport
+{
+public:
+    void connectToHost(const QString &ipAddress, quint32 port) { Q_UNUSED(ipAddress) Q_UNUSED(port) }
+    void disconnectFromHost() { }
+    bool isConnected() const { return true; }
+    QByteArray getPackage() { return QByteArray(); }
+    QByteArray lastPackage() const { return m_lastPackage; }
+
+    void sendPackage(const QByteArray &package) { m_lastPackage = package; }
+
+private:
+    QByteArray m_lastPackage;
+
+};
 
 class tst_CTelegramConnection : public QObject
 {
@@ -39,6 +92,8 @@ private slots:
     void testPQAuthRequest();
     void testAuth();
     void testAesKeyGeneration();
+    void testEncryptedPackage();
+    void testEncryptedPackageAllocations();
 
 };
 
@@ -381,6 +436,89 @@ void tst_CTelegramConnection::testAesKeyGeneration()
 
     QCOMPARE(result.key, aesKeyArray);
     QCOMPARE(result.iv , aesIvArray);
+
+    SFixedAesKey fixedResult;
+    core.testGenerateClientToServerAesKey(&fixedResult, messageKeyArray.constData());
+
+    QCOMPARE(QByteArray((const char *) fixedResult.key, 32), aesKeyArray);
+    QCOMPARE(QByteArray((const char *) fixedResult.iv, 32), aesIvArray);
+}
+
+void tst_CTelegramConnection::testEncryptedPackage()
+{
+    QByteArray authKey(256, Qt::Uninitialized);
+    Utils::randomBytes(&authKey);
+
+    CTestConnection connection;
+    CCapturingTransport *transport = new CCapturingTransport();
+    connection.setTransport(transport);
+    connection.setAuthKey(authKey);
+    connection.setContentRelatedMessages(1); // Skip the initConnection header
+
+    for (int payloadLength = 4; payloadLength <= 64; payloadLength += 4) {
+        QByteArray payload(payloadLength, Qt::Uninitialized);
+        Utils::randomBytes(&payload);
+
+        const quint64 messageId = connection.testSendEncryptedPackage(payload);
+        const QByteArray package = transport->lastPackage();
+
+        QCOMPARE((package.size() - 24) % 16, 0);
+        QCOMPARE(qFromLittleEndian<quint64>(reinterpret_cast<const uchar *>(package.constData())), connection.authId());
+
+        const QByteArray messageKey = package.mid(8, 16);
+        const QByteArray decrypted = Utils::aesDecrypt(package.mid(24), connection.testGenerateClientToServerAesKey(messageKey));
+        const uchar *decryptedData = reinterpret_cast<const uchar *>(decrypted.constData());
+
+        QCOMPARE(qFromLittleEndian<quint64>(decryptedData + 16), messageId);
+        QCOMPARE(qFromLittleEndian<quint32>(decryptedData + 28), quint32(payloadLength));
+        QCOMPARE(decrypted.mid(32, payloadLength), payload);
+        QCOMPARE(Utils::sha1(decrypted.left(32 + payloadLength)).mid(4), messageKey);
+    }
+}
+
+void tst_CTelegramConnection::testEncryptedPackageAllocations()
+{
+#ifndef ALLOCATION_COUNTING_ENABLED
+    QSKIP("Allocation counting is not supported on this platform");
+#else
+    QByteArray authKey(256, Qt::Uninitialized);
+    Utils::randomBytes(&authKey);
+
+    CTestConnection connection;
+    CCapturingTransport *transport = new CCapturingTransport();
+    connection.setTransport(transport);
+    connection.setAuthKey(authKey);
+    connection.setContentRelatedMessages(1);
+
+    const QByteArray payload(s_payloadAllocationSize, 'x');
+
+    // Warm up the lazily initialized OpenSSL state
+    connection.testSendEncryptedPackage(payload);
+
+    int allocationsBefore = s_allocationCount.load();
+    const int payloadAllocationsBefore = s_payloadAllocationCount.load();
+    connection.testSendEncryptedPackage(payload);
+    const int singleSendAllocations = s_allocationCount.load() - allocationsBefore;
+    const int singleSendPayloadAllocations = s_payloadAllocationCount.load() - payloadAllocationsBefore;
+
+    static const int sendCount = 16;
+    allocationsBefore = s_allocationCount.load();
+    for (int i = 0; i < sendCount; ++i) {
+        connection.testSendEncryptedPackage(payload);
+    }
+    const int allocations = s_allocationCount.load() - allocationsBefore;
+
+    // The payload is copied once, into the package, which goes to the transport as is
+    QCOMPARE(singleSendPayloadAllocations, 1);
+
+    // The other allocations are the saved package entry and, on OpenSSL 3, a small digest state
+    // on each hash reinitialization (the message key and four for the AES key).
+    static const int digestsPerSend = 5;
+    QVERIFY(singleSendAllocations >= 1);
+    QVERIFY(singleSendAllocations <= 2 + digestsPerSend);
+    QCOMPARE(allocations, singleSendAllocations * sendCount);
+    QCOMPARE(transport->lastPackage().size(), 24 + 32 + int(s_payloadAllocationSize));
+#endif
 }
 
 QTEST_MAIN(tst_CTelegramConnection)
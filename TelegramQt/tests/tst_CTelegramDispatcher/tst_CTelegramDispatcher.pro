@@ -4,9 +4,13 @@ TARGET = tst_telegramdispatcher
 SOURCES = tst_CTelegramDispatcher.cpp \
     CTestDispatcher.cpp \
     ../../Utils.cpp \
+    ../../CAesIgeCipher.cpp \
     ../../TelegramUtils.cpp \
     ../../CTcpTransport.cpp \
+    ../../CHttpTransport.cpp \
     ../../CTelegramConnection.cpp \
+    ../../CTempAuthKeyManager.cpp \
+    ../../CAuthKeyGenerator.cpp \
     ../../CTelegramStream.cpp \
     ../../CTelegramDispatcher.cpp \
     ../../CRawStream.cpp \
@@ -15,10 +19,14 @@ SOURCES = tst_CTelegramDispatcher.cpp \
 HEADERS += \
     CTestDispatcher.hpp \
     ../../Utils.hpp \
+    ../../CAesIgeCipher.hpp \
     ../../TelegramUtils.hpp \
     ../../CTelegramConnection.hpp \
+    ../../CTempAuthKeyManager.hpp \
+    ../../CAuthKeyGenerator.hpp \
     ../../CTelegramTransport.hpp \
     ../../CTcpTransport.hpp \
+    ../../CHttpTransport.hpp \
     ../../CTelegramStream.hpp \
     ../../CTelegramDispatcher.hpp \
     ../../CRawStream.hpp \
@@ -45,6 +45,13 @@ private slots:
     void tlNumbersSerialization();
     void tlDcOptionDeserialization();
     void readError();
+    void memorySerialization();
+    void rawDataReadBytes();
+    void serializedSize();
+    void readBenchmark_data();
+    void readBenchmark();
+    void nestedVectorReadBenchmark();
+    void dcOptionsReadBenchmark();
 
 };
 
@@ -473,6 +480,226 @@ void tst_CTelegramStream::readError()
 
 }
 
+void tst_CTelegramStream::memorySerialization()
+{
+    const QByteArray encoded = QByteArray::fromHex("efbeadde0807060504030201ff");
+
+    QByteArray output;
+    {
+        CTelegramStream stream(&output, /* write */ true);
+        stream << quint32(0xdeadbeef);
+        stream << quint64(0x0102030405060708ull);
+        stream << quint8(0xff);
+        QVERIFY(!stream.error());
+    }
+    QCOMPARE(output, encoded);
+
+    // Span mode: the data is read in place
+    CTelegramStream stream(encoded.constData(), encoded.size());
+
+    quint32 value32 = 0;
+    quint64 value64 = 0;
+    stream >> value32;
+    stream >> value64;
+
+    QCOMPARE(value32, quint32(0xdeadbeef));
+    QCOMPARE(value64, quint64(0x0102030405060708ull));
+    QCOMPARE(stream.bytesRemaining(), 1);
+    QVERIFY(!stream.atEnd());
+    QVERIFY(!stream.error());
+
+    // Out of bounds read
+    stream >> value32;
+    QVERIFY(stream.error());
+    QVERIFY(stream.atEnd());
+    QCOMPARE(stream.bytesRemaining(), 0);
+
+    // Writing to a read-only stream is an error as well
+    CTelegramStream readOnlyStream(encoded);
+    readOnlyStream << quint32(0);
+    QVERIFY(readOnlyStream.error());
+}
+
+void tst_CTelegramStream::rawDataReadBytes()
+{
+    const QByteArray expected = QByteArray::fromHex("0102030405060708");
+    QByteArray result;
+    QByteArray sharedResult;
+
+    {
+        QByteArray source(expected.constData(), expected.size()); // Deep copy
+        CTelegramStream stream(QByteArray::fromRawData(source.constData(), source.size()));
+        result = stream.readRemainingBytes();
+        QVERIFY(!stream.error());
+
+        // The data of an owning array is shared
+        const QByteArray owned = expected;
+        CTelegramStream ownedStream(owned);
+        sharedResult = ownedStream.readRemainingBytes();
+        QCOMPARE(sharedResult.constData(), owned.constData());
+
+        source.fill(char(0));
+    }
+
+    // The result of the raw data stream is a copy, which survives the source buffer
+    QCOMPARE(result, expected);
+    QCOMPARE(sharedResult, expected);
+}
+
+void tst_CTelegramStream::serializedSize()
+{
+    const QByteArray utf16Emoji = QByteArray::fromHex("3dd800de");
+    const QList<QString> strings = QList<QString>()
+            << QString()
+            << QLatin1String("test")
+            << QString::fromUtf8("\xd1\x82\xd0\xb5\xd1\x81\xd1\x82")
+            << QString::fromUtf16(reinterpret_cast<const ushort *>(utf16Emoji.constData()), 2)
+            << QString(300, QLatin1Char('x'));
+
+    foreach (const QString &str, strings) {
+        QByteArray output;
+        CTelegramStream stream(&output, /* write */ true);
+        stream << str;
+        QCOMPARE(CTelegramStream::serializedSize(str), output.size());
+    }
+
+    for (int length : { 0, 1, 3, 4, 253, 254, 255, 1024 }) {
+        const QByteArray data(length, 'x');
+        QByteArray output;
+        CTelegramStream stream(&output, /* write */ true);
+        stream << data;
+        QCOMPARE(CTelegramStream::serializedSize(data), output.size());
+    }
+
+    {
+        TLInputUser user;
+        user.tlType = TLValue::InputUser;
+        user.userId = 1;
+        user.accessHash = 2;
+
+        TLVector<TLInputUser> users;
+        users.append(user);
+        users.append(TLInputUser());
+
+        QByteArray output;
+        CTelegramStream stream(&output, /* write */ true);
+        stream << users;
+        QCOMPARE(CTelegramStream::serializedSize(user), 4 + 4 + 8);
+        QCOMPARE(CTelegramStream::serializedSize(users), output.size());
+    }
+}
+
+void tst_CTelegramStream::readBenchmark_data()
+{
+    QTest::addColumn<bool>("memory");
+
+    QTest::newRow("QIODevice") << false;
+    QTest::newRow("memory") << true;
+}
+
+void tst_CTelegramStream::readBenchmark()
+{
+    QFETCH(bool, memory);
+
+    static const int valuesCount = 4096;
+
+    QByteArray data;
+    {
+        CTelegramStream stream(&data, /* write */ true);
+        for (int i = 0; i < valuesCount; ++i) {
+            stream << TLValue::Vector;
+            stream << quint64(i);
+        }
+    }
+
+    quint64 sum = 0;
+    auto readValues = [&sum](CTelegramStream &stream) {
+        TLValue value;
+        quint64 number;
+        for (int i = 0; i < valuesCount; ++i) {
+            stream >> value;
+            stream >> number;
+            sum += number;
+        }
+        return !stream.error();
+    };
+
+    QBENCHMARK {
+        if (memory) {
+            CTelegramStream stream(data);
+            QVERIFY(readValues(stream));
+        } else {
+            QBuffer device;
+            device.setData(data);
+            device.open(QBuffer::ReadOnly);
+
+            CTelegramStream stream(&device);
+            QVERIFY(readValues(stream));
+        }
+    }
+
+    QVERIFY(sum > 0);
+}
+
+void tst_CTelegramStream::nestedVectorReadBenchmark()
+{
+    TLVector<TLKeyboardButtonRow> rows;
+    for (int i = 0; i < 64; ++i) {
+        TLKeyboardButtonRow row;
+        for (int j = 0; j < 8; ++j) {
+            TLKeyboardButton button;
+            button.text = QString(QLatin1String("Button %1.%2")).arg(i).arg(j);
+            row.buttons.append(button);
+        }
+        rows.append(row);
+    }
+
+    QByteArray data;
+    {
+        CTelegramStream stream(&data, /* write */ true);
+        stream << rows;
+    }
+
+    TLVector<TLKeyboardButtonRow> result;
+
+    QBENCHMARK {
+        CTelegramStream stream(data);
+        stream >> result;
+    }
+
+    QCOMPARE(result.count(), rows.count());
+    QCOMPARE(result.last().buttons.count(), 8);
+    QCOMPARE(result.last().buttons.last().text, rows.last().buttons.last().text);
+}
+
+void tst_CTelegramStream::dcOptionsReadBenchmark()
+{
+    TLVector<TLDcOption> options;
+    for (int i = 0; i < 256; ++i) {
+        TLDcOption option;
+        option.id = i;
+        option.ipAddress = QString(QLatin1String("10.0.%1.%2")).arg(i / 256).arg(i % 256);
+        option.port = 443;
+        options.append(option);
+    }
+
+    QByteArray data;
+    {
+        CTelegramStream stream(&data, /* write */ true);
+        stream << options;
+    }
+
+    TLVector<TLDcOption> result;
+
+    QBENCHMARK {
+        CTelegramStream stream(data);
+        stream >> result;
+    }
+
+    QCOMPARE(result.count(), options.count());
+    QCOMPARE(result.last().ipAddress, options.last().ipAddress);
+}
+
 QTEST_APPLESS_MAIN(tst_CTelegramStream)
 
 #include "tst_CTelegramStream.moc"
@@ -0,0 +1,250 @@
+/*
+   Copyright (C) 2016 Alexandr Akulich <akulichalexander@gmail.com>
+
+   This file is a part of TelegramQt library.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+ */
+
+#include <QObject>
+
+#include "Utils.hpp"
+
+#include <QSet>
+#include <QtEndian>
+#include <QTest>
+#include <QDebug>
+
+// 2048-bit safe prime, which is used by the Telegram servers.
+static const QByteArray s_dhPrime("c71caeb9c6b1c9048e6c522f70f13f73980d40238e3e21c14934d037563d930f"
+                                  "48198a0aa7c14058229493d22530f4dbfa336f6e0ac925139543aed44cce7c37"
+                                  "20fd51f69458705ac68cd4fe6b6b13abdc9746512969328454f18faf8c595f64"
+                                  "2477fe96bb2a941d5bcd1d4ac8cc49880708fa9b378e3c4f3a9060bee67cf9a4"
+                                  "a4a695811051907e162753b56b0f6b410dba74d8a84b2a14b3144e0ef1284754"
+                                  "fd17ed950d5965b4b9dd46582db1178d169c6bc465b0d6ff9ca3928fef5b9ae4"
+                                  "e418fc15e83ebea0f87fa9ff5eed70050ded2849f47bf959d956850ce929851f"
+                                  "0d8115f635b105ee2e4e15d04b2454bf6f4fadf034b10403119cd8e3b92fcc5b");
+
+class tst_Utils : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_Utils(QObject *parent = 0);
+
+private slots:
+    void findDivider_data();
+    void findDivider();
+    void findDividerBenchmark_data();
+    void findDividerBenchmark();
+    void checkDhParameters_data();
+    void checkDhParameters();
+    void dhPrimeCacheData();
+    void checkDhParametersBenchmark();
+    void binaryNumberModExp_data();
+    void binaryNumberModExp();
+    void randomBytes();
+    void randomPaddingBenchmark();
+
+};
+
+tst_Utils::tst_Utils(QObject *parent) :
+    QObject(parent)
+{
+}
+
+void tst_Utils::findDivider_data()
+{
+    QTest::addColumn<quint64>("pq");
+    QTest::addColumn<quint64>("p");
+
+    // Products of two 31..32 bit primes, which is the form of the pq from the servers
+    QTest::newRow("documentation") << Q_UINT64_C(0x17ed48941a08f981) << Q_UINT64_C(1229739323);
+    QTest::newRow("pq1") << Q_UINT64_C(0x4a91085ff7ec906d) << Q_UINT64_C(2283831857);
+    QTest::newRow("pq2") << Q_UINT64_C(0x7037aaa195795bb7) << Q_UINT64_C(2052309367);
+    QTest::newRow("pq3") << Q_UINT64_C(0x67393ef41e600511) << Q_UINT64_C(2607825631);
+    QTest::newRow("pq4") << Q_UINT64_C(0x479e61d1710559b5) << Q_UINT64_C(1206805759);
+    QTest::newRow("pq5") << Q_UINT64_C(0x58c0449a501e8e5d) << Q_UINT64_C(1698764789);
+    QTest::newRow("pq6") << Q_UINT64_C(0x5d46ca6ce191df15) << Q_UINT64_C(1858877929);
+    QTest::newRow("pq7") << Q_UINT64_C(0x5cac7e76fe43a34b) << Q_UINT64_C(2446524937);
+    QTest::newRow("pq8") << Q_UINT64_C(0x4fb017cac963b1a9) << Q_UINT64_C(1827159781);
+}
+
+void tst_Utils::findDivider()
+{
+    QFETCH(quint64, pq);
+    QFETCH(quint64, p);
+
+    const quint64 q = pq / p;
+    const quint64 divider = Utils::findDivider(pq);
+
+    QVERIFY2((divider == p) || (divider == q), QByteArray::number(divider).constData());
+    QCOMPARE(Utils::findDivider(pq), divider); // Deterministic
+}
+
+void tst_Utils::findDividerBenchmark_data()
+{
+    findDivider_data();
+}
+
+void tst_Utils::findDividerBenchmark()
+{
+    QFETCH(quint64, pq);
+
+    quint64 divider = 0;
+    QBENCHMARK {
+        divider = Utils::findDivider(pq);
+    }
+
+    QVERIFY(divider > 1);
+    QCOMPARE(pq % divider, quint64(0));
+}
+
+void tst_Utils::checkDhParameters_data()
+{
+    QTest::addColumn<QByteArray>("prime");
+    QTest::addColumn<quint32>("g");
+    QTest::addColumn<bool>("valid");
+
+    const QByteArray prime = QByteArray::fromHex(s_dhPrime);
+    QByteArray notPrime = prime;
+    notPrime[notPrime.size() - 1] = notPrime.at(notPrime.size() - 1) + 2;
+
+    // The prime is 2 mod 3, 3 mod 8, 3 mod 5, 11 mod 24 and 6 mod 7
+    QTest::newRow("g3") << prime << quint32(3) << true;
+    QTest::newRow("g4") << prime << quint32(4) << true;
+    QTest::newRow("g7") << prime << quint32(7) << true;
+    QTest::newRow("g2") << prime << quint32(2) << false;
+    QTest::newRow("g5") << prime << quint32(5) << false;
+    QTest::newRow("g6") << prime << quint32(6) << false;
+    QTest::newRow("g out of range") << prime << quint32(8) << false;
+    QTest::newRow("short prime") << prime.mid(1) << quint32(3) << false;
+    QTest::newRow("not a prime") << notPrime << quint32(3) << false;
+}
+
+void tst_Utils::checkDhParameters()
+{
+    QFETCH(QByteArray, prime);
+    QFETCH(quint32, g);
+    QFETCH(bool, valid);
+
+    QCOMPARE(Utils::checkDhParameters(prime, g), valid);
+    QCOMPARE(Utils::checkDhParameters(prime, g), valid); // Cached
+}
+
+void tst_Utils::dhPrimeCacheData()
+{
+    const QByteArray prime = QByteArray::fromHex(s_dhPrime);
+    QVERIFY(Utils::checkDhParameters(prime, 3));
+
+    const QByteArray data = Utils::dhPrimeCacheData();
+    QCOMPARE(data.size(), 4 + 4 + prime.size());
+    QVERIFY(data.contains(prime));
+
+    QVERIFY(Utils::setDhPrimeCacheData(data));
+    QCOMPARE(Utils::dhPrimeCacheData(), data);
+
+    QVERIFY(!Utils::setDhPrimeCacheData(data.left(data.size() - 1)));
+    QVERIFY(!Utils::setDhPrimeCacheData(QByteArray()));
+
+    // An invalid entry rejects the whole data, the valid entries before it are not added
+    QByteArray otherPrime = prime;
+    otherPrime[otherPrime.size() - 1] = otherPrime.at(otherPrime.size() - 1) + 2;
+    QByteArray invalidPrime = prime;
+    invalidPrime[0] = char(0);
+
+    QByteArray invalidData(4, Qt::Uninitialized);
+    qToLittleEndian<quint32>(2, (uchar *) invalidData.data());
+    invalidData += QByteArray::fromHex("08000000") + otherPrime;
+    invalidData += QByteArray::fromHex("08000000") + invalidPrime;
+
+    QVERIFY(!Utils::setDhPrimeCacheData(invalidData));
+    QCOMPARE(Utils::dhPrimeCacheData(), data);
+}
+
+void tst_Utils::checkDhParametersBenchmark()
+{
+    const QByteArray prime = QByteArray::fromHex(s_dhPrime);
+    QVERIFY(Utils::checkDhParameters(prime, 3));
+
+    bool valid = false;
+    QBENCHMARK {
+        valid = Utils::checkDhParameters(prime, 3);
+    }
+
+    QVERIFY(valid);
+}
+
+void tst_Utils::binaryNumberModExp_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<QByteArray>("exponent");
+    QTest::addColumn<QByteArray>("result");
+
+    const QByteArray prime = QByteArray::fromHex(s_dhPrime);
+
+    QByteArray one(prime.size(), char(0));
+    one[one.size() - 1] = char(1);
+    QByteArray twoPow8(prime.size(), char(0));
+    twoPow8[twoPow8.size() - 2] = char(1);
+
+    QTest::newRow("one") << QByteArray(1, char(1)) << QByteArray(1, char(5)) << one;
+    QTest::newRow("short result") << QByteArray(1, char(2)) << QByteArray(1, char(8)) << twoPow8;
+    QTest::newRow("zero exponent") << prime.mid(1) << QByteArray(1, char(0)) << one;
+}
+
+void tst_Utils::binaryNumberModExp()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(QByteArray, exponent);
+    QFETCH(QByteArray, result);
+
+    const QByteArray prime = QByteArray::fromHex(s_dhPrime);
+
+    // The result has the modulus size, the leading zero bytes are kept
+    QCOMPARE(Utils::binaryNumberModExp(data, prime, exponent), result);
+}
+
+void tst_Utils::randomBytes()
+{
+    // The pool is refilled many times, the requests cross the buffer boundary
+    QSet<QByteArray> values;
+    for (int i = 0; i < 1000; ++i) {
+        QByteArray value(15, char(0));
+        QCOMPARE(Utils::randomBytes(&value), 1);
+        values.insert(value);
+    }
+    QCOMPARE(values.count(), 1000);
+
+    // Large requests bypass the pool
+    QByteArray largeValue(8192, char(0));
+    QCOMPARE(Utils::randomBytes(&largeValue), 1);
+    QVERIFY(largeValue != QByteArray(8192, char(0)));
+
+    quint64 number1 = 0;
+    quint64 number2 = 0;
+    Utils::randomBytes(&number1);
+    Utils::randomBytes(&number2);
+    QVERIFY(number1 != number2);
+}
+
+void tst_Utils::randomPaddingBenchmark()
+{
+    char padding[16];
+
+    QBENCHMARK {
+        Utils::randomBytes(padding, 12);
+    }
+}
+
+QTEST_MAIN(tst_Utils)
+
+#include "tst_Utils.moc"
@@ -0,0 +1,4 @@
+include(../tests.pri)
+
+TARGET = tst_utils
+SOURCES = tst_Utils.cpp
@@ -13,6 +13,7 @@ URL: https://github.com/Kaffeine/telegram-qt
 Source0: https://github.com/Kaffeine/telegram-qt/releases/download/telegram-qt-%{version}/telegram-qt-%{version}.tar.bz2
 BuildRequires: pkgconfig(Qt5Core)
 BuildRequires: pkgconfig(Qt5Network)
+BuildRequires: pkgconfig(Qt5Concurrent)
 BuildRequires: pkgconfig(Qt5Qml)
 BuildRequires: pkgconfig(openssl)
 BuildRequires: cmake >= 2.8
@@ -27,6 +28,7 @@ Requires(post): /sbin/ldconfig
 Requires(postun): /sbin/ldconfig
 Requires: qt5-qtcore
 Requires: qt5-qtnetwork
+Requires: qt5-qtconcurrent
 Requires: openssl
 
 %description qt5